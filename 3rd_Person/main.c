@@ -12,6 +12,9 @@
 #define ANIM_ATTACK 1
 #define ANIM_WALK 2
 
+// Seconds player clip switches blend over
+#define ANIM_FADE_TIME 0.2f
+
 bool running = true;
 
 // Player variables
@@ -34,7 +37,7 @@ bool spiderAnimSet = false;
 float cameraDistance = 4.0f;
 float cameraHeight = 8.0f;
 
-void updateController(float dt, DMSModel* playerModel) {
+void updateController(float dt, DMSInstance* player) {
     if (IsGamepadButtonPressed(0, GAMEPAD_BUTTON_MIDDLE_RIGHT)) 
         running = false;
     
@@ -69,12 +72,13 @@ void updateController(float dt, DMSModel* playerModel) {
     if (IsGamepadButtonPressed(0, GAMEPAD_BUTTON_RIGHT_FACE_DOWN)) {
         if (!isAttacking) {
             isAttacking = true;
-            SetDMSModelAnimation(playerModel, ANIM_ATTACK);
+            CrossFadeDMSInstanceAnimation(player, ANIM_ATTACK, ANIM_FADE_TIME);
             currentAnimIndex = ANIM_ATTACK;
             
             // Get the actual duration of the attack animation
-            if (playerModel->skeleton && playerModel->skeleton->animCount > ANIM_ATTACK) {
-                attackTimer = playerModel->skeleton->animations[ANIM_ATTACK].duration;
+            DMSSkeleton* skeleton = player->model->skeleton;
+            if (skeleton && skeleton->animCount > ANIM_ATTACK) {
+                attackTimer = skeleton->animations[ANIM_ATTACK].duration;
             } else {
                 attackTimer = 1.0f; // fallback
             }
@@ -88,10 +92,10 @@ void updateController(float dt, DMSModel* playerModel) {
             isAttacking = false;
             // After attack ends, set appropriate animation
             if (isMoving) {
-                SetDMSModelAnimation(playerModel, ANIM_WALK);
+                CrossFadeDMSInstanceAnimation(player, ANIM_WALK, ANIM_FADE_TIME);
                 currentAnimIndex = ANIM_WALK;
             } else {
-                SetDMSModelAnimation(playerModel, ANIM_IDLE);
+                CrossFadeDMSInstanceAnimation(player, ANIM_IDLE, ANIM_FADE_TIME);
                 currentAnimIndex = ANIM_IDLE;
             }
         }
@@ -100,25 +104,23 @@ void updateController(float dt, DMSModel* playerModel) {
     // Update animation based on state (only if not attacking)
     if (!isAttacking) {
         if (isMoving && currentAnimIndex != ANIM_WALK) {
-            SetDMSModelAnimation(playerModel, ANIM_WALK);
+            CrossFadeDMSInstanceAnimation(player, ANIM_WALK, ANIM_FADE_TIME);
             currentAnimIndex = ANIM_WALK;
         } else if (!isMoving && currentAnimIndex != ANIM_IDLE) {
-            SetDMSModelAnimation(playerModel, ANIM_IDLE);
+            CrossFadeDMSInstanceAnimation(player, ANIM_IDLE, ANIM_FADE_TIME);
             currentAnimIndex = ANIM_IDLE;
         }
     }
 }
 
-void updateSpider(float dt, DMSModel* spiderModel) {
+void updateSpider(float dt, DMSInstance* spider) {
     // Set animation to walk once at the beginning
     if (!spiderAnimSet) {
         printf("Setting spider to animation 4 (walk)\n");
-        SetDMSModelAnimation(spiderModel, 4);  // Walk is index 4
+        SetDMSInstanceAnimation(spider, 4);  // Walk is index 4
         spiderAnimSet = true;
         
-        if (spiderModel->skeleton) {
-            printf("Spider currentAnim after setting: %d\n", spiderModel->skeleton->currentAnim);
-        }
+        printf("Spider currentAnim after setting: %d\n", GetDMSInstanceAnimation(spider));
     }
     
     // Simple back and forth movement
@@ -136,13 +138,8 @@ void updateSpider(float dt, DMSModel* spiderModel) {
         }
     }
     
-    UpdateDMSModelAnimation(spiderModel, dt);
-    
-    if (spiderModel->skeleton) {
-        for (int m = 0; m < spiderModel->meshCount; m++) {
-            UpdateDMSMeshAnimation(&spiderModel->meshes[m], spiderModel->skeleton);
-        }
-    }
+    UpdateDMSInstanceAnimation(spider, dt);
+    UpdateDMSInstanceSkinning(spider);
 }
 
 int main(int argc, char **argv) {
@@ -182,8 +179,17 @@ int main(int argc, char **argv) {
     int spiderAnimCount = GetDMSModelAnimationCount(spiderModel);
     printf("Spider model has %d animations\n", spiderAnimCount);
     
-     
-    SetDMSModelAnimation(playerModel, ANIM_IDLE);
+
+    // Pose and skinned vertices live in the instances; the models stay shared
+    DMSInstance* player = CreateDMSInstance(playerModel);
+    DMSInstance* spider = CreateDMSInstance(spiderModel);
+    SetDMSInstanceAnimation(player, ANIM_IDLE);
+
+    // Clips load on first use; read the ones gameplay switches to now rather
+    // than on the first button press
+    PrefetchDMSModelAnimation(playerModel, ANIM_WALK);
+    PrefetchDMSModelAnimation(playerModel, ANIM_ATTACK);
+    PrefetchDMSModelAnimation(spiderModel, 4);  // Walk
 
     Camera3D camera = { 0 };
     camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
@@ -198,22 +204,7 @@ int main(int argc, char **argv) {
         float dt = GetFrameTime();
         frameCounter++;
         
-        updateController(dt, playerModel);
-        updateSpider(dt, spiderModel);
-
-        // Update player animations
-        UpdateDMSModelAnimation(playerModel, dt);
-        
-        // Update animated vertex positions for player
-        if (playerModel->skeleton) {
-            for (int m = 0; m < playerModel->meshCount; m++) {
-                UpdateDMSMeshAnimation(&playerModel->meshes[m], playerModel->skeleton);
-            }
-        }
-        
-         if (frameCounter % 60 == 0 && spiderModel->skeleton) {
-            printf("Frame %d: Spider anim = %d\n", frameCounter, spiderModel->skeleton->currentAnim);
-        }
+        updateController(dt, player);
 
         camera.position = (Vector3){
             playerPos.x + cameraDistance,
@@ -227,6 +218,34 @@ int main(int argc, char **argv) {
             playerPos.z
         };
 
+        // Animation LOD from where the models are drawn below: a far or
+        // off-screen spider updates and skins less often
+        Matrix viewProjection = MatrixMultiply(GetCameraMatrix(camera),
+            MatrixPerspective(camera.fovy * DEG2RAD, (double)SCREEN_WIDTH / SCREEN_HEIGHT, 0.01, 1000.0));
+        float playerDrawYaw = isAttacking ? playerYaw - 90.0f : playerYaw;
+        Matrix playerTransform = MatrixMultiply(MatrixMultiply(MatrixRotateX(90.0f * DEG2RAD),
+            MatrixScale(0.15f, 0.15f, 0.15f)), MatrixRotateY(playerDrawYaw * DEG2RAD));
+        playerTransform = MatrixMultiply(playerTransform, MatrixTranslate(playerPos.x, playerPos.y, playerPos.z));
+        Matrix spiderTransform = MatrixMultiply(MatrixMultiply(MatrixScale(0.8f, 0.8f, 0.8f),
+            MatrixRotateY(spiderYaw * DEG2RAD)), MatrixTranslate(spiderPos.x, spiderPos.y, spiderPos.z));
+        UpdateDMSInstanceLOD(player, playerTransform, viewProjection);
+        UpdateDMSInstanceLOD(spider, spiderTransform, viewProjection);
+
+        updateSpider(dt, spider);
+
+        // Update player animations
+        UpdateDMSInstanceAnimation(player, dt);
+        
+        // Update animated vertex positions for player
+        UpdateDMSInstanceSkinning(player);
+        
+         if (frameCounter % 60 == 0) {
+            printf("Frame %d: Spider anim = %d, LOD %d, skinned %u of %u frames\n", frameCounter,
+                   GetDMSInstanceAnimation(spider), spider->lod.level, spider->lod.skinningPasses,
+                   spider->lod.skinningPasses + spider->lod.skinningSkipped);
+            ResetDMSInstanceLODStats(spider);
+        }
+
         BeginDrawing();
         ClearBackground(SKYBLUE);
         BeginMode3D(camera);
@@ -244,14 +263,14 @@ int main(int argc, char **argv) {
         
         glScalef(0.15f, 0.15f, 0.15f);
         glRotatef(90, 1, 0, 0);
-        RenderDMSModel(playerModel, (Vector3){0, 0, 0}, 1.0f, WHITE);
+        RenderDMSInstance(player, (Vector3){0, 0, 0}, 1.0f, WHITE);
         glPopMatrix();
 
         glPushMatrix();
         glTranslatef(spiderPos.x, spiderPos.y, spiderPos.z);
         glRotatef(spiderYaw, 0, 1, 0);  
         glScalef(0.8f, 0.8f, 0.8f);
-        RenderDMSModel(spiderModel, (Vector3){0, 0, 0}, 1.0f, WHITE);
+        RenderDMSInstance(spider, (Vector3){0, 0, 0}, 1.0f, WHITE);
         glPopMatrix();
 
         EndMode3D();
@@ -271,6 +290,8 @@ int main(int argc, char **argv) {
         if (spiderModel->textures[i].id != 0) UnloadTexture(spiderModel->textures[i]);
     }
 
+    DestroyDMSInstance(player);
+    DestroyDMSInstance(spider);
     UnloadDMSModel(levelModel);
     UnloadDMSModel(playerModel);
     UnloadDMSModel(spiderModel);
@@ -0,0 +1,143 @@
+// Blend cost per bone, without sampling: the structure-of-arrays nlerp
+// accumulation the runtime uses against a running slerp over DMSTransform
+// layers, the way blends were written before. Then the cost of a whole
+// UpdateDMSInstanceAnimation() for one clip and for a two-clip blend.
+//
+//   blend model.dms
+//
+// Includes the runtime to reach its static blend functions.
+#include "dms.c"
+#include <time.h>
+
+#define ROUNDS 7
+#define BLEND_ITERATIONS 20000
+#define UPDATE_FRAMES 100000
+
+static volatile float sink;
+
+static double Now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Running blend: each layer is lerped/slerped into the sum by its share of
+// the weight so far
+static void BlendTransforms(DMSTransform* out, DMSTransform* const* layers, const float* weights, int layerCount,
+                            int boneCount) {
+    for (int i = 0; i < boneCount; i++) {
+        DMSTransform sum = layers[0][i];
+        float total = weights[0];
+        for (int l = 1; l < layerCount; l++) {
+            total += weights[l];
+            float alpha = weights[l] / total;
+            sum.translation = Vector3Lerp(sum.translation, layers[l][i].translation, alpha);
+            sum.rotation = QuaternionSlerp(sum.rotation, layers[l][i].rotation, alpha);
+            sum.scale = Vector3Lerp(sum.scale, layers[l][i].scale, alpha);
+        }
+        out[i] = sum;
+    }
+}
+
+static void BlendPoses(DMSInstance* instance, const DMSPose* layers, const float* weights, int layerCount) {
+    const DMSSkeleton* skeleton = instance->model->skeleton;
+    int boneCount = skeleton->boneCount;
+    memset(instance->pose.translation, 0, boneCount * sizeof(Vector3));
+    memset(instance->pose.rotation, 0, boneCount * sizeof(Quaternion));
+    memset(instance->pose.scale, 0, boneCount * sizeof(Vector3));
+    memset(instance->blendWeight, 0, boneCount * sizeof(float));
+    for (int l = 0; l < layerCount; l++) {
+        AccumulateDMSPose(&instance->pose, instance->blendWeight, &layers[l], boneCount, weights[l], NULL);
+    }
+    NormalizeDMSPose(&instance->pose, instance->blendWeight, skeleton);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s model.dms\n", argv[0]);
+        return 1;
+    }
+    DMSModel* model = LoadDMSModelSections(argv[1], DMS_LOAD_ALL | DMS_LOAD_ALL_CLIPS);
+    if (!model || !model->skeleton || model->skeleton->animCount < 2) {
+        printf("%s needs two clips\n", argv[1]);
+        return 1;
+    }
+    DMSSkeleton* skeleton = model->skeleton;
+    int boneCount = skeleton->boneCount;
+    DMSInstance* instance = CreateDMSInstance(model);
+
+    // Four layer poses from different clips and times
+    DMSPose layers[4];
+    DMSTransform* transforms[4];
+    const float weights[4] = { 0.4f, 0.3f, 0.2f, 0.1f };
+    int* cursor = (int*)calloc(boneCount * DMS_TRACKS_PER_BONE, sizeof(int));
+    for (int l = 0; l < 4; l++) {
+        layers[l].translation = (Vector3*)malloc(boneCount * sizeof(Vector3));
+        layers[l].rotation = (Quaternion*)malloc(boneCount * sizeof(Quaternion));
+        layers[l].scale = (Vector3*)malloc(boneCount * sizeof(Vector3));
+        transforms[l] = (DMSTransform*)malloc(boneCount * sizeof(DMSTransform));
+        memset(cursor, 0, boneCount * DMS_TRACKS_PER_BONE * sizeof(int));
+        SampleDMSClip(skeleton, AcquireDMSClip(skeleton, l % skeleton->animCount), 0.3f * l + 0.1f, cursor, -1,
+                      &layers[l], NULL);
+        for (int i = 0; i < boneCount; i++) {
+            transforms[l][i].translation = layers[l].translation[i];
+            transforms[l][i].rotation = layers[l].rotation[i];
+            transforms[l][i].scale = layers[l].scale[i];
+        }
+    }
+    DMSTransform* out = (DMSTransform*)malloc(boneCount * sizeof(DMSTransform));
+
+    printf("%s, %d bones, best of %d rounds\n", argv[1], boneCount, ROUNDS);
+    for (int layerCount = 2; layerCount <= 4; layerCount += 2) {
+        double slerpNs = 1e9, nlerpNs = 1e9;
+        for (int r = 0; r < ROUNDS; r++) {
+            double start = Now();
+            for (int it = 0; it < BLEND_ITERATIONS; it++) {
+                BlendTransforms(out, transforms, weights, layerCount, boneCount);
+                sink += out[it % boneCount].rotation.w;
+            }
+            double ns = (Now() - start) * 1e9 / ((double)BLEND_ITERATIONS * boneCount);
+            if (ns < slerpNs) slerpNs = ns;
+
+            start = Now();
+            for (int it = 0; it < BLEND_ITERATIONS; it++) {
+                BlendPoses(instance, layers, weights, layerCount);
+                sink += instance->pose.rotation[it % boneCount].w;
+            }
+            ns = (Now() - start) * 1e9 / ((double)BLEND_ITERATIONS * boneCount);
+            if (ns < nlerpNs) nlerpNs = ns;
+        }
+
+        // Both blends should land on the same rotations
+        float error = 0.0f;
+        for (int i = 0; i < boneCount; i++) {
+            Quaternion a = out[i].rotation, b = instance->pose.rotation[i];
+            float e = fabsf(fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) - 1.0f);
+            if (e > error) error = e;
+        }
+        printf("%d layers: slerp chain %.1f ns/bone, SoA nlerp %.1f ns/bone (%.1fx), max |1 - |dot|| %.2g\n",
+               layerCount, slerpNs, nlerpNs, slerpNs / nlerpNs, error);
+    }
+
+    DMSInstance* player = CreateDMSInstance(model);
+    double oneNs = 1e9, twoNs = 1e9;
+    for (int r = 0; r < ROUNDS; r++) {
+        SetDMSInstanceAnimation(player, 0);
+        double start = Now();
+        for (int f = 0; f < UPDATE_FRAMES / ROUNDS; f++) UpdateDMSInstanceAnimation(player, 1.0f / 60.0f);
+        double ns = (Now() - start) * 1e9 / ((double)(UPDATE_FRAMES / ROUNDS) * boneCount);
+        if (ns < oneNs) oneNs = ns;
+
+        SetDMSInstanceLayer(player, 1, 1, 0.5f, NULL);
+        start = Now();
+        for (int f = 0; f < UPDATE_FRAMES / ROUNDS; f++) UpdateDMSInstanceAnimation(player, 1.0f / 60.0f);
+        ns = (Now() - start) * 1e9 / ((double)(UPDATE_FRAMES / ROUNDS) * boneCount);
+        if (ns < twoNs) twoNs = ns;
+    }
+    printf("UpdateDMSInstanceAnimation: 1 clip %.1f ns/bone, 2-clip blend %.1f ns/bone\n", oneNs, twoNs);
+
+    DestroyDMSInstance(player);
+    DestroyDMSInstance(instance);
+    UnloadDMSModel(model);
+    return 0;
+}
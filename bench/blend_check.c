@@ -0,0 +1,173 @@
+// Checks of cross-fades and layered blends through the public API:
+//   1. fade weights sum to 1 on every frame of a cross-fade
+//   2. a finished fade leaves an instance identical to a fresh one
+//   3. complementary bone masks reproduce each clip on its own bones
+//   4. nlerp blending stays within 1e-3 of slerping the clips' rotations
+// plus layer overflow and removal releasing every clip user.
+//
+//   blend_check model.dms     (needs three clips)
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dms.h"
+
+#define FRAME_TIME (1.0f / 60.0f)
+#define NLERP_TOLERANCE 1e-3f
+
+static int failures = 0;
+
+static void Check(int ok, const char* what) {
+    printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) failures++;
+}
+
+// 0 for the same rotation, either sign
+static float RotationError(Quaternion a, Quaternion b) {
+    return fabsf(fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) - 1.0f);
+}
+
+static int ClipUsers(const DMSModel* model) {
+    int users = 0;
+    for (int i = 0; i < model->skeleton->animCount; i++) users += model->skeleton->animations[i].users;
+    return users;
+}
+
+static void CheckCrossFade(DMSModel* model) {
+    DMSInstance* fading = CreateDMSInstance(model);
+    DMSInstance* fresh = CreateDMSInstance(model);
+    for (int f = 0; f < 10; f++) UpdateDMSInstanceAnimation(fading, FRAME_TIME);
+    CrossFadeDMSInstanceAnimation(fading, 1, 0.25f);
+    SetDMSInstanceAnimation(fresh, 1);
+    Check(fading->layerCount == 2 && GetDMSInstanceAnimation(fading) == 1, "cross-fade adds a layer for the new clip");
+
+    float worstSum = 0.0f;
+    for (int f = 0; f < 30; f++) {
+        UpdateDMSInstanceAnimation(fading, FRAME_TIME);
+        UpdateDMSInstanceAnimation(fresh, FRAME_TIME);
+        if (fading->layerCount == 2) {
+            float error = fabsf(fading->layers[0].weight + fading->layers[1].weight - 1.0f);
+            if (error > worstSum) worstSum = error;
+        }
+    }
+    printf("      max |weights - 1| during the fade: %g\n", worstSum);
+    Check(worstSum < 1e-4f, "fade weights sum to 1");
+
+    UpdateDMSInstanceSkinning(fading);
+    UpdateDMSInstanceSkinning(fresh);
+    int same = fading->layerCount == 1;
+    for (int m = 0; m < model->meshCount && same; m++) {
+        if (!fresh->skinnedVertices || !fresh->skinnedVertices[m]) continue;
+        same = memcmp(fading->skinnedVertices[m], fresh->skinnedVertices[m],
+                      model->meshes[m].vertexCount * sizeof(DMSVertex)) == 0;
+    }
+    Check(same, "a finished fade matches a fresh instance");
+    DestroyDMSInstance(fading);
+    DestroyDMSInstance(fresh);
+}
+
+static void CheckMasks(DMSModel* model) {
+    int boneCount = model->skeleton->boneCount;
+    float* lower = (float*)malloc(boneCount * sizeof(float));
+    float* upper = (float*)malloc(boneCount * sizeof(float));
+    for (int i = 0; i < boneCount; i++) {
+        upper[i] = (float)(i % 2);
+        lower[i] = 1.0f - upper[i];
+    }
+
+    DMSInstance* blend = CreateDMSInstance(model);
+    DMSInstance* clip0 = CreateDMSInstance(model);
+    DMSInstance* clip2 = CreateDMSInstance(model);
+    SetDMSInstanceLayer(blend, 0, 0, 1.0f, lower);
+    SetDMSInstanceLayer(blend, 1, 2, 0.7f, upper);
+    SetDMSInstanceAnimation(clip0, 0);
+    SetDMSInstanceAnimation(clip2, 2);
+    for (int f = 0; f < 20; f++) {
+        UpdateDMSInstanceAnimation(blend, 0.03f);
+        UpdateDMSInstanceAnimation(clip0, 0.03f);
+        UpdateDMSInstanceAnimation(clip2, 0.03f);
+    }
+
+    float rotationError = 0.0f, translationError = 0.0f;
+    for (int i = 0; i < boneCount; i++) {
+        const DMSInstance* source = upper[i] > 0.0f ? clip2 : clip0;
+        float e = RotationError(blend->pose.rotation[i], source->pose.rotation[i]);
+        if (e > rotationError) rotationError = e;
+        Vector3 a = blend->pose.translation[i], b = source->pose.translation[i];
+        e = fabsf(a.x - b.x) + fabsf(a.y - b.y) + fabsf(a.z - b.z);
+        if (e > translationError) translationError = e;
+    }
+    printf("      masked blend: rotation error %g, translation error %g\n", rotationError, translationError);
+    Check(rotationError < 1e-5f && translationError < 1e-4f, "complementary masks reproduce each clip");
+
+    DestroyDMSInstance(blend);
+    DestroyDMSInstance(clip0);
+    DestroyDMSInstance(clip2);
+    free(lower);
+    free(upper);
+}
+
+static void CheckNlerp(DMSModel* model) {
+    DMSInstance* blend = CreateDMSInstance(model);
+    DMSInstance* clip0 = CreateDMSInstance(model);
+    DMSInstance* clip1 = CreateDMSInstance(model);
+    SetDMSInstanceLayer(blend, 0, 0, 0.6f, NULL);
+    SetDMSInstanceLayer(blend, 1, 1, 0.4f, NULL);
+    SetDMSInstanceAnimation(clip0, 0);
+    SetDMSInstanceAnimation(clip1, 1);
+
+    float error = 0.0f;
+    for (int f = 0; f < 120; f++) {
+        UpdateDMSInstanceAnimation(blend, FRAME_TIME);
+        UpdateDMSInstanceAnimation(clip0, FRAME_TIME);
+        UpdateDMSInstanceAnimation(clip1, FRAME_TIME);
+        for (int i = 0; i < model->skeleton->boneCount; i++) {
+            Quaternion slerp = QuaternionSlerp(clip0->pose.rotation[i], clip1->pose.rotation[i], 0.4f);
+            float e = RotationError(blend->pose.rotation[i], slerp);
+            if (e > error) error = e;
+        }
+    }
+    printf("      60/40 blend over 2 s: max |1 - |dot|| against slerp %g\n", error);
+    Check(error < NLERP_TOLERANCE, "nlerp blending stays close to slerp");
+
+    DestroyDMSInstance(blend);
+    DestroyDMSInstance(clip0);
+    DestroyDMSInstance(clip1);
+}
+
+static void CheckLayerLimits(DMSModel* model) {
+    DMSInstance* instance = CreateDMSInstance(model);
+    for (int k = 0; k < 6; k++) {
+        CrossFadeDMSInstanceAnimation(instance, k % model->skeleton->animCount, 0.5f);
+        UpdateDMSInstanceAnimation(instance, 0.01f);
+    }
+    Check(instance->layerCount == DMS_MAX_ANIMATION_LAYERS, "cross-fades beyond the layer limit drop the oldest");
+    for (int f = 0; f < 40; f++) UpdateDMSInstanceAnimation(instance, FRAME_TIME);
+    Check(instance->layerCount == 1, "faded-out layers are removed");
+
+    SetDMSInstanceLayer(instance, 1, 1, 0.5f, NULL);
+    SetDMSInstanceLayer(instance, 1, -1, 0.0f, NULL);
+    Check(instance->layerCount == 1, "a layer can be removed again");
+    Check(!SetDMSInstanceLayer(instance, 3, 1, 0.5f, NULL), "layers past the last one are refused");
+    DestroyDMSInstance(instance);
+    Check(ClipUsers(model) == 0, "destroyed instances release their clips");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s model.dms\n", argv[0]);
+        return 1;
+    }
+    DMSModel* model = LoadDMSModelSections(argv[1], DMS_LOAD_ALL | DMS_LOAD_ALL_CLIPS);
+    if (!model || !model->skeleton || model->skeleton->animCount < 3) {
+        printf("%s needs three clips\n", argv[1]);
+        return 1;
+    }
+    CheckCrossFade(model);
+    CheckMasks(model);
+    CheckNlerp(model);
+    CheckLayerLimits(model);
+    UnloadDMSModel(model);
+    printf("%d failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+// World pose composition against the path it replaced: local matrices from
+// MatrixScale/QuaternionToMatrix/MatrixTranslate and full MatrixMultiply()
+// calls, against ComposeDMSWorldPoses() building the local matrix straight
+// from TRS and multiplying by the parent with MultiplyDMSAffine(). Also
+// times key interpolation, QuaternionSlerp() against
+// InterpolateDMSQuaternion().
+//
+//   compose model.dms [clip]
+//
+// Includes the runtime to reach its static compose functions.
+#include "dms.c"
+#include <time.h>
+
+#define POSES 240
+#define ROUNDS 40
+#define REPEATS 10
+#define INTERPOLATIONS 1000000
+
+static volatile float sink;
+
+static double Now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// The composition before TRS building and the affine multiply
+static void ComposeWorldPosesWithMatrices(const DMSSkeleton* skeleton, const DMSPose* pose, Matrix* worldPose) {
+    for (int i = 0; i < skeleton->boneCount; i++) {
+        const DMSBone* bone = &skeleton->bones[i];
+        Matrix S = MatrixScale(pose->scale[i].x, pose->scale[i].y, pose->scale[i].z);
+        Matrix R = QuaternionToMatrix(pose->rotation[i]);
+        Matrix T = MatrixTranslate(pose->translation[i].x, pose->translation[i].y, pose->translation[i].z);
+        Matrix localTransform = MatrixMultiply(MatrixMultiply(S, R), T);
+        if (bone->parent >= 0) {
+            worldPose[i] = MatrixMultiply(localTransform, worldPose[bone->parent]);
+        } else {
+            worldPose[i] = localTransform;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s model.dms [clip]\n", argv[0]);
+        return 1;
+    }
+    DMSModel* model = LoadDMSModelSections(argv[1], DMS_LOAD_ALL | DMS_LOAD_ALL_CLIPS);
+    if (!model || !model->skeleton || model->skeleton->animCount == 0) {
+        printf("%s has no clips\n", argv[1]);
+        return 1;
+    }
+    DMSSkeleton* skeleton = model->skeleton;
+    int boneCount = skeleton->boneCount;
+    int clip = argc > 2 ? atoi(argv[2]) : 0;
+    if (clip < 0 || clip >= skeleton->animCount) clip = 0;
+
+    // A clip's worth of sampled poses, so composition sees real rotations
+    DMSInstance* instance = CreateDMSInstance(model);
+    SetDMSInstanceAnimation(instance, clip);
+    static DMSPose poses[POSES];
+    for (int f = 0; f < POSES; f++) {
+        UpdateDMSInstanceAnimation(instance, 1.0f / 60.0f);
+        poses[f].translation = (Vector3*)malloc(boneCount * sizeof(Vector3));
+        poses[f].rotation = (Quaternion*)malloc(boneCount * sizeof(Quaternion));
+        poses[f].scale = (Vector3*)malloc(boneCount * sizeof(Vector3));
+        memcpy(poses[f].translation, instance->pose.translation, boneCount * sizeof(Vector3));
+        memcpy(poses[f].rotation, instance->pose.rotation, boneCount * sizeof(Quaternion));
+        memcpy(poses[f].scale, instance->pose.scale, boneCount * sizeof(Vector3));
+    }
+
+    Matrix* oldWorld = (Matrix*)malloc(boneCount * sizeof(Matrix));
+    Matrix* newWorld = (Matrix*)malloc(boneCount * sizeof(Matrix));
+    float difference = 0.0f;
+    for (int f = 0; f < POSES; f++) {
+        ComposeWorldPosesWithMatrices(skeleton, &poses[f], oldWorld);
+        ComposeDMSWorldPoses(skeleton, &poses[f], NULL, newWorld);
+        for (int i = 0; i < boneCount; i++) {
+            const float* a = &oldWorld[i].m0;
+            const float* b = &newWorld[i].m0;
+            for (int k = 0; k < 16; k++) {
+                if (fabsf(a[k] - b[k]) > difference) difference = fabsf(a[k] - b[k]);
+            }
+        }
+    }
+
+    double oldNs = 1e9, newNs = 1e9;
+    for (int r = 0; r < ROUNDS; r++) {
+        double start = Now();
+        for (int k = 0; k < REPEATS; k++) {
+            for (int f = 0; f < POSES; f++) {
+                ComposeWorldPosesWithMatrices(skeleton, &poses[f], oldWorld);
+                sink += oldWorld[boneCount - 1].m12;
+            }
+        }
+        double ns = (Now() - start) * 1e9 / ((double)REPEATS * POSES * boneCount);
+        if (ns < oldNs) oldNs = ns;
+
+        start = Now();
+        for (int k = 0; k < REPEATS; k++) {
+            for (int f = 0; f < POSES; f++) {
+                ComposeDMSWorldPoses(skeleton, &poses[f], NULL, newWorld);
+                sink += newWorld[boneCount - 1].m12;
+            }
+        }
+        ns = (Now() - start) * 1e9 / ((double)REPEATS * POSES * boneCount);
+        if (ns < newNs) newNs = ns;
+    }
+
+    // Neighbouring keys of a real track, as the sampler sees them
+    Quaternion a = poses[0].rotation[boneCount > 1 ? 1 : 0];
+    Quaternion b = poses[1].rotation[boneCount > 1 ? 1 : 0];
+    double slerpNs = 1e9, interpolateNs = 1e9;
+    for (int r = 0; r < ROUNDS / 2; r++) {
+        Quaternion sum = { 0 };
+        double start = Now();
+        for (int q = 0; q < INTERPOLATIONS; q++) {
+            Quaternion result = QuaternionSlerp(a, b, (q & 1023) * (1.0f / 1024.0f));
+            sum.x += result.x;
+        }
+        double ns = (Now() - start) * 1e9 / INTERPOLATIONS;
+        if (ns < slerpNs) slerpNs = ns;
+
+        start = Now();
+        for (int q = 0; q < INTERPOLATIONS; q++) {
+            Quaternion result = InterpolateDMSQuaternion(a, b, (q & 1023) * (1.0f / 1024.0f));
+            sum.x += result.x;
+        }
+        ns = (Now() - start) * 1e9 / INTERPOLATIONS;
+        if (ns < interpolateNs) interpolateNs = ns;
+        sink += sum.x;
+    }
+
+    printf("%s, %d bones, clip %s, best of %d rounds\n", argv[1], boneCount, skeleton->animations[clip].name, ROUNDS);
+    printf("compose: matrices %.1f ns/bone, TRS + affine %.1f ns/bone (%.2fx), max difference %.2g\n", oldNs, newNs,
+           oldNs / newNs, difference);
+    printf("rotation keys: QuaternionSlerp %.1f ns, InterpolateDMSQuaternion %.1f ns\n", slerpNs, interpolateNs);
+
+    DestroyDMSInstance(instance);
+    UnloadDMSModel(model);
+    return 0;
+}
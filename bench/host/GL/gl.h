@@ -0,0 +1,44 @@
+// Just enough of GL for the runtime to build on the host. Draw calls are
+// stubbed in stubs.c; the benchmarks never render.
+#ifndef BENCH_HOST_GL_H
+#define BENCH_HOST_GL_H
+
+typedef unsigned int GLuint;
+typedef unsigned int GLenum;
+typedef int GLint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef unsigned char GLubyte;
+typedef unsigned char GLboolean;
+typedef void GLvoid;
+
+#define GL_BYTE                0x1400
+#define GL_UNSIGNED_BYTE       0x1401
+#define GL_UNSIGNED_SHORT      0x1403
+#define GL_UNSIGNED_INT        0x1405
+#define GL_FLOAT               0x1406
+#define GL_TRIANGLES           0x0004
+#define GL_TRIANGLE_STRIP      0x0005
+#define GL_LIGHTING            0x0B50
+#define GL_TEXTURE_2D          0x0DE1
+#define GL_VERTEX_ARRAY        0x8074
+#define GL_NORMAL_ARRAY        0x8075
+#define GL_TEXTURE_COORD_ARRAY 0x8078
+
+void glEnable(GLenum cap);
+void glDisable(GLenum cap);
+void glEnableClientState(GLenum array);
+void glDisableClientState(GLenum array);
+void glBindTexture(GLenum target, GLuint texture);
+void glColor4ub(GLubyte r, GLubyte g, GLubyte b, GLubyte a);
+void glPushMatrix(void);
+void glPopMatrix(void);
+void glMultMatrixf(const GLfloat* m);
+void glTranslatef(GLfloat x, GLfloat y, GLfloat z);
+void glScalef(GLfloat x, GLfloat y, GLfloat z);
+void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer);
+void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer);
+void glNormalPointer(GLenum type, GLsizei stride, const GLvoid* pointer);
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+
+#endif
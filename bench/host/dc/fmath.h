@@ -0,0 +1,15 @@
+// Host versions of the SH4 math intrinsics fraymath.h uses
+#ifndef BENCH_HOST_FMATH_H
+#define BENCH_HOST_FMATH_H
+
+#include <math.h>
+
+static inline float fsqrt(float x) {
+    return sqrtf(x);
+}
+
+static inline float fipr(float x, float y, float z, float w, float a, float b, float c, float d) {
+    return x * a + y * b + z * c + w * d;
+}
+
+#endif
@@ -0,0 +1,50 @@
+// The SH4 matrix unit in C: one current matrix, column-major like KOS
+#include <string.h>
+#include "kos.h"
+
+static matrix_t current;
+long mat_load_count;
+
+void mat_load(matrix_t* matrix) {
+    memcpy(current, *matrix, sizeof(matrix_t));
+    mat_load_count++;
+}
+
+void mat_store(matrix_t* matrix) {
+    memcpy(*matrix, current, sizeof(matrix_t));
+}
+
+void mat_apply(matrix_t* matrix) {
+    matrix_t result;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            result[i][j] = 0.0f;
+            for (int k = 0; k < 4; k++) result[i][j] += current[k][j] * (*matrix)[i][k];
+        }
+    }
+    memcpy(current, result, sizeof(matrix_t));
+}
+
+void mat_identity(void) {
+    memset(current, 0, sizeof(matrix_t));
+    for (int i = 0; i < 4; i++) current[i][i] = 1.0f;
+}
+
+void mat_translate(float x, float y, float z) {
+    matrix_t t = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { x, y, z, 1 } };
+    mat_apply(&t);
+}
+
+void mat_scale(float x, float y, float z) {
+    matrix_t s = { { x, 0, 0, 0 }, { 0, y, 0, 0 }, { 0, 0, z, 0 }, { 0, 0, 0, 1 } };
+    mat_apply(&s);
+}
+
+void mat_transform_point(float x, float y, float z, float* out) {
+    float r[4];
+    for (int j = 0; j < 4; j++) r[j] = current[0][j] * x + current[1][j] * y + current[2][j] * z + current[3][j];
+    float invW = 1.0f / r[3];
+    out[0] = r[0] * invW;
+    out[1] = r[1] * invW;
+    out[2] = invW;
+}
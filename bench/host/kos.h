@@ -0,0 +1,43 @@
+// Just enough of KOS for the PVR runtime (pvr_animated/dms.c) to build on
+// the host. The matrix unit is emulated in C in kos.c, so host timings of
+// code built on it say nothing about ftrv/fipr on the SH4; mat_load()
+// calls are counted instead, as the part of its cost that carries over.
+#ifndef BENCH_HOST_KOS_H
+#define BENCH_HOST_KOS_H
+
+#include <stdint.h>
+#include <malloc.h>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+typedef float matrix_t[4][4];
+typedef void* pvr_ptr_t;
+
+typedef struct {
+    uint32 flags;
+    float x, y, z;
+    float u, v;
+    uint32 argb, oargb;
+} pvr_vertex_t;
+
+// mat_load() calls since the last reset
+extern long mat_load_count;
+
+void mat_load(matrix_t* matrix);
+void mat_store(matrix_t* matrix);
+void mat_apply(matrix_t* matrix);
+void mat_identity(void);
+void mat_translate(float x, float y, float z);
+void mat_scale(float x, float y, float z);
+void mat_transform_point(float x, float y, float z, float* out);
+
+// Transforms and divides by w like the SH4 macro: x/w, y/w, 1/w
+#define mat_trans_single3_nomod(x, y, z, x2, y2, z2) do { \
+        float _out[3]; \
+        mat_transform_point((x), (y), (z), _out); \
+        (x2) = _out[0]; (y2) = _out[1]; (z2) = _out[2]; \
+    } while (0)
+
+#endif
@@ -0,0 +1,33 @@
+// No-op GL and texture loading, so the runtime links on the host
+#include "dms.h"
+#include "gl_png.h"
+
+void glEnable(GLenum cap) { (void)cap; }
+void glDisable(GLenum cap) { (void)cap; }
+void glEnableClientState(GLenum array) { (void)array; }
+void glDisableClientState(GLenum array) { (void)array; }
+void glBindTexture(GLenum target, GLuint texture) { (void)target; (void)texture; }
+void glColor4ub(GLubyte r, GLubyte g, GLubyte b, GLubyte a) { (void)r; (void)g; (void)b; (void)a; }
+void glPushMatrix(void) {}
+void glPopMatrix(void) {}
+void glMultMatrixf(const GLfloat* m) { (void)m; }
+void glTranslatef(GLfloat x, GLfloat y, GLfloat z) { (void)x; (void)y; (void)z; }
+void glScalef(GLfloat x, GLfloat y, GLfloat z) { (void)x; (void)y; (void)z; }
+void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) {
+    (void)size; (void)type; (void)stride; (void)pointer;
+}
+void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) {
+    (void)size; (void)type; (void)stride; (void)pointer;
+}
+void glNormalPointer(GLenum type, GLsizei stride, const GLvoid* pointer) {
+    (void)type; (void)stride; (void)pointer;
+}
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+    (void)mode; (void)count; (void)type; (void)indices;
+}
+
+Texture2D LoadTextureDTEX(const char* fileName) {
+    (void)fileName;
+    Texture2D texture = { 0 };
+    return texture;
+}
@@ -0,0 +1,126 @@
+// Animation cache benchmark: N instances of one clip at random phases,
+// updated and skinned every 1/60 s frame with the cache off and with a
+// 1/30 s step, plus the cache's hit rates. First checks that a cached
+// instance draws exactly what an uncached one shows at the step's start.
+//
+//   instance_cache model.dms [clip]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dms.h"
+
+#define FRAMES 300
+#define FRAME_TIME (1.0f / 60.0f)
+#define CACHE_STEP (1.0f / 30.0f)
+
+static double Now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static DMSVertex* const* DrawnVertices(const DMSInstance* instance) {
+    return instance->result ? instance->result->skinnedVertices : instance->skinnedVertices;
+}
+
+// Two cached instances in lockstep share a result, and its vertices match
+// a third instance evaluated uncached at the start of the step
+static int CheckSharedResults(DMSModel* model, int clip) {
+    int mismatches = 0;
+    SetDMSAnimationCacheStep(CACHE_STEP);
+    DMSInstance* a = CreateDMSInstance(model);
+    DMSInstance* b = CreateDMSInstance(model);
+    DMSInstance* reference = CreateDMSInstance(model);
+    SetDMSInstanceAnimation(a, clip);
+    SetDMSInstanceAnimation(b, clip);
+    SetDMSInstanceAnimation(reference, clip);
+
+    for (int f = 0; f < 200; f++) {
+        SetDMSAnimationCacheStep(CACHE_STEP);
+        UpdateDMSInstanceAnimation(a, FRAME_TIME);
+        UpdateDMSInstanceAnimation(b, FRAME_TIME);
+        UpdateDMSInstanceSkinning(a);
+        UpdateDMSInstanceSkinning(b);
+        if (a->result != b->result) mismatches++;
+
+        SetDMSAnimationCacheStep(0.0f);
+        float stepStart = a->result->step * CACHE_STEP;
+        reference->layers[0].time = 0.0f;
+        UpdateDMSInstanceAnimation(reference, stepStart);
+        UpdateDMSInstanceSkinning(reference);
+        for (int m = 0; m < model->meshCount; m++) {
+            if (!reference->skinnedVertices[m]) continue;
+            if (memcmp(DrawnVertices(a)[m], reference->skinnedVertices[m],
+                       model->meshes[m].vertexCount * sizeof(DMSVertex)) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    DestroyDMSInstance(a);
+    DestroyDMSInstance(b);
+    DestroyDMSInstance(reference);
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s model.dms [clip]\n", argv[0]);
+        return 1;
+    }
+    DMSModel* model = LoadDMSModelSections(argv[1], DMS_LOAD_ALL | DMS_LOAD_ALL_CLIPS);
+    if (!model || !model->skeleton || model->skeleton->animCount == 0) {
+        printf("%s has no clips\n", argv[1]);
+        return 1;
+    }
+    int clip = argc > 2 ? atoi(argv[2]) : 0;
+    if (clip < 0 || clip >= model->skeleton->animCount) clip = 0;
+    float duration = model->skeleton->animations[clip].duration;
+
+    int mismatches = CheckSharedResults(model, clip);
+    printf("%s, clip %s: shared results %s\n", argv[1], model->skeleton->animations[clip].name,
+           mismatches ? "DIFFER" : "match uncached evaluation");
+
+    printf("   N  uncached ms/frame  cached ms/frame  pose hits  skin hits  results\n");
+    const int counts[] = { 1, 10, 50, 200 };
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        int n = counts[c];
+        DMSInstance** instances = (DMSInstance**)malloc(n * sizeof(DMSInstance*));
+        double ms[2];
+        DMSAnimationCacheStats stats;
+        for (int cached = 0; cached < 2; cached++) {
+            SetDMSAnimationCacheStep(cached ? CACHE_STEP : 0.0f);
+            srand(1);
+            for (int i = 0; i < n; i++) {
+                instances[i] = CreateDMSInstance(model);
+                SetDMSInstanceAnimation(instances[i], clip);
+                instances[i]->layers[0].time = (rand() / (float)RAND_MAX) * duration * 0.999f;
+            }
+            ResetDMSAnimationCacheStats();
+
+            double start = Now();
+            for (int f = 0; f < FRAMES; f++) {
+                for (int i = 0; i < n; i++) UpdateDMSInstanceAnimation(instances[i], FRAME_TIME);
+                for (int i = 0; i < n; i++) UpdateDMSInstanceSkinning(instances[i]);
+            }
+            ms[cached] = (Now() - start) * 1000.0 / FRAMES;
+            stats = GetDMSAnimationCacheStats();
+            for (int i = 0; i < n; i++) DestroyDMSInstance(instances[i]);
+        }
+        free(instances);
+
+        unsigned long poses = stats.poseHits + stats.poseMisses;
+        unsigned long skins = stats.skinningHits + stats.skinningMisses;
+        printf("%4d  %17.3f  %15.3f  %8.1f%%  %8.1f%%  %d (%zu KB)\n", n, ms[0], ms[1],
+               poses ? 100.0 * stats.poseHits / poses : 0.0, skins ? 100.0 * stats.skinningHits / skins : 0.0,
+               stats.resultCount, stats.resultBytes / 1024);
+    }
+
+    UnloadDMSModel(model);
+    DMSAnimationCacheStats stats = GetDMSAnimationCacheStats();
+    if (stats.resultCount != 0 || stats.resultBytes != 0) {
+        printf("%d results (%zu bytes) outlive their model\n", stats.resultCount, stats.resultBytes);
+        mismatches++;
+    }
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+// Skinning on the PVR runtime (pvr_animated/dms.c), the two paths the PVR
+// demos can draw a skinned model with: UpdateDMSMeshAnimation() into
+// animatedVertices and then TransformDMSVertex() per index, against
+// BuildDMSPalette() once and SkinTransformDMSVertex() per index. Packed
+// meshes take the first path either way, as the demos do.
+//
+//   pvr_skinning model.dms
+//
+// The matrix unit is emulated in C (host/kos.c), so the times only compare
+// the two paths on this machine and say nothing of ftrv on the SH4;
+// mat_load() counts carry over. The SH4 numbers come from clipping_demo's
+// profile ("CPU Skinning" and "Bone Palette" against "Vertex Transform"
+// and "Vertex Submit"), switching paths with A.
+#include <math.h>
+#include <time.h>
+#include "dms.h"
+
+#define FRAMES 4
+#define ROUNDS 40
+#define REPEATS 10
+
+// A projection like the demos' setupModelMatrix()
+static matrix_t __attribute__((aligned(32))) modelMatrix = {
+    { 300.0f, 0.0f, 0.0f, 0.0f },
+    { 0.0f, -300.0f, 0.0f, 0.0f },
+    { 0.0f, 0.0f, 0.5f, 0.0f },
+    { 320.0f, 240.0f, 4.0f, 1.0f }
+};
+
+static double Now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Every skinned mesh of the model as pvrtest.c draws it, each index in turn
+static int DrawSkinnedMeshes(DMSModel* model, int fusedSkinning, pvr_vertex_t* out) {
+    int count = 0;
+    int paletteBoneSpace = -1;
+    for (int m = 0; m < model->meshCount; m++) {
+        DMSMesh* mesh = &model->meshes[m];
+        if (mesh->rigidBone >= 0) continue;
+
+        int fused = fusedSkinning && mesh->vertices;
+        int loadedBone = -1;
+        if (!fused) UpdateDMSMeshAnimation(mesh, model->skeleton);
+
+        mat_load(&modelMatrix);
+        if (fused) {
+            if (mesh->boneSpace != paletteBoneSpace) {
+                BuildDMSPalette(model->skeleton, mesh->boneSpace);
+                paletteBoneSpace = mesh->boneSpace;
+            }
+        } else if (!mesh->animatedVertices) {
+            ApplyDMSMeshDequantization(mesh);
+        }
+
+        for (int i = 0; i < mesh->indexCount; i++) {
+            uint32_t index = DMSMeshIndex(mesh, i);
+            if (fused) {
+                SkinTransformDMSVertex(mesh, model->skeleton, index, &loadedBone, &out[count++]);
+            } else {
+                TransformDMSVertex(mesh, mesh->animatedVertices, index, &out[count++]);
+            }
+        }
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s model.dms\n", argv[0]);
+        return 1;
+    }
+    // The fused path needs no skinning results for float meshes
+    DMSModel* cpu = LoadDMSModel(argv[1]);
+    DMSModel* fused = LoadDMSModelSections(argv[1], DMS_LOAD_ALL & ~DMS_LOAD_SKINNING);
+    if (!cpu || !fused || !cpu->skeleton || cpu->skeleton->animCount == 0) {
+        printf("%s has no clips\n", argv[1]);
+        return 1;
+    }
+
+    int indexCount = 0, floatMeshes = 0, packedMeshes = 0;
+    for (int m = 0; m < cpu->meshCount; m++) {
+        if (cpu->meshes[m].rigidBone >= 0) continue;
+        indexCount += cpu->meshes[m].indexCount;
+        if (cpu->meshes[m].vertices) floatMeshes++; else packedMeshes++;
+    }
+    pvr_vertex_t* cpuOut = (pvr_vertex_t*)calloc(indexCount, sizeof(pvr_vertex_t));
+    pvr_vertex_t* fusedOut = (pvr_vertex_t*)calloc(indexCount, sizeof(pvr_vertex_t));
+
+    // Same poses on both, screen positions compared at a few frames
+    float difference = 0.0f;
+    long cpuLoads = 0, fusedLoads = 0;
+    for (int f = 0; f < FRAMES; f++) {
+        UpdateDMSModelAnimation(cpu, 0.37f);
+        UpdateDMSModelAnimation(fused, 0.37f);
+        mat_load_count = 0;
+        DrawSkinnedMeshes(cpu, 0, cpuOut);
+        cpuLoads = mat_load_count;
+        mat_load_count = 0;
+        DrawSkinnedMeshes(fused, 1, fusedOut);
+        fusedLoads = mat_load_count;
+        for (int i = 0; i < indexCount; i++) {
+            float d = fabsf(cpuOut[i].x - fusedOut[i].x) + fabsf(cpuOut[i].y - fusedOut[i].y) +
+                      fabsf(cpuOut[i].u - fusedOut[i].u) + fabsf(cpuOut[i].v - fusedOut[i].v);
+            if (d > difference) difference = d;
+        }
+    }
+
+    double cpuNs = 1e9, fusedNs = 1e9;
+    for (int r = 0; r < ROUNDS; r++) {
+        double start = Now();
+        for (int k = 0; k < REPEATS; k++) DrawSkinnedMeshes(cpu, 0, cpuOut);
+        double ns = (Now() - start) * 1e9 / ((double)REPEATS * indexCount);
+        if (ns < cpuNs) cpuNs = ns;
+
+        start = Now();
+        for (int k = 0; k < REPEATS; k++) DrawSkinnedMeshes(fused, 1, fusedOut);
+        ns = (Now() - start) * 1e9 / ((double)REPEATS * indexCount);
+        if (ns < fusedNs) fusedNs = ns;
+    }
+
+    printf("%s, %d bones, %d skinned indices (%d float, %d packed meshes), best of %d rounds\n", argv[1],
+           cpu->skeleton->boneCount, indexCount, floatMeshes, packedMeshes, ROUNDS);
+    printf("CPU skinning %.1f ns/index, fused %.1f ns/index (%.2fx), max screen difference %.2g\n", cpuNs, fusedNs,
+           cpuNs / fusedNs, difference);
+    printf("mat_load per frame: CPU skinning %ld, fused %ld (%.3f per index)\n", cpuLoads, fusedLoads,
+           (double)fusedLoads / indexCount);
+
+    free(cpuOut);
+    free(fusedOut);
+    UnloadDMSModel(cpu);
+    UnloadDMSModel(fused);
+    return 0;
+}
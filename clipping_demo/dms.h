@@ -9,6 +9,31 @@
 
 #define DMS_MAGIC_NUMBER 0x54534D44
 
+// Chunk types of DMS v6. The header (magic, version, meshCount, boneCount,
+// chunkCount) is followed by chunkCount DMSChunk entries; every chunk starts
+// on a multiple of its alignment and unknown types are skipped.
+#define DMS_CHUNK_SKELETON  0x4C454B53  // "SKEL": boneCount bones
+#define DMS_CHUNK_ANIMATION 0x4D494E41  // "ANIM": one clip
+#define DMS_CHUNK_MATERIALS 0x4C54414D  // "MATL": texture count, then 64-byte names
+#define DMS_CHUNK_BOUNDS    0x53444E42  // "BNDS": per mesh min, max, sphere center, radius
+#define DMS_CHUNK_MESH      0x4853454D  // "MESH": one mesh
+
+typedef struct {
+    uint32_t type;
+    uint32_t offset;        // From the start of the file
+    uint32_t size;
+    uint32_t alignment;
+} DMSChunk;
+
+// Sections LoadDMSModelSections() reads from a v6 file
+enum {
+    DMS_LOAD_SKELETON   = 1 << 0,
+    DMS_LOAD_ANIMATIONS = 1 << 1,   // Only together with the skeleton
+    DMS_LOAD_MESHES     = 1 << 2,
+    DMS_LOAD_SKINNING   = 1 << 3,   // animatedVertices, for CPU picking or collision; any file version
+    DMS_LOAD_ALL        = DMS_LOAD_SKELETON | DMS_LOAD_ANIMATIONS | DMS_LOAD_MESHES | DMS_LOAD_SKINNING
+};
+
 // Texture structure for Dreamcast
 typedef struct {
     pvr_ptr_t ptr;
@@ -24,6 +49,20 @@ typedef struct {
     Vector3 scale;
 } Transform;
 
+// Animation encodings of DMS v3
+enum {
+    ANIM_ENCODING_FLOAT,
+    ANIM_ENCODING_QUANTIZED
+};
+
+// Track order within a bone
+enum {
+    TRACK_TRANSLATION,
+    TRACK_ROTATION,
+    TRACK_SCALE,
+    TRACKS_PER_BONE
+};
+
 // Bone structure for skeletal animation
 typedef struct {
     char name[64];
@@ -32,15 +71,35 @@ typedef struct {
     Transform localPose;
     Matrix __attribute__((aligned(32))) worldPose;
     Matrix __attribute__((aligned(32))) inverseBindMatrix;
+    int trackCursor[TRACKS_PER_BONE];   // Last key sampled per track
+    int moved;                          // World pose rebuilt in the last update
 } Bone;
 
+// Animation track: keyCount keys at times[] (seconds), values packed as
+// 3 floats (translation, scale) or 4 floats (rotation quaternion) per key.
+// Quantized clips keep ticks[] of the clip's timeStep and three 16-bit
+// words per key instead.
+typedef struct {
+    int keyCount;
+    float* times;           // Float clips
+    float* values;
+    uint16_t* ticks;        // Quantized clips: keyCount ticks, then 3 words per key
+} Track;
+
 // Animation structure
 typedef struct {
     char name[32];
     int boneCount;
-    int frameCount;
+    int frameCount;         // Frames sampled from the source clip
     float duration;
-    Transform** framePoses;
+    Track* tracks;          // TRACKS_PER_BONE per bone
+    float* keyData;         // Float clips: storage behind every track's times/values
+    uint16_t* keyWords;     // Quantized clips: storage behind every track
+    float timeStep;         // Quantized clips: seconds per tick
+    Vector3 translationMin; // Quantized clips: value = min + word * step
+    Vector3 translationStep;
+    Vector3 scaleMin;
+    Vector3 scaleStep;
 } Animation;
 
 // Skeleton structure
@@ -51,6 +110,8 @@ typedef struct {
     int animCount;
     int currentAnim;
     float currentTime;
+    int composedAnim;       // Clip the bone poses were last sampled from, or -1
+    matrix_t* palette;      // boneCount + 1 matrices BuildDMSPalette() fills
 } Skeleton;
 
 // Vertex structure - 32 bytes total, aligned  
@@ -64,21 +125,186 @@ typedef struct __attribute__((packed, aligned(32))) {
     float boneWeight;       // Bone weight (4 bytes)
 } DMSVertex;                 // Total: 32 bytes
 
+// Vertex formats of DMS v4
+enum {
+    VERTEX_FORMAT_FLOAT,
+    VERTEX_FORMAT_PACKED
+};
+
+// Flag over the format (strippy --bone-space): weighted positions are stored
+// in their bone's space, so skinning applies only the bone's world pose
+#define VERTEX_BONE_SPACE 0x100
+
+// Flag over the format (strippy --rigid-parts): every vertex follows the bone
+// of the first one, so the mesh is drawn through that bone's world pose and
+// never skinned. Comes with VERTEX_BONE_SPACE.
+#define VERTEX_RIGID 0x200
+
+// Packed vertex - 16 bytes. Positions are offset + xyz * scale and UVs
+// uvOffset + uv * uvScale, with the ranges stored per mesh.
+typedef struct __attribute__((packed)) {
+    int16_t x, y, z;        // Quantized position (6 bytes)
+    int8_t nx, ny, nz;      // Packed normals (3 bytes)
+    uint8_t boneId;         // Bone index (1 byte)
+    uint16_t u, v;          // Quantized texture coordinates (4 bytes)
+    uint16_t boneWeight;    // Bone weight * 65535 (2 bytes)
+} DMSPackedVertex;           // Total: 16 bytes
+
 // Mesh structure
 typedef struct {
-    DMSVertex* vertices;         // Bind-pose data
-    DMSVertex* animatedVertices; // CPU-skinned results
-    unsigned int* indices;
+    DMSVertex* vertices;         // Bind-pose data, NULL for packed meshes
+    DMSVertex* animatedVertices; // CPU-skinned results; NULL for rigid meshes and float ones without DMS_LOAD_SKINNING
+    DMSPackedVertex* packedVertices; // Bind-pose data of packed meshes
+    Vector3 positionOffset;      // Packed meshes: position = offset + xyz * scale
+    Vector3 positionScale;
+    float uvOffset[2];           // Packed meshes: uv = uvOffset + uv * uvScale
+    float uvScale[2];
+    void* indices;               // Strip indices in strip table order, then a triangle list
+    uint32_t* stripLengths;      // Strip table: indices per strip
+    int stripCount;
+    int stripIndexCount;         // Indices covered by the strip table
+    int indexSize;               // Bytes per index: 2, or 4 for meshes over 65536 vertices
     int vertexCount;
     int indexCount;
     unsigned int triangleCount;  // Precomputed number of triangles
     int textureId;               // Reference to texture in model
+    int boneSpace;               // Weighted bind-pose positions are in bone space (VERTEX_BONE_SPACE)
+    int rigidBone;               // Bone of a VERTEX_RIGID mesh, else -1
     
     // Bounding sphere data
     Vector3 boundingCenter;      // Center of bounding sphere
     float boundingRadius;        // Radius of bounding sphere
 } DMSMesh;
 
+// Vertex index i of a mesh, for 16- and 32-bit indices alike
+static inline uint32_t DMSMeshIndex(const DMSMesh* mesh, int i) {
+    return (mesh->indexSize == sizeof(uint16_t)) ? ((const uint16_t*)mesh->indices)[i]
+                                                 : ((const uint32_t*)mesh->indices)[i];
+}
+
+// Bind-pose position of vertex i, for float and packed meshes alike. In
+// bone space for weighted vertices of boneSpace meshes.
+static inline Vector3 DMSMeshPosition(const DMSMesh* mesh, int i) {
+    if (mesh->vertices) {
+        return (Vector3){ mesh->vertices[i].x, mesh->vertices[i].y, mesh->vertices[i].z };
+    }
+    const DMSPackedVertex* p = &mesh->packedVertices[i];
+    return (Vector3){ mesh->positionOffset.x + p->x * mesh->positionScale.x,
+                      mesh->positionOffset.y + p->y * mesh->positionScale.y,
+                      mesh->positionOffset.z + p->z * mesh->positionScale.z };
+}
+
+// Appends a packed mesh's dequantization to the current matrix, so its
+// integer positions can go through mat_trans_single3_nomod unscaled
+static inline void ApplyDMSMeshDequantization(const DMSMesh* mesh) {
+    mat_translate(mesh->positionOffset.x, mesh->positionOffset.y, mesh->positionOffset.z);
+    mat_scale(mesh->positionScale.x, mesh->positionScale.y, mesh->positionScale.z);
+}
+
+// Appends a raymath matrix to the current matrix, so positions go through
+// it before what is already there
+static inline void ApplyDMSMatrix(const Matrix* m) {
+    matrix_t __attribute__((aligned(32))) columns = {
+        { m->m0, m->m1, m->m2, m->m3 },
+        { m->m4, m->m5, m->m6, m->m7 },
+        { m->m8, m->m9, m->m10, m->m11 },
+        { m->m12, m->m13, m->m14, m->m15 }
+    };
+    mat_apply(&columns);
+}
+
+// Appends a rigid mesh's bone to the current matrix, so its bind-pose
+// vertices land where the bone's world pose puts them. Goes before
+// ApplyDMSMeshDequantization.
+static inline void ApplyDMSMeshBone(const DMSMesh* mesh, const Skeleton* skeleton) {
+    ApplyDMSMatrix(&skeleton->bones[mesh->rigidBone].worldPose);
+}
+
+// Transforms vertex `index` into `vert`. With vertices == NULL the mesh's
+// packed vertices are used, and the current matrix must already include
+// ApplyDMSMeshDequantization.
+static inline void TransformDMSVertex(const DMSMesh* mesh, const DMSVertex* vertices, uint32_t index,
+                                      pvr_vertex_t* vert) {
+    if (vertices) {
+        const DMSVertex* v = &vertices[index];
+        mat_trans_single3_nomod(v->x, v->y, v->z, vert->x, vert->y, vert->z);
+        vert->u = v->u;
+        vert->v = v->v;
+    } else {
+        const DMSPackedVertex* p = &mesh->packedVertices[index];
+        mat_trans_single3_nomod((float)p->x, (float)p->y, (float)p->z, vert->x, vert->y, vert->z);
+        vert->u = mesh->uvOffset[0] + p->u * mesh->uvScale[0];
+        vert->v = mesh->uvOffset[1] + p->v * mesh->uvScale[1];
+    }
+}
+
+// Skins bind-pose vertex `index` of a skinned float mesh (mesh->vertices)
+// and transforms it into `vert` in one step, through its bone's entry of
+// the palette BuildDMSPalette() filled; animatedVertices are not used. The
+// entry is loaded into the matrix unit only when it differs from
+// *loadedBone, the previous vertex's, so start each mesh with
+// *loadedBone = -1. Packed meshes are not drawn this way: they keep
+// animatedVertices, which leave their dequantization in the matrix.
+static inline void SkinTransformDMSVertex(const DMSMesh* mesh, const Skeleton* skeleton, uint32_t index,
+                                          int* loadedBone, pvr_vertex_t* vert) {
+    const DMSVertex* v = &mesh->vertices[index];
+    int bone = skeleton->boneCount;     // Unweighted: the current matrix alone
+    if (v->boneWeight > 0.0f && v->boneId < skeleton->boneCount) bone = v->boneId;
+    if (bone != *loadedBone) {
+        mat_load(&skeleton->palette[bone]);
+        *loadedBone = bone;
+    }
+    TransformDMSVertex(mesh, mesh->vertices, index, vert);
+}
+
+// In-place image (strippy --image). Read whole into one block, or used where
+// it lies; tables hold offsets from the start of the image, and vertex
+// arrays start on 32-byte boundaries.
+#define DMS_IMAGE_MAGIC   0x49534D44  // "DMSI"
+#define DMS_IMAGE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // Image bytes
+    uint32_t meshCount, boneCount, animCount, textureCount;
+    uint32_t trackCount;            // Tracks of all clips together
+    uint32_t skinnedVertexCount;    // Vertices of skinned meshes that are not rigid
+    uint32_t packedVertexCount;     // Vertices of packed meshes
+} DMSImageHeader;
+
+typedef struct {
+    uint32_t vertexCount, indexCount;
+    int32_t textureId;
+    uint32_t vertexFormat;
+    uint32_t stripCount, indexSize, stripIndexCount, triangleCount;
+    uint32_t vertices;              // Offset of DMSVertex or DMSPackedVertex[vertexCount]
+    uint32_t stripLengths;          // Offset of uint32_t[stripCount]
+    uint32_t indices;               // Offset of indexCount indices of indexSize bytes
+    Vector3 positionOffset, positionScale;  // Packed meshes
+    float uvOffset[2], uvScale[2];
+    Vector3 center;                 // Bounding sphere
+    float radius;
+} DMSImageMesh;
+
+typedef struct {
+    char name[64];
+    int32_t parent;
+    Transform bindPose;
+    Matrix inverseBindMatrix;
+} DMSImageBone;
+
+typedef struct {
+    char name[32];
+    int32_t boneCount, frameCount;
+    float duration;
+    uint32_t encoding;
+    float timeStep;                 // Quantized clips
+    Vector3 translationMin, translationStep, scaleMin, scaleStep;
+    uint32_t dataCount;             // 32-bit words of float clips, 16-bit words of quantized ones
+    uint32_t data;                  // Offset: per track keyCount, times, values, or quantized words
+} DMSImageClip;
+
 // Model structure
 typedef struct {
     DMSMesh* meshes;
@@ -86,18 +312,45 @@ typedef struct {
     Skeleton* skeleton;
     kos_texture_t** textures;
     int textureCount;           // Number of textures
+    const uint8_t* image;       // In-place image the model points into; NULL for .dms streams
 } DMSModel;
 
 
 DMSModel* LoadDMSModel(const char* filename);
 
+// Loads only some sections (DMS_LOAD_*) of a v6 file, e.g. a skeleton and
+// its clips without meshes. Older files always load whole, but any stream
+// can leave out DMS_LOAD_SKINNING when float meshes are drawn with
+// SkinTransformDMSVertex(). Packed meshes and images always keep their
+// skinning results.
+DMSModel* LoadDMSModelSections(const char* filename, uint32_t sections);
+
+// Builds a model around an in-place image already in memory, e.g. a romdisk
+// file mapped with fs_mmap(). Only the model's own structs are allocated; the
+// image is used where it lies and has to outlive the model. Returns NULL when
+// the image is unsupported or damaged.
+DMSModel* LoadDMSModelImage(const void* image);
+
 
 
  
 void UpdateDMSModelAnimation(DMSModel* model, float deltaTime);
 
+// Skins the weighted vertices of a mesh into animatedVertices. Only needed
+// for CPU-side use of the positions; drawing can skin on the way instead.
 void UpdateDMSMeshAnimation(DMSMesh* mesh, const Skeleton* skeleton);
 
+// Fills skeleton->palette for drawing skinned meshes with
+// SkinTransformDMSVertex(): per bone, the current matrix times the bone's
+// skinning matrix, and at [boneCount] the current matrix alone for
+// unweighted vertices. Built once per draw of a model, for the boneSpace
+// of its meshes; the current matrix is left as it was.
+void BuildDMSPalette(Skeleton* skeleton, int boneSpace);
+
+// Expands a packed mesh into float vertices, for code that needs them. Not
+// for meshes of image models, whose packed vertices live in the image.
+void UnpackDMSMesh(DMSMesh* mesh);
+
 
 
 
@@ -27,6 +27,11 @@ matrix_t cam_pvm __attribute__((aligned(32)));
 
 DMSModel* dms_model = NULL;
 
+// Experimental: skin float meshes while drawing (SkinTransformDMSVertex)
+// instead of into animatedVertices. A switches between the two to compare
+// their cycle counts; bench/pvr_skinning compares them on the host.
+static bool fused_skinning = false;
+
 input_t input;
 
 /* PVR init params */
@@ -93,6 +98,18 @@ void DrawBoundingSphere(const Vector3* center, float radius, pvr_dr_state_t* dr_
 static pvr_vertex_t* global_vertex_buffer = NULL;
 static int global_vertex_buffer_size = 0;
 
+// Fused meshes through their bone's palette entry, the others through the
+// matrix already loaded
+static inline void transform_vertex(const DMSModel* model, const DMSMesh* mesh, const DMSVertex* srcVerts,
+                                    int fused, uint32_t idx, int* loaded_bone, pvr_vertex_t* vert)
+{
+    if (fused) {
+        SkinTransformDMSVertex(mesh, model->skeleton, idx, loaded_bone, vert);
+    } else {
+        TransformDMSVertex(mesh, srcVerts, idx, vert);
+    }
+}
+
 void DMS_Render(const DMSModel* model, matrix_t *pvm)
 {
    if (!model) return;
@@ -112,14 +129,24 @@ void DMS_Render(const DMSModel* model, matrix_t *pvm)
        global_vertex_buffer_size = max_verts;
    }
 
+   // Fused meshes share one bone palette on the view-projection, built for
+   // the first one and again only if a mesh differs in boneSpace
+   int palette_bone_space = -1;
+
    for (int m = 0; m < model->meshCount; m++) {
        const DMSMesh* mesh = &model->meshes[m];
-       if (!mesh->vertices || mesh->vertexCount <= 0 || mesh->indexCount <= 0)
+       if ((!mesh->vertices && !mesh->packedVertices) || mesh->vertexCount <= 0 || mesh->indexCount <= 0)
            continue;
 
+       // NULL for static and rigid packed meshes, which TransformDMSVertex
+       // reads packed. Rigid meshes have no animatedVertices, and fused
+       // float meshes skin their bind pose here instead of reading them.
        const DMSVertex* srcVerts = mesh->animatedVertices
                                  ? mesh->animatedVertices
                                  : mesh->vertices;
+       int rigid = model->skeleton && mesh->rigidBone >= 0;
+       int fused = model->skeleton && !rigid && mesh->vertices && (fused_skinning || !mesh->animatedVertices);
+       int loaded_bone = -1;
 
        // Pre-compute final matrix once
        {
@@ -135,9 +162,17 @@ void DMS_Render(const DMSModel* model, matrix_t *pvm)
        }
 
  
+    // A rigid mesh is drawn through its bone's matrix, and its bind-pose
+    // sphere moves with the bone: back to bone space, then through the bone
+    Vector3 center = mesh->boundingCenter;
+    if (rigid) {
+        ApplyDMSMeshBone(mesh, model->skeleton);
+        center = Vector3Transform(center, model->skeleton->bones[mesh->rigidBone].inverseBindMatrix);
+    }
+
     bool need_clipping = false;
     float x, y, z, w;
-    mat_trans_nodiv_nomod(mesh->boundingCenter.x, mesh->boundingCenter.y, mesh->boundingCenter.z, 
+    mat_trans_nodiv_nomod(center.x, center.y, center.z, 
                         x, y, z, w);
 
 
@@ -150,6 +185,17 @@ void DMS_Render(const DMSModel* model, matrix_t *pvm)
         need_clipping = true;
     }  
 
+    // Fold a packed mesh's dequantization into the matrix. Fused meshes
+    // are float ones, so their shared palette needs none.
+    if (fused && mesh->boneSpace != palette_bone_space) {
+        PROFILE_START_CYCLES();
+        BuildDMSPalette(model->skeleton, mesh->boneSpace);
+        palette_bone_space = mesh->boneSpace;
+        PROFILE_END_CYCLES(g_profiles.palette);
+    } else if (!fused && !srcVerts) {
+        ApplyDMSMeshDequantization(mesh);
+    }
+
 
 
        pvr_poly_cxt_t cxt;
@@ -184,14 +230,9 @@ void DMS_Render(const DMSModel* model, matrix_t *pvm)
                PROFILE_START_CYCLES();
                
                for (int i = 0; i < mesh->vertexCount; i++) {
-                   mat_trans_single3_nomod(srcVerts[i].x, srcVerts[i].y, srcVerts[i].z, 
-                                         global_vertex_buffer[i].x,
-                                         global_vertex_buffer[i].y,
-                                         global_vertex_buffer[i].z);
+                   transform_vertex(model, mesh, srcVerts, fused, i, &loaded_bone, &global_vertex_buffer[i]);
                    
                    global_vertex_buffer[i].flags = PVR_CMD_VERTEX;
-                   global_vertex_buffer[i].u = srcVerts[i].u;
-                   global_vertex_buffer[i].v = srcVerts[i].v;
                    global_vertex_buffer[i].argb = 0xFFFFFFFF;
                }
                
@@ -200,7 +241,7 @@ void DMS_Render(const DMSModel* model, matrix_t *pvm)
            
            {
                PROFILE_START_CYCLES();
-               primitive_nclip_polygon_strip(global_vertex_buffer, (int*)mesh->indices, mesh->indexCount, &dr_state);
+               primitive_nclip_polygon_strip(global_vertex_buffer, mesh, &dr_state);
                PROFILE_END_CYCLES(g_profiles.clipping);
            }
        } else {
@@ -209,75 +250,49 @@ void DMS_Render(const DMSModel* model, matrix_t *pvm)
                PROFILE_START_CYCLES();
            
                int i = 0;
-               while (i < mesh->indexCount) {
-                   uint32_t rawIndex = mesh->indices[i];
-                   int isStrip = (rawIndex & 0x80000000) != 0;
-                   uint32_t sId = (rawIndex >> 24) & 0x7F;
-
-                   if (isStrip) {
-                       int stripLength = 0;
-                       while ((i + stripLength) < mesh->indexCount) {
-                           rawIndex = mesh->indices[i + stripLength];
-                           if (!(rawIndex & 0x80000000) || ((rawIndex >> 24) & 0x7F) != sId)
-                               break;
-                           stripLength++;
-                       }
-
-                       for (int j = 0; j < stripLength; j++) {
-                           uint32_t idx = mesh->indices[i + j] & 0x00FFFFFF;
-                           const DMSVertex* v = &srcVerts[idx];
-                           
-                           pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
-                           vert->flags = (j == stripLength - 1) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
-                           
-                           mat_trans_single3_nomod(v->x, v->y, v->z, vert->x, vert->y, vert->z);
-                           vert->u = v->u;
-                           vert->v = v->v;
-                           vert->argb = 0xFFFFFFFF;
-                           
-                           pvr_dr_commit(vert);
-                       }
+               // Strips straight from the strip table
+               for (int s = 0; s < mesh->stripCount; s++) {
+                   int stripLength = mesh->stripLengths[s];
+                   for (int j = 0; j < stripLength; j++) {
+                       uint32_t idx = DMSMeshIndex(mesh, i + j);
                        
-                       i += stripLength;
-                   } else {
-                       if (i + 2 < mesh->indexCount) {
-                           uint32_t idx1 = mesh->indices[i] & 0x00FFFFFF;
-                           uint32_t idx2 = mesh->indices[i+1] & 0x00FFFFFF;
-                           uint32_t idx3 = mesh->indices[i+2] & 0x00FFFFFF;
-                           
-                           const DMSVertex* v1 = &srcVerts[idx1];
-                           const DMSVertex* v2 = &srcVerts[idx2];
-                           const DMSVertex* v3 = &srcVerts[idx3];
-                           
-                           pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
-                           vert->flags = PVR_CMD_VERTEX;
-                           mat_trans_single3_nomod(v1->x, v1->y, v1->z, vert->x, vert->y, vert->z);
-                           vert->u = v1->u;
-                           vert->v = v1->v;
-                           vert->argb = 0xFFFFFFFF;
-                           pvr_dr_commit(vert);
-                           
-                           vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
-                           vert->flags = PVR_CMD_VERTEX;
-                           mat_trans_single3_nomod(v2->x, v2->y, v2->z, vert->x, vert->y, vert->z);
-                           vert->u = v2->u;
-                           vert->v = v2->v;
-                           vert->argb = 0xFFFFFFFF;
-                           pvr_dr_commit(vert);
-                           
-                           vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
-                           vert->flags = PVR_CMD_VERTEX_EOL;
-                           mat_trans_single3_nomod(v3->x, v3->y, v3->z, vert->x, vert->y, vert->z);
-                           vert->u = v3->u;
-                           vert->v = v3->v;
-                           vert->argb = 0xFFFFFFFF;
-                           pvr_dr_commit(vert);
-                           
-                           i += 3;
-                       } else {
-                           i++;
-                       }
+                       pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
+                       vert->flags = (j == stripLength - 1) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+                       
+                       transform_vertex(model, mesh, srcVerts, fused, idx, &loaded_bone, vert);
+                       vert->argb = 0xFFFFFFFF;
+                       
+                       pvr_dr_commit(vert);
                    }
+                   
+                   i += stripLength;
+               }
+
+               // Then the triangle list
+               while (i + 2 < mesh->indexCount) {
+                   uint32_t idx1 = DMSMeshIndex(mesh, i);
+                   uint32_t idx2 = DMSMeshIndex(mesh, i+1);
+                   uint32_t idx3 = DMSMeshIndex(mesh, i+2);
+                   
+                   pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
+                   vert->flags = PVR_CMD_VERTEX;
+                   transform_vertex(model, mesh, srcVerts, fused, idx1, &loaded_bone, vert);
+                   vert->argb = 0xFFFFFFFF;
+                   pvr_dr_commit(vert);
+                   
+                   vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
+                   vert->flags = PVR_CMD_VERTEX;
+                   transform_vertex(model, mesh, srcVerts, fused, idx2, &loaded_bone, vert);
+                   vert->argb = 0xFFFFFFFF;
+                   pvr_dr_commit(vert);
+                   
+                   vert = (pvr_vertex_t *)pvr_dr_target(dr_state);
+                   vert->flags = PVR_CMD_VERTEX_EOL;
+                   transform_vertex(model, mesh, srcVerts, fused, idx3, &loaded_bone, vert);
+                   vert->argb = 0xFFFFFFFF;
+                   pvr_dr_commit(vert);
+                   
+                   i += 3;
                }
                
                PROFILE_END_CYCLES(g_profiles.vertex_submit);
@@ -408,6 +423,13 @@ static void game_update(void)
 {
     Input_Update(&input);
     set_camera(&cam_pvm, &input);
+
+    input_device_state cont;
+    if (Input_GetState(&input, &cont) && cont.a == 1) {
+        fused_skinning = !fused_skinning;
+        printf("Skinning: %s\n", fused_skinning ? "fused into the draw" : "animatedVertices, then draw");
+        perf_profile_reset();
+    }
 }
 
 static void game_draw(void)
@@ -415,15 +437,27 @@ static void game_draw(void)
     if (dms_model && dms_model->meshCount > 0) {
         if (dms_model->meshes[0].vertexCount > 0 && dms_model->meshes[0].indexCount > 0) {
              if (dms_model->skeleton && dms_model->skeleton->animCount > 0) {
-                PROFILE_START_CYCLES();
-                
-                float dt = 1.0f / 60.0f;
-                UpdateDMSModelAnimation(dms_model, dt);
-                for (int i = 0; i < dms_model->meshCount; i++) {
-                    UpdateDMSMeshAnimation(&dms_model->meshes[i], dms_model->skeleton);
+                {
+                    PROFILE_START_CYCLES();
+
+                    float dt = 1.0f / 60.0f;
+                    UpdateDMSModelAnimation(dms_model, dt);
+
+                    PROFILE_END_CYCLES(g_profiles.animation);
+                }
+
+                // The fused path skins float meshes inside DMS_Render
+                // instead; packed ones are always skinned here
+                {
+                    PROFILE_START_CYCLES();
+
+                    for (int i = 0; i < dms_model->meshCount; i++) {
+                        if (fused_skinning && dms_model->meshes[i].vertices) continue;
+                        UpdateDMSMeshAnimation(&dms_model->meshes[i], dms_model->skeleton);
+                    }
+
+                    PROFILE_END_CYCLES(g_profiles.skinning);
                 }
-                
-                PROFILE_END_CYCLES(g_profiles.animation);
             }
             DMS_Render(dms_model, &cam_pvm);
         }
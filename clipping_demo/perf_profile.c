@@ -14,6 +14,8 @@ void perf_profile_init(void) {
     g_profiles.total_frame.name = "Total Frame";
     g_profiles.animation.name = "Skeletal Animation";
     g_profiles.header_setup.name = "Header Setup";
+    g_profiles.skinning.name = "CPU Skinning";
+    g_profiles.palette.name = "Bone Palette";
 }
 
 void perf_profile_print(void) {
@@ -22,13 +24,15 @@ void perf_profile_print(void) {
     perf_profile_t* profiles[] = {
         &g_profiles.total_frame,
         &g_profiles.animation,
+        &g_profiles.skinning,
+        &g_profiles.palette,
         &g_profiles.transform,
         &g_profiles.clipping,
         &g_profiles.vertex_submit,
         &g_profiles.header_setup
     };
     
-    for (int i = 0; i < 6; i++) {
+    for (int i = 0; i < 8; i++) {
         perf_profile_t* p = profiles[i];
         if (p->calls > 0) {
             uint64_t avg_cycles = p->cycles / p->calls;
@@ -43,7 +47,7 @@ void perf_profile_print(void) {
         printf("\n--- Breakdown ---\n");
         uint64_t total = g_profiles.total_frame.cycles / g_profiles.total_frame.calls;
         
-        for (int i = 1; i < 6; i++) {
+        for (int i = 1; i < 8; i++) {
             perf_profile_t* p = profiles[i];
             if (p->calls > 0) {
                 uint64_t avg = p->cycles / p->calls;
@@ -58,13 +62,15 @@ void perf_profile_reset(void) {
     perf_profile_t* profiles[] = {
         &g_profiles.total_frame,
         &g_profiles.animation,
+        &g_profiles.skinning,
+        &g_profiles.palette,
         &g_profiles.transform,
         &g_profiles.clipping,
         &g_profiles.vertex_submit,
         &g_profiles.header_setup
     };
     
-    for (int i = 0; i < 6; i++) {
+    for (int i = 0; i < 8; i++) {
         profiles[i]->cycles = 0;
         profiles[i]->cache_misses = 0;
         profiles[i]->calls = 0;
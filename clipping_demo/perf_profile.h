@@ -24,6 +24,8 @@ typedef struct {
     perf_profile_t scene_begin;
     perf_profile_t scene_finish;
     perf_profile_t matrix_ops;
+    perf_profile_t skinning;
+    perf_profile_t palette;
 } render_profiles_t;
 
 extern render_profiles_t g_profiles;
@@ -164,306 +164,149 @@ int primitive_nclip_polygon(pvr_vertex_t *vertex_list, int *index_list, int inde
 	return commit_vertex;
 }
 
-int primitive_nclip_polygon_strip(pvr_vertex_t *vlist, int *dmsIndices, int dmsCount, pvr_dr_state_t *dr_state_ptr)
+/* Near-Z clips one strip of len >= 3 vertex indices and commits it. */
+static int nclip_strip(polygon_vertex_t *p, int *idx, int len)
 {
- 
-
-     polygon_vertex_t *p = (polygon_vertex_t *)vlist;
     int commit_vertex = 0;
-    int i = 0;
+    int clip = 0;
+    int sub_i = 0;
+    int chunkLen = len;
+
+    /* First and Second point. */
+    if ((1.0f / p[*idx++].z) >= NEAR_Z)
+    {
+        if ((1.0f / p[*idx++].z) >= NEAR_Z)
+        {
+            /* 0, 1 inside */
+            prim_commit_poly_vert(&p[idx[-2]], 0);
+            prim_commit_poly_vert(&p[idx[-1]], 0);
+            commit_vertex += 2;
+            clip = 3;
+        }
+        else
+        {
+            /* 0 inside, 1 outside */
+            prim_commit_poly_vert(&p[idx[-2]], 0);
+            prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
+            commit_vertex += 2;
+            clip = 1;
+        }
+    }
+    else
+    {
+        if ((1.0f / p[*idx++].z) >= NEAR_Z)
+        {
+            /* 0 outside, 1 inside */
+            prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
+            prim_commit_poly_vert(&p[idx[-1]], 0);
+            commit_vertex += 2;
+            clip = 2;
+        }
+    }
 
-    /*   parse the dmsIndices[] chunk by chunk. */
-    while (i < dmsCount)
+    /* Third point and more. */
+    for (sub_i = 3; sub_i <= chunkLen; sub_i++)
     {
-        uint32_t rawIdx = (uint32_t)dmsIndices[i];
-        int isStrip = (rawIdx & 0x80000000) != 0;
+        int eos = 0;
+        if (sub_i == chunkLen)
+            eos = 1; /* end of strip */
 
-        if (isStrip)
+        if ((1.0f / p[*idx++].z) >= NEAR_Z)
+            clip |= (1 << 2);
+
+        switch (clip)
         {
-            /*--------------------------
-              TRIANGLE STRIP CHUNK
-            --------------------------*/
-            uint32_t sId = (rawIdx >> 24) & 0x7F;  
-            int stripLen = 0;
-
-            /* Count how many consecutive indices belong to this strip. */
-            while ((i + stripLen) < dmsCount)
+        case 1: /* 0 in, 1 & 2 out */
+            prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 1);
+            commit_vertex++;
+            break;
+        case 2: /* 0 out, 1 in, 2 out */
+            prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], eos);
+            commit_vertex++;
+            break;
+        case 3: /* 0 & 1 in, 2 out */
+            prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
+            prim_commit_poly_vert(&p[idx[-2]], 0);
+            prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], eos);
+            commit_vertex += 3;
+            break;
+        case 4: /* 0 & 1 out, 2 in */
+            prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
+            if (!(sub_i & 0x01))
             {
-                uint32_t r2 = (uint32_t)dmsIndices[i + stripLen];
-                int r2Strip = (r2 & 0x80000000) != 0;
-                uint32_t r2sId = (r2 >> 24) & 0x7F;
-                if (!r2Strip || (r2sId != sId))
-                    break;
-                stripLen++;
+                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
+                commit_vertex++;
             }
+            prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
+            prim_commit_poly_vert(&p[idx[-1]], eos);
+            commit_vertex += 3;
+            break;
+        case 5: /* 0 in, 1 out, 2 in */
+            prim_commit_poly_vert(&p[idx[-1]], 0);
+            prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
+            prim_commit_poly_vert(&p[idx[-1]], eos);
+            commit_vertex += 3;
+            break;
+        case 6: /* 0 out, 1 & 2 in */
+            prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
+            prim_commit_poly_vert(&p[idx[-2]], 0);
+            prim_commit_poly_vert(&p[idx[-1]], eos);
+            commit_vertex += 3;
+            break;
+        case 7: /* all in */
+            prim_commit_poly_vert(&p[idx[-1]], eos);
+            commit_vertex++;
+            break;
+        default:
+            break;
+        }
 
-            /* 
-               We'll store them in a local "count-based" array:
-                 [stripLen, idx1, idx2, ..., idxN]
-               Then run the near-plane clipping logic on it.
-            */
-            if (stripLen >= 2)
-            {
-                /* small local array for just this strip */
-                int tmpSize = stripLen + 1;
-                /* prob a issue if largest strip is over this but  unlikely*/
-                int stripArray[2048];  
-
-                /* Fill in "count-based" format */
-                stripArray[0] = stripLen;
-                for (int j = 0; j < stripLen; j++)
-                {
-                    stripArray[1 + j] = (int)(dmsIndices[i + j] & 0x00FFFFFF);
-                }
-
-              
-                {
-                    /* local copy to parse */
-                    int *idx = stripArray;
-                    int idxSize = tmpSize;
-
-                    while (idxSize)
-                    {
-                        int clip = 0;
-                        int chunkLen = 0;
-                        int sub_i = 0;
-
-                        /* chunkLen = stripArray[0]; then skip it */
-                        chunkLen = *idx++;
-                        idxSize -= (chunkLen + 1);
-                        if (chunkLen < 2)
-                        {
-                            idx += chunkLen;
-                            continue;
-                        }
-
-                        /* First and Second point. */
-                        if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                        {
-                            if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                            {
-                                /* 0, 1 inside */
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], 0);
-                                commit_vertex += 2;
-                                clip = 3;
-                            }
-                            else
-                            {
-                                /* 0 inside, 1 outside */
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                commit_vertex += 2;
-                                clip = 1;
-                            }
-                        }
-                        else
-                        {
-                            if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                            {
-                                /* 0 outside, 1 inside */
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], 0);
-                                commit_vertex += 2;
-                                clip = 2;
-                            }
-                        }
-
-                        /* Third point and more. */
-                        for (sub_i = 3; sub_i <= chunkLen; sub_i++)
-                        {
-                            int eos = 0;
-                            if (sub_i == chunkLen)
-                                eos = 1; /* end of strip */
-
-                            if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                                clip |= (1 << 2);
-
-                            switch (clip)
-                            {
-                            case 1: /* 0 in, 1 & 2 out */
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 1);
-                                commit_vertex++;
-                                break;
-                            case 2: /* 0 out, 1 in, 2 out */
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], eos);
-                                commit_vertex++;
-                                break;
-                            case 3: /* 0 & 1 in, 2 out */
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 4: /* 0 & 1 out, 2 in */
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                if (!(sub_i & 0x01))
-                                {
-                                    prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                    commit_vertex++;
-                                }
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 5: /* 0 in, 1 out, 2 in */
-                                prim_commit_poly_vert(&p[idx[-1]], 0);
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 6: /* 0 out, 1 & 2 in */
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 7: /* all in */
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex++;
-                                break;
-                            default:
-                                break;
-                            }
-
-                            clip >>= 1;
-                        }
-                    }
-                }
-            }
+        clip >>= 1;
+    }
 
-            i += stripLen;
-        }
-        else
+    return commit_vertex;
+}
+
+/* Longest run of a strip clipped in one go; even, so windows keep the
+   strip's winding. */
+#define STRIP_WINDOW 2048
+
+int primitive_nclip_polygon_strip(pvr_vertex_t *vlist, const DMSMesh *mesh, pvr_dr_state_t *dr_state_ptr)
+{
+    polygon_vertex_t *p = (polygon_vertex_t *)vlist;
+    int commit_vertex = 0;
+    int i = 0;
+    int idx[STRIP_WINDOW];
+
+    /* Strips straight from the strip table. Longer ones are clipped in
+       windows that overlap by two indices. */
+    for (int s = 0; s < mesh->stripCount; s++)
+    {
+        int stripLen = mesh->stripLengths[s];
+
+        for (int start = 0; start + 2 < stripLen; start += STRIP_WINDOW - 2)
         {
-            /*--------------------------
-              TRIANGLE (3 verts)
-            --------------------------*/
-            if (i + 2 < dmsCount)
-            {
-                /*  handle  like a "strip" of length=3 
-                   in a local array: [3, v1, v2, v3]
-                */
-                int triArray[4];
-                triArray[0] = 3;
-                triArray[1] = (int)(dmsIndices[i]   & 0x00FFFFFF);
-                triArray[2] = (int)(dmsIndices[i+1] & 0x00FFFFFF);
-                triArray[3] = (int)(dmsIndices[i+2] & 0x00FFFFFF);
-
-             
-                {
-                    int *idx = triArray;
-                    int idxSize = 4;
-
-                    while (idxSize)
-                    {
-                        int clip = 0;
-                        int chunkLen = 0;
-                        int sub_i = 0;
-
-                        chunkLen = *idx++;
-                        idxSize -= (chunkLen + 1);
-                        if (chunkLen < 2)
-                        {
-                            idx += chunkLen;
-                            continue;
-                        }
-
-                         if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                        {
-                            if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                            {
-                                /* 0,1 in */
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], 0);
-                                commit_vertex += 2;
-                                clip = 3;
-                            }
-                            else
-                            {
-                                /* 0 in, 1 out */
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                commit_vertex += 2;
-                                clip = 1;
-                            }
-                        }
-                        else
-                        {
-                            if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                            {
-                                /* 0 out, 1 in */
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], 0);
-                                commit_vertex += 2;
-                                clip = 2;
-                            }
-                        }
-
-                        for (sub_i = 3; sub_i <= chunkLen; sub_i++)
-                        {
-                            int eos = (sub_i == chunkLen) ? 1 : 0;
-                            if ((1.0f / p[*idx++].z) >= NEAR_Z)
-                                clip |= (1 << 2);
-
-                            switch (clip)
-                            {
-                            case 1:
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 1);
-                                commit_vertex++;
-                                break;
-                            case 2:
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], eos);
-                                commit_vertex++;
-                                break;
-                            case 3:
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 4:
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                if (!(sub_i & 0x01))
-                                {
-                                    prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                    commit_vertex++;
-                                }
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 5:
-                                prim_commit_poly_vert(&p[idx[-1]], 0);
-                                prim_commit_poly_inter(&p[idx[-2]], &p[idx[-1]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 6:
-                                prim_commit_poly_inter(&p[idx[-1]], &p[idx[-3]], 0);
-                                prim_commit_poly_vert(&p[idx[-2]], 0);
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex += 3;
-                                break;
-                            case 7:
-                                prim_commit_poly_vert(&p[idx[-1]], eos);
-                                commit_vertex++;
-                                break;
-                            default:
-                                break;
-                            }
-                            clip >>= 1;
-                        }
-                    }
-                }
-
-                i += 3;
-            }
-            else
-            {
-                i++;
-            }
+            int len = stripLen - start;
+            if (len > STRIP_WINDOW)
+                len = STRIP_WINDOW;
+
+            for (int j = 0; j < len; j++)
+                idx[j] = (int)DMSMeshIndex(mesh, i + start + j);
+
+            commit_vertex += nclip_strip(p, idx, len);
         }
+
+        i += stripLen;
+    }
+
+    /* Then the triangle list, each triangle as a strip of three. */
+    while (i + 2 < mesh->indexCount)
+    {
+        idx[0] = (int)DMSMeshIndex(mesh, i);
+        idx[1] = (int)DMSMeshIndex(mesh, i + 1);
+        idx[2] = (int)DMSMeshIndex(mesh, i + 2);
+        commit_vertex += nclip_strip(p, idx, 3);
+        i += 3;
     }
 
     return commit_vertex;
@@ -493,77 +336,38 @@ int primitive_polygon(pvr_vertex_t *vertex_list, int *index_list, int index_size
 	return index_size;
 }
 
-int primitive_polygon_strip(pvr_vertex_t *vertex_list, int *index_list, int index_size, pvr_dr_state_t *dr_state_ptr)
+int primitive_polygon_strip(pvr_vertex_t *vertex_list, const DMSMesh *mesh, pvr_dr_state_t *dr_state_ptr)
 {
     polygon_vertex_t *p = (polygon_vertex_t *)vertex_list;
     int commit_vertex = 0;
     int i = 0;
 
-    /* Check size */
- 
-
-    while (i < index_size)
+    /* Strips straight from the strip table, without near Z clipping */
+    for (int s = 0; s < mesh->stripCount; s++)
     {
-        uint32_t rawIdx = (uint32_t)index_list[i];
-        int isStrip = (rawIdx & 0x80000000) != 0;
+        int stripLen = mesh->stripLengths[s];
 
-        if (isStrip)
+        if (stripLen >= 2)
         {
-            /*--------------------------
-              TRIANGLE STRIP CHUNK
-            --------------------------*/
-            uint32_t sId = (rawIdx >> 24) & 0x7F;  
-            int stripLen = 0;
-
-            /* Count how many consecutive indices belong to this strip. */
-            while ((i + stripLen) < index_size)
+            for (int j = 0; j < stripLen; j++)
             {
-                uint32_t r2 = (uint32_t)index_list[i + stripLen];
-                int r2Strip = (r2 & 0x80000000) != 0;
-                uint32_t r2sId = (r2 >> 24) & 0x7F;
-                if (!r2Strip || (r2sId != sId))
-                    break;
-                stripLen++;
+                int eos = (j == stripLen - 1) ? 1 : 0;
+                prim_commit_poly_vert(&p[DMSMeshIndex(mesh, i + j)], eos);
+                commit_vertex++;
             }
+        }
 
-            if (stripLen >= 2)
-            {
-                /* Process the strip directly without near Z clipping */
-                for (int j = 0; j < stripLen; j++)
-                {
-                    int idx = (int)(index_list[i + j] & 0x00FFFFFF);
-                    int eos = (j == stripLen - 1) ? 1 : 0;
-                    
-                    prim_commit_poly_vert(&p[idx], eos);
-                    commit_vertex++;
-                }
-            }
+        i += stripLen;
+    }
 
-            i += stripLen;
-        }
-        else
-        {
-            /*--------------------------
-              TRIANGLE (3 verts)
-            --------------------------*/
-            if (i + 2 < index_size)
-            {
-                int idx1 = (int)(index_list[i] & 0x00FFFFFF);
-                int idx2 = (int)(index_list[i+1] & 0x00FFFFFF);
-                int idx3 = (int)(index_list[i+2] & 0x00FFFFFF);
-                
-                prim_commit_poly_vert(&p[idx1], 0);
-                prim_commit_poly_vert(&p[idx2], 0);
-                prim_commit_poly_vert(&p[idx3], 1);
-                commit_vertex += 3;
-                
-                i += 3;
-            }
-            else
-            {
-                i++;
-            }
-        }
+    /* Then the triangle list */
+    while (i + 2 < mesh->indexCount)
+    {
+        prim_commit_poly_vert(&p[DMSMeshIndex(mesh, i)], 0);
+        prim_commit_poly_vert(&p[DMSMeshIndex(mesh, i + 1)], 0);
+        prim_commit_poly_vert(&p[DMSMeshIndex(mesh, i + 2)], 1);
+        commit_vertex += 3;
+        i += 3;
     }
 
     return commit_vertex;
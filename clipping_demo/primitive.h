@@ -1,6 +1,8 @@
 #ifndef _PRIM_H_INCLUDED_
 #define _PRIM_H_INCLUDED_
 
+#include "dms.h"
+
 
 typedef union {
     unsigned int color;
@@ -42,11 +44,11 @@ extern void primitive_buffer_flush(void);
 int primitive_header(void *header, int size, pvr_dr_state_t *dr_state_ptr);
 
 extern int primitive_nclip_polygon(pvr_vertex_t *vertex_list, int *index_list, int index_size);
-extern int primitive_nclip_polygon_strip(pvr_vertex_t *vlist, int *dmsIndices, int dmsCount, pvr_dr_state_t *dr_state_ptr);
+extern int primitive_nclip_polygon_strip(pvr_vertex_t *vlist, const DMSMesh *mesh, pvr_dr_state_t *dr_state_ptr);
 
 
 extern int primitive_polygon(pvr_vertex_t *vertex_list, int *index_list, int index_size);
-extern int primitive_polygon_strip(pvr_vertex_t *vertex_list, int *index_list, int index_size, pvr_dr_state_t *dr_state_ptr);
+extern int primitive_polygon_strip(pvr_vertex_t *vertex_list, const DMSMesh *mesh, pvr_dr_state_t *dr_state_ptr);
 
 
 extern int prim_commit_vert_ready(int size);
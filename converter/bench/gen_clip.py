@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+# Writes a synthetic skinned .glb for converter timing: a chain of BONES bones,
+# one triangle weighted to each, and a single clip of SECONDS keyed at RATE Hz
+# with a rotation and a translation channel per bone.
+#
+#   python3 gen_clip.py out.glb BONES SECONDS RATE
+import json
+import math
+import struct
+import sys
+
+
+def main():
+    if len(sys.argv) != 5:
+        sys.exit("usage: gen_clip.py out.glb bones seconds rate")
+    out = sys.argv[1]
+    bones, seconds, rate = int(sys.argv[2]), float(sys.argv[3]), float(sys.argv[4])
+    keys = int(seconds * rate) + 1
+
+    blob = bytearray()
+    views = []
+    accessors = []
+
+    def add(data, component, kind, count, bounds=None):
+        while len(blob) % 4:
+            blob.append(0)
+        views.append({"buffer": 0, "byteOffset": len(blob), "byteLength": len(data)})
+        blob.extend(data)
+        accessor = {"bufferView": len(views) - 1, "componentType": component, "type": kind, "count": count}
+        if bounds:
+            accessor["min"], accessor["max"] = bounds
+        accessors.append(accessor)
+        return len(accessors) - 1
+
+    # One triangle per bone, fully weighted to it
+    positions, indices, joints, weights = [], [], [], []
+    for b in range(bones):
+        base = len(positions) // 3
+        positions += [0, b, 0, 1, b, 0, 0, b + 1, 0]
+        indices += [base, base + 1, base + 2]
+        joints += [b, 0, 0, 0] * 3
+        weights += [1, 0, 0, 0] * 3
+    position = add(struct.pack("<%df" % len(positions), *positions), 5126, "VEC3",
+                   len(positions) // 3, ([0, 0, 0], [1, bones + 1, 0]))
+    index = add(struct.pack("<%dI" % len(indices), *indices), 5125, "SCALAR", len(indices))
+    joint = add(struct.pack("<%dH" % len(joints), *joints), 5123, "VEC4", len(joints) // 4)
+    weight = add(struct.pack("<%df" % len(weights), *weights), 5126, "VEC4", len(weights) // 4)
+
+    inverse_binds = []
+    for b in range(bones):
+        inverse_binds += [1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, -b, 0, 1]
+    inverse_bind = add(struct.pack("<%df" % len(inverse_binds), *inverse_binds), 5126, "MAT4", bones)
+
+    times = [k / rate for k in range(keys)]
+    time = add(struct.pack("<%df" % keys, *times), 5126, "SCALAR", keys, ([0], [times[-1]]))
+
+    # Every bone sways at a slightly different frequency, so no two tracks fit alike
+    channels, samplers = [], []
+    for b in range(bones):
+        rotation, translation = [], []
+        for t in times:
+            angle = 0.5 * math.sin(t * (0.7 + 0.01 * b))
+            rotation += [0, 0, math.sin(angle / 2), math.cos(angle / 2)]
+            translation += [0.1 * math.sin(t * 1.3 + b), 1 if b else 0, 0]
+        r = add(struct.pack("<%df" % len(rotation), *rotation), 5126, "VEC4", keys)
+        t = add(struct.pack("<%df" % len(translation), *translation), 5126, "VEC3", keys)
+        samplers += [{"input": time, "output": r}, {"input": time, "output": t}]
+        channels += [{"sampler": 2 * b, "target": {"node": b + 1, "path": "rotation"}},
+                     {"sampler": 2 * b + 1, "target": {"node": b + 1, "path": "translation"}}]
+
+    nodes = [{"mesh": 0, "skin": 0}]
+    for b in range(bones):
+        node = {"name": "bone%d" % b, "translation": [0, 1 if b else 0, 0]}
+        if b + 1 < bones:
+            node["children"] = [b + 2]
+        nodes.append(node)
+
+    gltf = {
+        "asset": {"version": "2.0"},
+        "scene": 0,
+        "scenes": [{"nodes": [0, 1]}],
+        "nodes": nodes,
+        "meshes": [{"primitives": [{"attributes": {"POSITION": position, "JOINTS_0": joint,
+                                                   "WEIGHTS_0": weight}, "indices": index}]}],
+        "skins": [{"joints": list(range(1, bones + 1)), "inverseBindMatrices": inverse_bind}],
+        "animations": [{"name": "mocap", "channels": channels, "samplers": samplers}],
+        "buffers": [{"byteLength": len(blob)}],
+        "bufferViews": views,
+        "accessors": accessors,
+    }
+
+    text = json.dumps(gltf).encode()
+    text += b" " * ((4 - len(text) % 4) % 4)
+    while len(blob) % 4:
+        blob.append(0)
+    with open(out, "wb") as f:
+        f.write(struct.pack("<III", 0x46546C67, 2, 12 + 8 + len(text) + 8 + len(blob)))
+        f.write(struct.pack("<II", len(text), 0x4E4F534A) + text)
+        f.write(struct.pack("<II", len(blob), 0x004E4942) + bytes(blob))
+
+
+if __name__ == "__main__":
+    main()
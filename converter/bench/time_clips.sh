@@ -0,0 +1,29 @@
+#!/bin/sh
+# Times single-threaded conversion of synthetic 100-bone clips, one and ten
+# minutes long at 30 Hz. Pass another strippy build to compare against it.
+#
+#   sh bench/time_clips.sh [strippy] [baseline-strippy]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+STRIPPY=${1:-$HERE/../strippy}
+BASELINE=$2
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+elapsed() {
+	start=$(date +%s.%N)
+	"$1" -j1 -o - "$2" >/dev/null 2>&1
+	end=$(date +%s.%N)
+	echo "$start $end" | awk '{ printf "%.3f", $2 - $1 }'
+}
+
+for minutes in 1 10; do
+	glb=$WORK/clip_${minutes}m.glb
+	python3 "$HERE/gen_clip.py" "$glb" 100 $((minutes * 60)) 30
+	line="${minutes} min, 100 bones: $(elapsed "$STRIPPY" "$glb") s"
+	if [ -n "$BASELINE" ]; then
+		line="$line (baseline $(elapsed "$BASELINE" "$glb") s)"
+	fi
+	echo "$line"
+done
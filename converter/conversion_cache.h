@@ -0,0 +1,186 @@
+#ifndef CONVERSION_CACHE_H
+#define CONVERSION_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// On-disk cache of finished .dms files. An entry is keyed by a hash of the
+// input file bytes and the converter settings, and records the external
+// buffers the input referenced together with their hashes, so a hit can be
+// validated without parsing the glTF.
+class ConversionCache {
+public:
+    struct Dependency {
+        std::string uri;    // As written in the glTF, relative to the input's directory
+        uint64_t hash;
+    };
+
+    struct Entry {
+        uint64_t triangles;
+        uint64_t strips;
+        std::vector<Dependency> dependencies;
+        std::vector<uint8_t> dms;
+    };
+
+    explicit ConversionCache(const std::string& directory) : directory(directory) {}
+
+    // 64-bit Murmur-style hash; `seed` chains several inputs into one key
+    static uint64_t Hash(const void* data, size_t size, uint64_t seed = 0) {
+        const uint64_t c1 = 0x87C37B91114253D5ull;
+        const uint64_t c2 = 0x4CF5AD432745937Full;
+        const uint8_t* bytes = (const uint8_t*)data;
+        uint64_t h = seed ^ (size * 0x9E3779B97F4A7C15ull);
+
+        size_t words = size / 8;
+        for (size_t i = 0; i < words; i++) {
+            uint64_t k;
+            memcpy(&k, bytes + i * 8, 8);
+            k *= c1; k = Rotl(k, 31); k *= c2;
+            h ^= k;
+            h = Rotl(h, 27) * 5 + 0x52DCE729;
+        }
+
+        uint64_t tail = 0;
+        memcpy(&tail, bytes + words * 8, size & 7);
+        tail *= c1; tail = Rotl(tail, 31); tail *= c2;
+        h ^= tail;
+
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>* bytes) {
+        FILE* file = fopen(path.string().c_str(), "rb");
+        if (!file) return false;
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        bool ok = size >= 0;
+        if (ok) {
+            bytes->resize((size_t)size);
+            ok = fread(bytes->data(), 1, bytes->size(), file) == bytes->size();
+        }
+        fclose(file);
+        return ok;
+    }
+
+    static bool HashFile(const std::filesystem::path& path, uint64_t* hash) {
+        std::vector<uint8_t> bytes;
+        if (!ReadFile(path, &bytes)) return false;
+        *hash = Hash(bytes.data(), bytes.size());
+        return true;
+    }
+
+    // Loads the entry for `key` and checks every dependency (resolved against
+    // inputDir) still hashes the same. Any mismatch or damage is a miss.
+    bool Lookup(uint64_t key, const std::filesystem::path& inputDir, Entry* entry) const {
+        std::vector<uint8_t> bytes;
+        if (!ReadFile(PathFor(key), &bytes)) return false;
+
+        Reader reader = { bytes.data(), bytes.data() + bytes.size() };
+        uint32_t magic = 0, version = 0, dependencyCount = 0;
+        uint64_t dmsSize = 0;
+        if (!reader.Read(&magic) || magic != ENTRY_MAGIC) return false;
+        if (!reader.Read(&version) || version != ENTRY_VERSION) return false;
+        if (!reader.Read(&entry->triangles) || !reader.Read(&entry->strips)) return false;
+        if (!reader.Read(&dependencyCount)) return false;
+
+        entry->dependencies.clear();
+        for (uint32_t i = 0; i < dependencyCount; i++) {
+            Dependency dependency;
+            uint32_t length = 0;
+            if (!reader.Read(&length) || (size_t)(reader.end - reader.cursor) < length) return false;
+            dependency.uri.assign((const char*)reader.cursor, length);
+            reader.cursor += length;
+            if (!reader.Read(&dependency.hash)) return false;
+
+            uint64_t current;
+            if (!HashFile(inputDir / dependency.uri, &current) || current != dependency.hash) return false;
+            entry->dependencies.push_back(dependency);
+        }
+
+        if (!reader.Read(&dmsSize) || (uint64_t)(reader.end - reader.cursor) != dmsSize) return false;
+        entry->dms.assign(reader.cursor, reader.end);
+        return true;
+    }
+
+    // Writes through a temporary file and renames it into place, so parallel
+    // conversions of identical inputs never leave a torn entry behind
+    bool Store(uint64_t key, const Entry& entry) const {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        std::vector<uint8_t> bytes;
+        Append(&bytes, ENTRY_MAGIC);
+        Append(&bytes, ENTRY_VERSION);
+        Append(&bytes, entry.triangles);
+        Append(&bytes, entry.strips);
+        Append(&bytes, (uint32_t)entry.dependencies.size());
+        for (const auto& dependency : entry.dependencies) {
+            Append(&bytes, (uint32_t)dependency.uri.size());
+            bytes.insert(bytes.end(), dependency.uri.begin(), dependency.uri.end());
+            Append(&bytes, dependency.hash);
+        }
+        Append(&bytes, (uint64_t)entry.dms.size());
+        bytes.insert(bytes.end(), entry.dms.begin(), entry.dms.end());
+
+        std::filesystem::path path = PathFor(key);
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), ".%zx.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+        std::filesystem::path temporary = path.string() + suffix;
+
+        FILE* file = fopen(temporary.string().c_str(), "wb");
+        if (!file) return false;
+        bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        ok = (fclose(file) == 0) && ok;
+        if (ok) std::filesystem::rename(temporary, path, error);
+        if (!ok || error) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const uint32_t ENTRY_MAGIC = 0x43534D44;  // "DMSC"
+    static const uint32_t ENTRY_VERSION = 1;
+
+    struct Reader {
+        const uint8_t* cursor;
+        const uint8_t* end;
+
+        template <typename T>
+        bool Read(T* value) {
+            if ((size_t)(end - cursor) < sizeof(T)) return false;
+            memcpy(value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return true;
+        }
+    };
+
+    template <typename T>
+    static void Append(std::vector<uint8_t>* bytes, T value) {
+        const uint8_t* raw = (const uint8_t*)&value;
+        bytes->insert(bytes->end(), raw, raw + sizeof(T));
+    }
+
+    static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    std::filesystem::path PathFor(uint64_t key) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.dmsc", (unsigned long long)key);
+        return std::filesystem::path(directory) / name;
+    }
+
+    std::string directory;
+};
+
+#endif // CONVERSION_CACHE_H
@@ -0,0 +1,132 @@
+#ifndef GLTF_READER_H
+#define GLTF_READER_H
+
+// Low-copy glTF ingestion helpers. Include after cgltf.h.
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+// cgltf file callbacks that map .glb/.gltf/.bin files instead of reading
+// them into heap copies. Install with InstallMappedFileReader(); the
+// MappedFiles object has to outlive the cgltf_data.
+struct MappedFiles {
+    std::unordered_map<void*, size_t> sizes;
+};
+
+static cgltf_result MappedFileRead(const cgltf_memory_options* memoryOptions, const cgltf_file_options* fileOptions,
+                                   const char* path, cgltf_size* size, void** data) {
+    (void)memoryOptions;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return cgltf_result_file_not_found;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return cgltf_result_io_error;
+    }
+
+    // Private writable mapping: pages are shared with the page cache unless
+    // cgltf ever writes to them
+    void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return cgltf_result_io_error;
+
+    ((MappedFiles*)fileOptions->user_data)->sizes[mapping] = (size_t)info.st_size;
+    *size = (cgltf_size)info.st_size;
+    *data = mapping;
+    return cgltf_result_success;
+}
+
+static void MappedFileRelease(const cgltf_memory_options* memoryOptions, const cgltf_file_options* fileOptions,
+                              void* data) {
+    (void)memoryOptions;
+    MappedFiles* files = (MappedFiles*)fileOptions->user_data;
+    auto it = files->sizes.find(data);
+    if (it == files->sizes.end()) return;
+    munmap(it->first, it->second);
+    files->sizes.erase(it);
+}
+
+static void InstallMappedFileReader(cgltf_options* options, MappedFiles* files) {
+    options->file.read = MappedFileRead;
+    options->file.release = MappedFileRelease;
+    options->file.user_data = files;
+}
+
+// Start of a plain (non-sparse) accessor's data, or NULL
+static const uint8_t* AccessorData(const cgltf_accessor* accessor) {
+    if (accessor->is_sparse || !accessor->buffer_view) return NULL;
+    const uint8_t* data = cgltf_buffer_view_data(accessor->buffer_view);
+    return data ? data + accessor->offset : NULL;
+}
+
+// Calls visit(index, const float* values) for every element. Aligned float
+// data is visited in place; other layouts go through cgltf's converter.
+template <typename Visit>
+static void ForEachFloatElement(const cgltf_accessor* accessor, size_t components, Visit visit) {
+    const uint8_t* data = AccessorData(accessor);
+    if (data && accessor->component_type == cgltf_component_type_r_32f &&
+        cgltf_num_components(accessor->type) == components &&
+        ((uintptr_t)data & 3) == 0 && (accessor->stride & 3) == 0) {
+        for (size_t v = 0; v < accessor->count; v++) {
+            visit(v, (const float*)(data + v * accessor->stride));
+        }
+        return;
+    }
+
+    for (size_t v = 0; v < accessor->count; v++) {
+        float values[16] = { 0 };
+        cgltf_accessor_read_float(accessor, v, values, components);
+        visit(v, (const float*)values);
+    }
+}
+
+// Calls visit(index, const cgltf_uint* values) for every element, with fast
+// paths for unnormalized u8/u16/u32 components
+template <typename Visit>
+static void ForEachUintElement(const cgltf_accessor* accessor, size_t components, Visit visit) {
+    const uint8_t* data = AccessorData(accessor);
+    if (data && cgltf_num_components(accessor->type) == components && components <= 4 && !accessor->normalized) {
+        cgltf_uint values[4] = { 0 };
+        switch (accessor->component_type) {
+            case cgltf_component_type_r_8u:
+                for (size_t v = 0; v < accessor->count; v++) {
+                    const uint8_t* element = data + v * accessor->stride;
+                    for (size_t c = 0; c < components; c++) values[c] = element[c];
+                    visit(v, (const cgltf_uint*)values);
+                }
+                return;
+            case cgltf_component_type_r_16u:
+                for (size_t v = 0; v < accessor->count; v++) {
+                    const uint8_t* element = data + v * accessor->stride;
+                    for (size_t c = 0; c < components; c++) {
+                        uint16_t value;
+                        memcpy(&value, element + c * 2, 2);
+                        values[c] = value;
+                    }
+                    visit(v, (const cgltf_uint*)values);
+                }
+                return;
+            case cgltf_component_type_r_32u:
+                for (size_t v = 0; v < accessor->count; v++) {
+                    memcpy(values, data + v * accessor->stride, components * 4);
+                    visit(v, (const cgltf_uint*)values);
+                }
+                return;
+            default:
+                break;
+        }
+    }
+
+    for (size_t v = 0; v < accessor->count; v++) {
+        cgltf_uint values[4] = { 0 };
+        cgltf_accessor_read_uint(accessor, v, values, components);
+        visit(v, (const cgltf_uint*)values);
+    }
+}
+
+#endif // GLTF_READER_H
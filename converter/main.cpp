@@ -1,6 +1,7 @@
 #include "main.h"
 #define CGLTF_IMPLEMENTATION
 #include "include/cgltf.h"
+#include "gltf_reader.h"
 
 // Transform data
 typedef struct Transform {
@@ -18,12 +19,151 @@ typedef struct {
     Matrix inverseBindMatrix;
 } Bone;
 
+// Keyframes of one bone channel. `values` holds 3 floats per key for
+// translation/scale and 4 for rotation.
+typedef struct {
+    int keyCount;
+    float* times;
+    float* values;
+} Track;
+
+enum { TRACK_TRANSLATION, TRACK_ROTATION, TRACK_SCALE, TRACKS_PER_BONE };
+
+// Largest error interpolating a track may introduce, per channel
+struct TrackTolerance {
+    float position;         // Model units
+    float rotation;         // Degrees
+    float scale;            // Scale factor
+};
+
+// Animation encodings of DMS v3
+enum { ANIM_ENCODING_FLOAT, ANIM_ENCODING_QUANTIZED };
+
+// Tracks of one clip packed into 16-bit words (DMS v3, --quantize). Every key
+// value is three words: translation and scale as fixed point over the clip's
+// range, rotation as its smallest three components with the index of the
+// dropped one in bit 15 of the first two words. Key times are ticks of
+// timeStep. A scale track that is constant 1 has no keys.
+struct QuantizedClip {
+    float timeStep;
+    Vector3 translationMin, translationStep;
+    Vector3 scaleMin, scaleStep;
+    std::vector<uint16_t> words;    // Per track: keyCount, ticks[keyCount], 3 words per key
+};
+
+// Vertex layouts of DMS v4 meshes
+enum { VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_PACKED };
+
+// Flag over the layout (--bone-space): weighted positions are stored in their
+// bone's space, already multiplied by its inverse bind matrix
+#define VERTEX_BONE_SPACE 0x100
+
+// Flag over the layout (--rigid-parts): every vertex is weighted to the bone
+// of the first one, so runtimes draw the mesh through that bone's world pose
+// instead of skinning it. Always set together with VERTEX_BONE_SPACE.
+#define VERTEX_RIGID 0x200
+
+// Vertex of a packed mesh (DMS v4, --pack-vertices). Positions are 16-bit
+// fixed point around the center of the mesh's bounds and UVs over the mesh's
+// UV range, so the runtime can fold positionOffset/positionScale into the
+// matrix it transforms with.
+typedef struct {
+    int16_t x, y, z;        // positionOffset + xyz * positionScale
+    int8_t nx, ny, nz;      // Normal * 127
+    uint8_t boneId;
+    uint16_t u, v;          // uvOffset + uv * uvScale
+    uint16_t boneWeight;    // Weight * 65535
+} PackedVertex;             // Total: 16 bytes
+
+struct PackedMesh {
+    Vector3 positionOffset, positionScale;
+    float uvOffset[2], uvScale[2];
+    std::vector<PackedVertex> vertices;
+};
+
+// Chunk types of DMS v6. The header is followed by a table of chunkCount
+// ChunkEntry records; each chunk starts on a multiple of its alignment and
+// readers skip types they do not know.
+enum : uint32_t {
+    CHUNK_SKELETON  = 0x4C454B53,   // "SKEL": boneCount bones
+    CHUNK_ANIMATION = 0x4D494E41,   // "ANIM": one clip, laid out as in v5
+    CHUNK_MATERIALS = 0x4C54414D,   // "MATL": textureCount, then a 64-byte name per texture
+    CHUNK_BOUNDS    = 0x53444E42,   // "BNDS": per mesh MeshBounds
+    CHUNK_MESH      = 0x4853454D    // "MESH": one mesh, laid out as in v5
+};
+
+struct ChunkEntry {
+    uint32_t type;
+    uint32_t offset;        // From the start of the file
+    uint32_t size;          // Payload bytes, without trailing padding
+    uint32_t alignment;
+};
+
+// In-place image (--image): everything a runtime needs in one block it reads
+// whole and uses where it lies. Tables hold offsets from the start of the
+// image instead of pointers; vertex arrays start on 32-byte boundaries.
+struct ImageHeader {
+    uint32_t magic;                 // DMS_IMAGE_MAGIC
+    uint32_t version;
+    uint32_t size;                  // Image bytes
+    uint32_t meshCount, boneCount, animCount, textureCount;
+    uint32_t trackCount;            // Tracks of all clips together
+    uint32_t skinnedVertexCount;    // Vertices of skinned meshes, which need writable copies
+    uint32_t packedVertexCount;     // Vertices of packed meshes
+};
+
+struct ImageMesh {
+    uint32_t vertexCount, indexCount;
+    int32_t textureId;
+    uint32_t vertexFormat;
+    uint32_t stripCount, indexSize, stripIndexCount, triangleCount;
+    uint32_t vertices;              // Offset of Vertex or PackedVertex[vertexCount]
+    uint32_t stripLengths;          // Offset of uint32_t[stripCount]
+    uint32_t indices;               // Offset of indexCount indices of indexSize bytes
+    Vector3 positionOffset, positionScale;  // Packed meshes
+    float uvOffset[2], uvScale[2];
+    Vector3 center;                 // Bounding sphere
+    float radius;
+};
+
+struct ImageBone {
+    char name[64];
+    int32_t parent;
+    Transform bindPose;
+    Matrix inverseBindMatrix;
+};
+
+struct ImageClip {
+    char name[32];
+    int32_t boneCount, frameCount;
+    float duration;
+    uint32_t encoding;
+    float timeStep;                 // Quantized clips
+    Vector3 translationMin, translationStep, scaleMin, scaleStep;
+    uint32_t dataCount;             // 32-bit words of float clips, 16-bit words of quantized ones
+    uint32_t data;                  // Offset: per track keyCount, times, values (float), or the
+                                    // QuantizedClip words
+};
+
+static_assert(sizeof(ImageHeader) == 40 && sizeof(ImageMesh) == 100, "DMS image layout");
+static_assert(sizeof(ImageBone) == 172 && sizeof(ImageClip) == 108, "DMS image layout");
+
+// Axis-aligned box and bounding sphere of a mesh's bind pose. The sphere is
+// centered on the vertex average, as the clipping demo used to compute it.
+struct MeshBounds {
+    Vector3 min, max;
+    Vector3 center;
+    float radius;
+};
+
 typedef struct {
     char name[32];
     int boneCount;
     int frameCount;
     float duration;
-    Transform** framePoses;  
+    Transform** framePoses;  // DMS v1: whole reduced frames
+    Track* tracks;           // DMS v2: boneCount * TRACKS_PER_BONE tracks
+    QuantizedClip* quantized;  // DMS v3 with --quantize: packed copy of tracks
 } Animation;
 
 
@@ -49,14 +189,15 @@ typedef struct {
 
 
 typedef struct {
-    Vertex* vertices;       // Dynamic vertex array
-    Vertex* originalVertices; // Store the original vertex positions  
-    Vertex* animatedVertices;// Working buffer for animations
+    Vertex* vertices;       // Dynamic vertex array (bind pose)
 
-    unsigned int* indices;  // Dynamic index array
+    unsigned int* indices;  // Dynamic index array: strips first, then a triangle list
+    unsigned int* stripLengths; // Indices per strip, for tristripped meshes
+    int stripCount;
     int vertexCount;
     int indexCount;
     int textureId;          // NEW: Texture ID reference
+    bool rigid;             // --rigid-parts: every vertex follows the bone of the first one
 
  } Mesh;
 
@@ -64,6 +205,8 @@ typedef struct {
     Mesh* meshes;         // Array of meshes
     int meshCount;
     Skeleton* skeleton;   // Pointer to skeleton data
+    char (*textureNames)[64]; // glTF image names, indexed by Mesh::textureId
+    int textureCount;
 } Model;
 
 typedef struct {
@@ -86,37 +229,187 @@ struct Triangle {
     uint32_t materialId;
 };
 
-std::vector<Triangle> triangles;
-std::vector<std::vector<size_t>> join_strips(const triangle_stripper::primitive_vector& originalStrips);
+// Per-mesh stripification statistics, printed once the mesh is done
+struct StripStats {
+    size_t input_triangles;
+    size_t strips;
+    size_t strip_triangles;
+    size_t list_triangles;
+    size_t total_triangles;
+    size_t max_strip_length;
+    size_t pvr_vertices;        // Vertices the PVR renderers submit for this mesh
+    float strip_ratio;
+    float avg_strip_length;
+    float vertex_reuse;
+};
+
+// Per-asset line of the batch summary table
+struct ConversionSummary {
+    std::string input;
+    std::string output;
+    size_t triangles;
+    size_t strips;
+    long bytes;
+    bool ok;
+    bool cached;            // Output copied from the conversion cache
+};
+
+// Converter settings chosen on the command line; read-only once conversion starts
+struct ConverterOptions {
+    int threadCount;        // Worker threads for mesh conversion
+    bool stitchStrips;      // Bridge strips/loose triangles when it saves PVR vertices
+    int dmsVersion;         // 1: whole-frame animations, 2: per-bone tracks, 3: + encoding
+    bool quantizeAnimations; // Pack animation keys into 16-bit words (v3)
+    TrackTolerance tolerance;                               // Track fit default (v2+)
+    std::map<std::string, TrackTolerance> clipTolerances;   // Per clip name, over the default
+    std::map<std::string, TrackTolerance> boneTolerances;   // Per bone name, over clip and default
+    float worldTolerance;   // Bone position error in model units; < 0: TRACK_WORLD_TOLERANCE
+                            // of the skeleton's size, 0: no check
+    float sampleRate;       // Animation samples per second
+    bool nativeKeys;        // Sample at authored key times instead of a fixed rate (v2+)
+    bool packVertices;      // Write 16-byte fixed-point vertices (v4)
+    bool boneSpace;         // Store skinned positions in their bone's space (v6 or image)
+    bool rigidParts;        // Split skinned meshes into per-bone rigid parts (implies boneSpace)
+    bool image;             // Write an in-place image instead of a .dms stream
+};
+
+std::vector<std::vector<size_t>> join_strips(const triangle_stripper::primitive_vector& originalStrips,
+                                             bool stitch, std::vector<size_t>& looseIndices);
 
 
-bool LoadGLTF(const char* filename);
-void Cleanup(void);
-void optimize_mesh();
-bool can_join_strips(const std::vector<size_t>& strip1, const std::vector<size_t>& strip2);
-void ExportTristrippedModel(const Model* model, const char* filename);
+bool LoadGLTF(const char* filename, Model* model, Skeleton* skeleton, std::vector<std::string>* bufferUris);
+void Cleanup(Skeleton* skeleton, Model* model, Model* tristrippedModel);
+std::string* SetLogCapture(std::string* capture);
+void LogPrintf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void optimize_mesh(std::vector<Triangle>& triangles, StripStats* stats);
+void PrintStripStats(const StripStats& stats);
+bool WriteOutput(const char* filename, const std::vector<uint8_t>& bytes);
+long ExportTristrippedModel(const Model* model, const char* filename, std::vector<uint8_t>& bytes);
 
 #define POSITION_THRESHOLD 0.1f  // 1mm of movement
 #define ROTATION_THRESHOLD 0.1f  // ~0.06 degrees
 #define SCALE_THRESHOLD    0.1f  // 0.1% scale change
 
+// Per-track reduction (DMS v2+) defaults; --tolerance and --world-tolerance
+// override them
+#define TRACK_POSITION_TOLERANCE 0.001f  // Model units
+#define TRACK_ROTATION_TOLERANCE 0.25f   // Degrees
+#define TRACK_SCALE_TOLERANCE    0.001f  // Scale factor
+#define TRACK_MAX_KEY_SPAN       64      // Samples between keys at most
+#define TRACK_WORLD_TOLERANCE    0.003f  // Any bone's position, as a fraction of the skeleton's size
+#define TRACK_REFINE_PASSES      8       // World-space refinement rounds at most
+
+#define ANIMATION_SAMPLE_RATE 30.0f  // Samples per second; --sample-rate overrides it
+
+// --rigid-parts: smaller groups of single-bone triangles stay in the skinned
+// remainder, where they cost no extra mesh header or draw call
+#define RIGID_PART_MIN_TRIANGLES 8
+
+// tri_stripper settings used by optimize_mesh()
+#define STRIP_MIN_SIZE        0
+#define STRIP_CACHE_SIZE      0
+#define STRIP_BACKWARD_SEARCH true
+#define STRIP_PUSH_CACHE_HITS true
+
+// Part of every conversion cache key: bump whenever the .dms output changes
+#define CONVERTER_VERSION "strippy-9"
+
+// Newest .dms version written by default; --dms-version 1 keeps old runtimes working
+#define DMS_VERSION 6
+
+#define DMS_MAGIC           0x54534D44  // "DMST"
+#define DMS_CHUNK_ALIGNMENT 4           // v6 chunks besides meshes
+#define DMS_MESH_ALIGNMENT  32          // v6 mesh chunks, like the runtimes' vertex buffers
+#define DMS_IMAGE_MAGIC     0x49534D44  // "DMSI"
+#define DMS_IMAGE_VERSION   1
+#define DMS_IMAGE_ALIGNMENT 32          // Vertex arrays within an image
+
 // Globals
-Skeleton skeleton = { 0 };
-Model model = { 0 };
-Model tristrippedModel = { 0 }; // Second model for tristripped version
+ConverterOptions converterOptions = {
+    1, false, DMS_VERSION, false,
+    { TRACK_POSITION_TOLERANCE, TRACK_ROTATION_TOLERANCE, TRACK_SCALE_TOLERANCE }, {}, {}, -1.0f,
+    ANIMATION_SAMPLE_RATE, false, false, false, false, false
+};
+
+// Conversion log. Batch mode captures it per file so conversions running
+// in parallel don't interleave their output.
+static thread_local std::string* logCapture = NULL;
+static FILE* logStream = NULL;  // NULL = stdout; stderr when stdout carries the .dms
+
+std::string* SetLogCapture(std::string* capture) {
+    std::string* previous = logCapture;
+    logCapture = capture;
+    return previous;
+}
+
+void LogPrintf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (logCapture) {
+        va_list measure;
+        va_copy(measure, args);
+        int length = vsnprintf(NULL, 0, format, measure);
+        va_end(measure);
+        if (length > 0) {
+            size_t start = logCapture->size();
+            logCapture->resize(start + length + 1);
+            vsnprintf(&(*logCapture)[start], length + 1, format, args);
+            logCapture->resize(start + length);
+        }
+    } else {
+        vfprintf(logStream ? logStream : stdout, format, args);
+    }
+    va_end(args);
+}
  
 
 
 
 
-// Find joint index in skeleton
-static int GetNodeBoneIndex(const cgltf_node* node, const cgltf_skin* skin) {
-    if (!node || !skin) return -1;
-    
+// Node -> bone index of a skin's joint, built once so lookups don't scan the joints
+typedef std::unordered_map<const cgltf_node*, int> JointIndexMap;
+
+// Skin joint indices in bone order: the skin's own order, except that a
+// joint listed ahead of its parent moves after it. Runtimes compose world
+// poses in a single pass over the bones.
+static std::vector<int> SortSkinJoints(const cgltf_skin* skin) {
+    std::unordered_map<const cgltf_node*, int> firstJoint;
     for (size_t i = 0; i < skin->joints_count; i++) {
-        if (skin->joints[i] == node) return (int)i;
+        firstJoint.emplace(skin->joints[i], (int)i);
     }
-    return -1;
+
+    std::vector<int> order;
+    std::vector<char> placed(skin->joints_count, 0);
+    order.reserve(skin->joints_count);
+    for (size_t i = 0; i < skin->joints_count; i++) {
+        // Place unplaced joint ancestors first, root-most first
+        std::vector<int> chain;
+        for (int joint = (int)i; joint >= 0 && !placed[joint];) {
+            chain.push_back(joint);
+            placed[joint] = 1;
+            const cgltf_node* parent = skin->joints[joint]->parent;
+            auto it = parent ? firstJoint.find(parent) : firstJoint.end();
+            joint = it != firstJoint.end() ? it->second : -1;
+        }
+        order.insert(order.end(), chain.rbegin(), chain.rend());
+    }
+    return order;
+}
+
+static JointIndexMap BuildJointIndexMap(const cgltf_skin* skin, const std::vector<int>& jointOrder) {
+    JointIndexMap joints;
+    joints.reserve(skin->joints_count);
+    for (size_t i = 0; i < jointOrder.size(); i++) {
+        joints.emplace(skin->joints[jointOrder[i]], (int)i);  // First occurrence wins
+    }
+    return joints;
+}
+
+// Find joint index in skeleton
+static int GetNodeBoneIndex(const cgltf_node* node, const JointIndexMap& joints) {
+    if (!node) return -1;
+    auto it = joints.find(node);
+    return it != joints.end() ? it->second : -1;
 }
 
 float QuaternionDotProduct(Quaternion a, Quaternion b) {
@@ -187,6 +480,139 @@ static Transform GetNodeTransform(const cgltf_node* node)
     return transform;
 }
 
+// One glTF animation channel's keys, copied out of its accessors
+struct ChannelKeys {
+    std::vector<float> times;
+    std::vector<float> values;      // CUBICSPLINE: in-tangent, value, out-tangent per key
+    int components;                 // 3 (translation, scale) or 4 (rotation)
+    cgltf_interpolation_type interpolation;
+    size_t cursor;                  // Key at or before the last evaluated time
+};
+
+// Reads a sampler's keys. Fails on empty or mismatched accessors.
+static bool LoadChannelKeys(const cgltf_animation_sampler* sampler, int components, ChannelKeys* keys) {
+    size_t keyCount = sampler->input->count;
+    size_t valuesPerKey = sampler->interpolation == cgltf_interpolation_type_cubic_spline ? 3 : 1;
+    if (keyCount == 0 || sampler->output->count != keyCount * valuesPerKey) return false;
+
+    keys->components = components;
+    keys->interpolation = sampler->interpolation;
+    keys->cursor = 0;
+    keys->times.resize(keyCount);
+    keys->values.resize(sampler->output->count * components);
+    ForEachFloatElement(sampler->input, 1, [&](size_t k, const float* time) {
+        keys->times[k] = time[0];
+    });
+    ForEachFloatElement(sampler->output, (size_t)components, [&](size_t v, const float* value) {
+        memcpy(&keys->values[v * components], value, components * sizeof(float));
+    });
+    return true;
+}
+
+// Evaluates a channel at `time` the way glTF defines its interpolation.
+// Times have to grow between calls: the cursor only moves forward and sits
+// on the first key whose successor is at or after `time`. Before the first
+// key the channel holds key 0, after the last it holds the last key.
+static void EvaluateChannelKeys(ChannelKeys* keys, float time, float* out) {
+    const float* times = keys->times.data();
+    size_t keyCount = keys->times.size();
+    int c = keys->components;
+    bool cubic = keys->interpolation == cgltf_interpolation_type_cubic_spline;
+    size_t stride = cubic ? 3 : 1;   // Values per key
+    size_t offset = cubic ? 1 : 0;   // The key's value among them
+
+    while (keys->cursor + 1 < keyCount && times[keys->cursor + 1] < time) keys->cursor++;
+    size_t prevKey = keys->cursor;
+    if (prevKey + 1 >= keyCount || times[prevKey] > time) {
+        size_t key = times[prevKey] > time ? 0 : keyCount - 1;
+        memcpy(out, &keys->values[(key * stride + offset) * c], c * sizeof(float));
+        return;
+    }
+    size_t nextKey = prevKey + 1;
+
+    float span = times[nextKey] - times[prevKey];
+    float alpha = (time - times[prevKey]) / span;
+    if (alpha < 0.0f) alpha = 0.0f;
+    if (alpha > 1.0f) alpha = 1.0f;
+
+    const float* prev = &keys->values[(prevKey * stride + offset) * c];
+    const float* next = &keys->values[(nextKey * stride + offset) * c];
+    switch (keys->interpolation) {
+        case cgltf_interpolation_type_step:
+            memcpy(out, alpha >= 1.0f ? next : prev, c * sizeof(float));
+            break;
+        case cgltf_interpolation_type_cubic_spline: {
+            // Hermite spline through the two values with the previous key's
+            // out-tangent and the next key's in-tangent, both per second
+            const float* outTangent = prev + c;
+            const float* inTangent = next - c;
+            float t2 = alpha * alpha, t3 = t2 * alpha;
+            float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+            float h10 = (t3 - 2.0f * t2 + alpha) * span;
+            float h01 = -2.0f * t3 + 3.0f * t2;
+            float h11 = (t3 - t2) * span;
+            for (int i = 0; i < c; i++) {
+                out[i] = h00 * prev[i] + h10 * outTangent[i] + h01 * next[i] + h11 * inTangent[i];
+            }
+            if (c == 4) {
+                Quaternion q = QuaternionNormalize(Quaternion{ out[0], out[1], out[2], out[3] });
+                memcpy(out, &q, sizeof(Quaternion));
+            }
+        } break;
+        default:
+            if (c == 4) {
+                Quaternion q = QuaternionSlerp(Quaternion{ prev[0], prev[1], prev[2], prev[3] },
+                                               Quaternion{ next[0], next[1], next[2], next[3] }, alpha);
+                memcpy(out, &q, sizeof(Quaternion));
+            } else {
+                for (int i = 0; i < c; i++) out[i] = prev[i] + (next[i] - prev[i]) * alpha;
+            }
+            break;
+    }
+}
+
+// Times a clip is sampled at. By default every 1/sampleRate seconds. With
+// nativeKeys the authored key times themselves, plus what linear
+// interpolation between them needs to follow the source: sampleRate
+// samples inside cubic segments and one sample just before every STEP key,
+// so the jump stays a jump.
+static std::vector<float> ClipSampleTimes(const std::vector<ChannelKeys>& channels, float duration,
+                                          float sampleRate, bool nativeKeys) {
+    std::vector<float> times;
+    if (!nativeKeys) {
+        int frameCount = (int)(duration * sampleRate) + 1;
+        times.reserve(frameCount);
+        for (int frame = 0; frame < frameCount; frame++) times.push_back(frame * (1.0f / sampleRate));
+        return times;
+    }
+
+    times.push_back(0.0f);
+    times.push_back(duration);
+    for (const ChannelKeys& keys : channels) {
+        for (size_t k = 0; k < keys.times.size(); k++) {
+            float time = keys.times[k];
+            times.push_back(time);
+            if (k == 0) continue;
+
+            float prevTime = keys.times[k - 1];
+            if (keys.interpolation == cgltf_interpolation_type_step) {
+                times.push_back(time - std::min(0.001f, (time - prevTime) * 0.5f));
+            } else if (keys.interpolation == cgltf_interpolation_type_cubic_spline) {
+                int steps = (int)ceilf((time - prevTime) * sampleRate);
+                for (int step = 1; step < steps; step++) {
+                    times.push_back(prevTime + (time - prevTime) * (float)step / (float)steps);
+                }
+            }
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    while (!times.empty() && times.front() < 0.0f) times.erase(times.begin());
+    while (!times.empty() && times.back() > duration) times.pop_back();
+    return times;
+}
+
 struct StripInfo {
     std::vector<uint32_t> indices;  // Indices making up this strip
     uint32_t stripId;               // ID of this strip
@@ -277,20 +703,462 @@ int reduceKeyframes(Transform* poses, int frameCount, int boneCount) {
     return optimizedPoses.size() / boneCount;
 }
 
+// Channel value of one pose as floats: 3 for translation/scale, 4 for rotation
+static int trackComponents(int channel) {
+    return channel == TRACK_ROTATION ? 4 : 3;
+}
+
+static void channelValue(const Transform& pose, int channel, float* out) {
+    switch (channel) {
+        case TRACK_TRANSLATION: memcpy(out, &pose.translation, sizeof(Vector3)); break;
+        case TRACK_ROTATION:    memcpy(out, &pose.rotation, sizeof(Quaternion)); break;
+        default:                memcpy(out, &pose.scale, sizeof(Vector3)); break;
+    }
+}
+
+// Distance between two channel values: units for translation/scale,
+// degrees for rotation
+static float channelError(const float* a, const float* b, int channel) {
+    if (channel == TRACK_ROTATION) {
+        // 4 * atan2(|a - b|, |a + b|) rather than 2 * acos(dot): acos can't
+        // resolve angles below a few hundredths of a degree in float
+        float sign = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] < 0.0f ? -1.0f : 1.0f;
+        float difference = 0.0f, sum = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            difference += (a[c] - sign * b[c]) * (a[c] - sign * b[c]);
+            sum += (a[c] + sign * b[c]) * (a[c] + sign * b[c]);
+        }
+        return 4.0f * atan2f(sqrtf(difference), sqrtf(sum)) * RAD2DEG;
+    }
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+static float channelTolerance(const TrackTolerance& tolerance, int channel) {
+    switch (channel) {
+        case TRACK_TRANSLATION: return tolerance.position;
+        case TRACK_ROTATION:    return tolerance.rotation;
+        default:                return tolerance.scale;
+    }
+}
+
+// Value the runtime reconstructs between two keys (lerp, slerp for rotation)
+static void interpolateChannel(const float* a, const float* b, float alpha, int channel, float* out) {
+    if (channel == TRACK_ROTATION) {
+        Quaternion q = QuaternionSlerp(Quaternion{ a[0], a[1], a[2], a[3] },
+                                       Quaternion{ b[0], b[1], b[2], b[3] }, alpha);
+        memcpy(out, &q, sizeof(Quaternion));
+        return;
+    }
+    for (int c = 0; c < 3; c++) out[c] = a[c] + (b[c] - a[c]) * alpha;
+}
+
+// Fits one channel's samples. A sample is dropped while interpolating
+// between the surrounding kept keys reproduces every skipped sample within
+// tolerance, so error is measured after interpolation and never accumulates
+// along slow drifts. A channel that never moves keeps a single key.
+static void fitTrackKeys(const float* samples, const float* sampleTimes, int frameCount, int channel,
+                         float tolerance, std::vector<int>& keptFrames) {
+    keptFrames.clear();
+    keptFrames.push_back(0);
+
+    bool constant = true;
+    for (int frame = 1; frame < frameCount && constant; frame++) {
+        constant = channelError(&samples[frame * 4], &samples[0], channel) <= tolerance;
+    }
+    if (constant) return;
+
+    // Greedily grow the segment [anchor, end]; spans are capped so long
+    // smooth clips stay linear in the sample count
+    int anchor = 0;
+    for (int end = 2; end < frameCount; end++) {
+        bool fits = end - anchor <= TRACK_MAX_KEY_SPAN;
+        for (int f = anchor + 1; f < end && fits; f++) {
+            float predicted[4];
+            float alpha = (sampleTimes[f] - sampleTimes[anchor]) / (sampleTimes[end] - sampleTimes[anchor]);
+            interpolateChannel(&samples[anchor * 4], &samples[end * 4], alpha, channel, predicted);
+            fits = channelError(predicted, &samples[f * 4], channel) <= tolerance;
+        }
+        if (!fits) {
+            anchor = end - 1;
+            keptFrames.push_back(anchor);
+        }
+    }
+    if (frameCount - 1 > anchor) keptFrames.push_back(frameCount - 1);
+}
+
+// (Re)builds the three tracks of one bone from the sampled poses
+static void fitBoneTracks(Track* boneTracks, const Transform* poses, const float* sampleTimes, int frameCount,
+                          int boneCount, int bone, const TrackTolerance& tolerance) {
+    std::vector<float> samples((size_t)frameCount * 4);
+    std::vector<int> keptFrames;
+
+    for (int channel = 0; channel < TRACKS_PER_BONE; channel++) {
+        for (int frame = 0; frame < frameCount; frame++) {
+            channelValue(poses[frame * boneCount + bone], channel, &samples[frame * 4]);
+        }
+        fitTrackKeys(samples.data(), sampleTimes, frameCount, channel, channelTolerance(tolerance, channel), keptFrames);
+
+        Track* track = &boneTracks[channel];
+        int components = trackComponents(channel);
+        free(track->times);
+        free(track->values);
+        track->keyCount = (int)keptFrames.size();
+        track->times = (float*)malloc(track->keyCount * sizeof(float));
+        track->values = (float*)malloc(track->keyCount * components * sizeof(float));
+        for (int k = 0; k < track->keyCount; k++) {
+            track->times[k] = sampleTimes[keptFrames[k]];
+            memcpy(&track->values[k * components], &samples[keptFrames[k] * 4], components * sizeof(float));
+        }
+    }
+}
+
+// Splits sampled poses into independent translation/rotation/scale tracks
+// per bone with real key times, each fitted within its bone's tolerance
+Track* buildBoneTracks(const Transform* poses, const float* sampleTimes, int frameCount, int boneCount,
+                       const TrackTolerance* tolerances) {
+    Track* tracks = (Track*)calloc((size_t)boneCount * TRACKS_PER_BONE, sizeof(Track));
+    for (int bone = 0; bone < boneCount; bone++) {
+        fitBoneTracks(&tracks[bone * TRACKS_PER_BONE], poses, sampleTimes, frameCount, boneCount, bone, tolerances[bone]);
+    }
+    return tracks;
+}
+
+// Model-space origin of every bone at every frame. `localPose(frame, bone)`
+// gives the bone's local transform; parents are composed the way
+// UpdateDMSModelAnimation does.
+template <typename LocalPose>
+static void boneWorldPositions(const Bone* bones, int boneCount, int frameCount, LocalPose localPose,
+                               std::vector<Vector3>& positions) {
+    // LoadGLTF() puts parents before children
+    std::vector<Matrix> world(boneCount);
+    positions.resize((size_t)frameCount * boneCount);
+    for (int frame = 0; frame < frameCount; frame++) {
+        for (int bone = 0; bone < boneCount; bone++) {
+            Transform pose = localPose(frame, bone);
+            Matrix local = MatrixMultiply(MatrixMultiply(MatrixScale(pose.scale.x, pose.scale.y, pose.scale.z),
+                                                         QuaternionToMatrix(pose.rotation)),
+                                          MatrixTranslate(pose.translation.x, pose.translation.y, pose.translation.z));
+            int parent = bones[bone].parent;
+            world[bone] = parent >= 0 ? MatrixMultiply(local, world[parent]) : local;
+            positions[frame * boneCount + bone] = Vector3{ world[bone].m12, world[bone].m13, world[bone].m14 };
+        }
+    }
+}
+
+// Value of a track at `time`, as the runtime interpolates it. `cursor`
+// follows increasing times.
+static void sampleTrack(const Track* track, int channel, float time, int* cursor, float* out) {
+    int k = *cursor;
+    while (k + 1 < track->keyCount && track->times[k + 1] <= time) k++;
+    *cursor = k;
+
+    int components = trackComponents(channel);
+    const float* a = &track->values[k * components];
+    if (k + 1 >= track->keyCount || time <= track->times[k]) {
+        memcpy(out, a, components * sizeof(float));
+        return;
+    }
+    float alpha = (time - track->times[k]) / (track->times[k + 1] - track->times[k]);
+    interpolateChannel(a, a + components, alpha, channel, out);
+}
+
+// End-effector check: per-track tolerances bound each bone's local error,
+// but errors add up down the hierarchy. While some bone's model-space
+// position is further than the world tolerance from the dense samples, halve
+// the tolerances of that bone and its ancestors and refit their tracks.
+// A negative worldTolerance is relative to the size of the first pose.
+// Returns the largest remaining error; *passes counts the refits.
+static float refineWorldError(Track* tracks, const Transform* poses, const float* sampleTimes, int frameCount,
+                              const Bone* bones, int boneCount, TrackTolerance* tolerances,
+                              float worldTolerance, float* usedTolerance, int* passes) {
+    std::vector<Vector3> reference, reduced;
+    boneWorldPositions(bones, boneCount, frameCount,
+                       [&](int frame, int bone) { return poses[frame * boneCount + bone]; }, reference);
+
+    if (worldTolerance < 0.0f) {
+        Vector3 lo = reference[0], hi = reference[0];
+        for (int bone = 1; bone < boneCount; bone++) {
+            lo = Vector3Min(lo, reference[bone]);
+            hi = Vector3Max(hi, reference[bone]);
+        }
+        worldTolerance = Vector3Distance(lo, hi) * TRACK_WORLD_TOLERANCE;
+    }
+    *usedTolerance = worldTolerance;
+
+    *passes = 0;
+    for (;;) {
+        std::vector<int> cursors((size_t)boneCount * TRACKS_PER_BONE, 0);
+        std::vector<int> lastFrame(boneCount, -1);
+        boneWorldPositions(bones, boneCount, frameCount, [&](int frame, int bone) {
+            if (frame < lastFrame[bone]) {
+                for (int channel = 0; channel < TRACKS_PER_BONE; channel++) cursors[bone * TRACKS_PER_BONE + channel] = 0;
+            }
+            lastFrame[bone] = frame;
+            Transform pose;
+            float value[4];
+            for (int channel = 0; channel < TRACKS_PER_BONE; channel++) {
+                int t = bone * TRACKS_PER_BONE + channel;
+                sampleTrack(&tracks[t], channel, sampleTimes[frame], &cursors[t], value);
+                switch (channel) {
+                    case TRACK_TRANSLATION: memcpy(&pose.translation, value, sizeof(Vector3)); break;
+                    case TRACK_ROTATION:    memcpy(&pose.rotation, value, sizeof(Quaternion)); break;
+                    default:                memcpy(&pose.scale, value, sizeof(Vector3)); break;
+                }
+            }
+            return pose;
+        }, reduced);
+
+        float maxError = 0.0f;
+        // A bone's own rotation and scale don't move its origin: tighten its
+        // translation, and every channel of its ancestors
+        enum { KEEP, TIGHTEN_TRANSLATION, TIGHTEN_ALL };
+        std::vector<int> tighten(boneCount, KEEP);
+        for (int bone = 0; bone < boneCount; bone++) {
+            float boneError = 0.0f;
+            for (int frame = 0; frame < frameCount; frame++) {
+                boneError = fmaxf(boneError, Vector3Distance(reference[frame * boneCount + bone],
+                                                             reduced[frame * boneCount + bone]));
+            }
+            maxError = fmaxf(maxError, boneError);
+            if (boneError <= worldTolerance) continue;
+            if (tighten[bone] == KEEP) tighten[bone] = TIGHTEN_TRANSLATION;
+            for (int b = bones[bone].parent; b >= 0 && tighten[b] != TIGHTEN_ALL; b = bones[b].parent) {
+                tighten[b] = TIGHTEN_ALL;
+            }
+        }
+        if (maxError <= worldTolerance || *passes == TRACK_REFINE_PASSES) return maxError;
+
+        (*passes)++;
+        for (int bone = 0; bone < boneCount; bone++) {
+            if (tighten[bone] == KEEP) continue;
+            tolerances[bone].position *= 0.5f;
+            if (tighten[bone] == TIGHTEN_ALL) {
+                tolerances[bone].rotation *= 0.5f;
+                tolerances[bone].scale *= 0.5f;
+            }
+            fitBoneTracks(&tracks[bone * TRACKS_PER_BONE], poses, sampleTimes, frameCount, boneCount, bone, tolerances[bone]);
+        }
+    }
+}
+
+#define QUAT_SMALLEST_LIMIT 0.70710678f  // |component| of a unit quaternion below its largest one
+
+static uint16_t quantizeFixed(float value, float min, float step) {
+    if (step <= 0.0f) return 0;
+    float q = roundf((value - min) / step);
+    return (uint16_t)(q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q));
+}
+
+static void encodeQuaternion(const float* value, uint16_t* words) {
+    float q[4];
+    float length = sqrtf(value[0] * value[0] + value[1] * value[1] + value[2] * value[2] + value[3] * value[3]);
+    for (int c = 0; c < 4; c++) q[c] = length > 0.0f ? value[c] / length : (c == 3 ? 1.0f : 0.0f);
+
+    int largest = 0;
+    for (int c = 1; c < 4; c++) {
+        if (fabsf(q[c]) > fabsf(q[largest])) largest = c;
+    }
+    // q and -q are the same rotation: make the dropped component positive
+    float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+    for (int c = 0, w = 0; c < 4; c++) {
+        if (c == largest) continue;
+        float unit = (q[c] * sign + QUAT_SMALLEST_LIMIT) / (2.0f * QUAT_SMALLEST_LIMIT);
+        words[w++] = (uint16_t)roundf(fminf(fmaxf(unit, 0.0f), 1.0f) * 32767.0f);
+    }
+    words[0] |= (uint16_t)((largest & 1) << 15);
+    words[1] |= (uint16_t)((largest >> 1) << 15);
+}
+
+static void decodeQuaternion(const uint16_t* words, float* q) {
+    int largest = (words[0] >> 15) | ((words[1] >> 15) << 1);
+    float sum = 0.0f;
+    for (int c = 0, w = 0; c < 4; c++) {
+        if (c == largest) continue;
+        q[c] = (words[w++] & 0x7FFF) * (2.0f * QUAT_SMALLEST_LIMIT / 32767.0f) - QUAT_SMALLEST_LIMIT;
+        sum += q[c] * q[c];
+    }
+    q[largest] = sqrtf(fmaxf(0.0f, 1.0f - sum));
+}
+
+static void decodeQuantizedValue(const QuantizedClip* clip, int channel, const uint16_t* words, float* out) {
+    if (channel == TRACK_ROTATION) {
+        decodeQuaternion(words, out);
+        return;
+    }
+    const Vector3& min = channel == TRACK_TRANSLATION ? clip->translationMin : clip->scaleMin;
+    const Vector3& step = channel == TRACK_TRANSLATION ? clip->translationStep : clip->scaleStep;
+    out[0] = min.x + words[0] * step.x;
+    out[1] = min.y + words[1] * step.y;
+    out[2] = min.z + words[2] * step.z;
+}
+
+// Packs a clip's tracks with key times rounded to ticks of timeStep.
+// Returns NULL when its ticks don't fit 16 bits.
+QuantizedClip* quantizeTracks(const Track* tracks, int boneCount, float timeStep) {
+    QuantizedClip* clip = new QuantizedClip();
+    clip->timeStep = timeStep;
+
+    // Per-clip ranges of the translation and (non-unit) scale keys
+    float lo[TRACKS_PER_BONE][3], hi[TRACKS_PER_BONE][3];
+    for (int channel = 0; channel < TRACKS_PER_BONE; channel++) {
+        for (int c = 0; c < 3; c++) { lo[channel][c] = FLT_MAX; hi[channel][c] = -FLT_MAX; }
+    }
+    std::vector<bool> unitScale((size_t)boneCount, false);
+    const float one[3] = { 1.0f, 1.0f, 1.0f };
+    for (int t = 0; t < boneCount * TRACKS_PER_BONE; t++) {
+        const Track* track = &tracks[t];
+        int channel = t % TRACKS_PER_BONE;
+        if (channel == TRACK_ROTATION) continue;
+        if (channel == TRACK_SCALE && track->keyCount == 1 &&
+            channelError(track->values, one, TRACK_SCALE) <= converterOptions.tolerance.scale) {
+            unitScale[t / TRACKS_PER_BONE] = true;
+            continue;
+        }
+        for (int k = 0; k < track->keyCount; k++) {
+            for (int c = 0; c < 3; c++) {
+                lo[channel][c] = fminf(lo[channel][c], track->values[k * 3 + c]);
+                hi[channel][c] = fmaxf(hi[channel][c], track->values[k * 3 + c]);
+            }
+        }
+    }
+    Vector3* mins[TRACKS_PER_BONE] = { &clip->translationMin, NULL, &clip->scaleMin };
+    Vector3* steps[TRACKS_PER_BONE] = { &clip->translationStep, NULL, &clip->scaleStep };
+    for (int channel = 0; channel < TRACKS_PER_BONE; channel++) {
+        if (channel == TRACK_ROTATION) continue;
+        float min[3], step[3];
+        for (int c = 0; c < 3; c++) {
+            bool empty = lo[channel][c] > hi[channel][c];
+            min[c] = empty ? 0.0f : lo[channel][c];
+            step[c] = empty ? 0.0f : (hi[channel][c] - lo[channel][c]) / 65535.0f;
+        }
+        *mins[channel] = Vector3{ min[0], min[1], min[2] };
+        *steps[channel] = Vector3{ step[0], step[1], step[2] };
+    }
+
+    for (int t = 0; t < boneCount * TRACKS_PER_BONE; t++) {
+        const Track* track = &tracks[t];
+        int channel = t % TRACKS_PER_BONE;
+        if (channel == TRACK_SCALE && unitScale[t / TRACKS_PER_BONE]) {
+            clip->words.push_back(0);
+            continue;
+        }
+
+        clip->words.push_back((uint16_t)track->keyCount);
+        for (int k = 0; k < track->keyCount; k++) {
+            float tick = roundf(track->times[k] / timeStep);
+            if (tick > 65535.0f) {
+                delete clip;
+                return NULL;
+            }
+            clip->words.push_back((uint16_t)tick);
+        }
+        for (int k = 0; k < track->keyCount; k++) {
+            const float* value = &track->values[k * trackComponents(channel)];
+            uint16_t words[3];
+            if (channel == TRACK_ROTATION) {
+                encodeQuaternion(value, words);
+            } else {
+                const Vector3& min = *mins[channel];
+                const Vector3& step = *steps[channel];
+                words[0] = quantizeFixed(value[0], min.x, step.x);
+                words[1] = quantizeFixed(value[1], min.y, step.y);
+                words[2] = quantizeFixed(value[2], min.z, step.z);
+            }
+            clip->words.insert(clip->words.end(), words, words + 3);
+        }
+    }
+
+    // Keep whatever follows the words 4-byte aligned
+    if (clip->words.size() & 1) clip->words.push_back(0);
+    return clip;
+}
+
+// Largest difference between the packed clip, played back like the runtime
+// does, and the sampled source poses: units, degrees and scale per channel
+static void measureQuantizedError(const QuantizedClip* clip, const Transform* poses, const float* sampleTimes,
+                                  int frameCount, int boneCount, float maxError[TRACKS_PER_BONE]) {
+    for (int channel = 0; channel < TRACKS_PER_BONE; channel++) maxError[channel] = 0.0f;
+
+    size_t offset = 0;
+    for (int t = 0; t < boneCount * TRACKS_PER_BONE; t++) {
+        int bone = t / TRACKS_PER_BONE;
+        int channel = t % TRACKS_PER_BONE;
+        int keyCount = clip->words[offset];
+        const uint16_t* ticks = &clip->words[offset + 1];
+        const uint16_t* values = ticks + keyCount;
+        offset += 1 + (size_t)keyCount * 4;
+
+        int k = 0;
+        for (int frame = 0; frame < frameCount; frame++) {
+            float expected[4], actual[4], next[4];
+            float tick = sampleTimes[frame] / clip->timeStep;
+            channelValue(poses[frame * boneCount + bone], channel, expected);
+            if (keyCount == 0) {
+                actual[0] = actual[1] = actual[2] = 1.0f;
+            } else {
+                while (k + 1 < keyCount && ticks[k + 1] <= tick) k++;
+                decodeQuantizedValue(clip, channel, &values[k * 3], actual);
+                if (k + 1 < keyCount && tick > ticks[k]) {
+                    float alpha = (tick - ticks[k]) / (float)(ticks[k + 1] - ticks[k]);
+                    float current[4];
+                    memcpy(current, actual, sizeof(current));
+                    decodeQuantizedValue(clip, channel, &values[(k + 1) * 3], next);
+                    interpolateChannel(current, next, alpha, channel, actual);
+                }
+            }
+            maxError[channel] = fmaxf(maxError[channel], channelError(actual, expected, channel));
+        }
+    }
+}
+
+// Bytes of a clip's track data in the file
+static size_t trackBytes(const Track* tracks, int boneCount) {
+    size_t size = sizeof(uint32_t);
+    for (int t = 0; t < boneCount * TRACKS_PER_BONE; t++) {
+        size += sizeof(uint32_t) + tracks[t].keyCount * (1 + trackComponents(t % TRACKS_PER_BONE)) * sizeof(float);
+    }
+    return size;
+}
+
+static size_t quantizedBytes(const QuantizedClip* clip) {
+    return sizeof(float) + 4 * sizeof(Vector3) + sizeof(uint32_t) + clip->words.size() * sizeof(uint16_t);
+}
 
 
 
 
 
+
+// Welding key over the raw bits of every attribute the DMS vertex keeps
+static VertexWelder<7>::Key MakeVertexKey(const Vertex& v) {
+    VertexWelder<7>::Key key = {
+        VertexWelder<7>::FloatBits(v.x),
+        VertexWelder<7>::FloatBits(v.y),
+        VertexWelder<7>::FloatBits(v.z),
+        VertexWelder<7>::FloatBits(v.u),
+        VertexWelder<7>::FloatBits(v.v),
+        (uint32_t)(uint8_t)v.nx | ((uint32_t)(uint8_t)v.ny << 8) |
+            ((uint32_t)(uint8_t)v.nz << 16) | ((uint32_t)v.boneId << 24),
+        VertexWelder<7>::FloatBits(v.boneWeight)
+    };
+    return key;
+}
+
 // Function to extract strip information from a mesh
-MeshTriStrips ExtractTriStrips(const Mesh* srcMesh) {
+// Re-entrant: all working state is local, so meshes can be stripped in parallel
+MeshTriStrips ExtractTriStrips(const Mesh* srcMesh, StripStats* stats) {
     MeshTriStrips result;
     result.textureId = srcMesh->textureId;  //  Copy texture ID
 
-    std::map<std::string, uint32_t> tempVertexMap;
+    // Weld on position, UV, normal and bone; expect roughly one vertex per corner
+    size_t cornerCount = srcMesh->indexCount > 0 ? srcMesh->indexCount : srcMesh->vertexCount;
+    VertexWelder<7> welder(cornerCount);
     
     // Convert to triangles format
-    triangles.clear();
+    std::vector<Triangle> triangles;
+    triangles.reserve(cornerCount / 3);
     
     if (srcMesh->indexCount > 0 && srcMesh->indices) {
         // Indexed mesh - process triangles using indices
@@ -302,25 +1170,12 @@ MeshTriStrips ExtractTriStrips(const Mesh* srcMesh) {
                 int idx = srcMesh->indices[i + j];
                 const Vertex& v = srcMesh->vertices[idx];
                 
-                // Create vertex key - Updated for single bone
-                char key[256];  
-                snprintf(key, sizeof(key), 
-                "%.6f,%.6f,%.6f|%.6f,%.6f|%d,%d,%d|%u,%f",
-                v.x, v.y, v.z, v.u, v.v, (int)v.nx, (int)v.ny, (int)v.nz,
-                (unsigned int)v.boneId, v.boneWeight);
-
-
-                
                 // Look up or add vertex
-                auto it = tempVertexMap.find(key);
-                uint32_t vertex_idx;
-                if (it == tempVertexMap.end()) {
-                    vertex_idx = result.vertices.size();
-                    tempVertexMap[key] = vertex_idx;
+                bool inserted;
+                uint32_t vertex_idx = welder.Weld(MakeVertexKey(v), &inserted);
+                if (inserted) {
                     result.vertices.push_back(v);
                     result.vertexMap[idx] = vertex_idx;
-                } else {
-                    vertex_idx = it->second;
                 }
                 
                 // Setup triangle data
@@ -346,26 +1201,12 @@ MeshTriStrips ExtractTriStrips(const Mesh* srcMesh) {
             for (int j = 0; j < 3; j++) {
                 const Vertex& v = srcMesh->vertices[i + j];
                 
-                // Create vertex key - Updated for single bone
-                char key[256];  // Reduced size since we need less space now
-                snprintf(key, sizeof(key), 
-                "%.6f,%.6f,%.6f|%.6f,%.6f|%.6f,%.6f,%.6f|%u,%f",
-                v.x, v.y, v.z, v.u, v.v, 
-                (float)v.nx / 127.0f, (float)v.ny / 127.0f, (float)v.nz / 127.0f,
-                (unsigned int)v.boneId, v.boneWeight);
-
-
-                
                 // Look up or add vertex
-                auto it = tempVertexMap.find(key);
-                uint32_t vertex_idx;
-                if (it == tempVertexMap.end()) {
-                    vertex_idx = result.vertices.size();
-                    tempVertexMap[key] = vertex_idx;
+                bool inserted;
+                uint32_t vertex_idx = welder.Weld(MakeVertexKey(v), &inserted);
+                if (inserted) {
                     result.vertices.push_back(v);
                     result.vertexMap[i + j] = vertex_idx;
-                } else {
-                    vertex_idx = it->second;
                 }
                 
                 // Setup triangle data
@@ -384,8 +1225,9 @@ MeshTriStrips ExtractTriStrips(const Mesh* srcMesh) {
         }
     }
     
+    memset(stats, 0, sizeof(*stats));
     if (!triangles.empty()) {
-        optimize_mesh();
+        optimize_mesh(triangles, stats);
         
         std::map<uint32_t, std::vector<Triangle>> stripMap;
         for (const auto& tri : triangles) {
@@ -423,32 +1265,55 @@ MeshTriStrips ExtractTriStrips(const Mesh* srcMesh) {
     
     return result;
 }
-bool LoadGLTF(const char* filename) {
+bool LoadGLTF(const char* filename, Model* model, Skeleton* skeleton, std::vector<std::string>* bufferUris) {
     cgltf_options options = {};
+    MappedFiles mappedFiles;
+    InstallMappedFileReader(&options, &mappedFiles);
     cgltf_data* data = NULL;
     cgltf_result result = cgltf_parse_file(&options, filename, &data);
 
     if (result != cgltf_result_success) {
-        printf("Failed to parse GLTF file: %s\n", filename);
+        LogPrintf("Failed to parse GLTF file: %s\n", filename);
         return false;
     }
 
     result = cgltf_load_buffers(&options, data, filename);
     if (result != cgltf_result_success) {
-        printf("Failed to load GLTF buffers\n");
+        LogPrintf("Failed to load GLTF buffers\n");
         cgltf_free(data);
         return false;
     }
 
+    // External buffers the conversion depends on (the cache validates them)
+    for (cgltf_size i = 0; i < data->buffers_count; i++) {
+        const char* uri = data->buffers[i].uri;
+        if (!uri || strncmp(uri, "data:", 5) == 0) continue;
+        std::string decoded(uri);
+        decoded.resize(cgltf_decode_uri(&decoded[0]));
+        bufferUris->push_back(decoded);
+    }
+
     // Load skeleton
+    std::vector<int> jointBones;    // Skin joint index -> bone index, for JOINTS_0
     if (data->skins_count > 0) {
         cgltf_skin* skin = &data->skins[0];
-        skeleton.boneCount = (int)skin->joints_count;
-        skeleton.bones = (Bone*)calloc(skeleton.boneCount, sizeof(Bone));
+        skeleton->boneCount = (int)skin->joints_count;
+        skeleton->bones = (Bone*)calloc(skeleton->boneCount, sizeof(Bone));
+        std::vector<int> jointOrder = SortSkinJoints(skin);
+        jointBones.resize(jointOrder.size());
+        for (size_t i = 0; i < jointOrder.size(); i++) {
+            jointBones[jointOrder[i]] = (int)i;
+        }
+        JointIndexMap joints = BuildJointIndexMap(skin, jointOrder);
+        int reordered = 0;
+        for (size_t i = 0; i < jointOrder.size(); i++) reordered += jointOrder[i] != (int)i;
+        if (reordered > 0) LogPrintf("Reordered %d joints so parents come before children\n", reordered);
+
         // Load bone data
-        for (int i = 0; i < skeleton.boneCount; i++) {
-            cgltf_node* node = skin->joints[i];
-            Bone* bone = &skeleton.bones[i];
+        for (int i = 0; i < skeleton->boneCount; i++) {
+            int jointIndex = jointOrder[i];
+            cgltf_node* node = skin->joints[jointIndex];
+            Bone* bone = &skeleton->bones[i];
 
             // Set name
             if (node->name) {
@@ -460,7 +1325,7 @@ bool LoadGLTF(const char* filename) {
             // Get parent index
             bone->parent = -1;
             if (node->parent) {
-                bone->parent = GetNodeBoneIndex(node->parent, skin);
+                bone->parent = GetNodeBoneIndex(node->parent, joints);
             }
 
             // Get bind pose transform
@@ -480,7 +1345,7 @@ bool LoadGLTF(const char* filename) {
                     ibmAccessor->buffer_view->offset + ibmAccessor->offset);
 
                 // Reorder the floats from row-major to column-major:
-                float *m4 = &matrices[i * 16];
+                float *m4 = &matrices[jointIndex * 16];
                 Matrix tempIBM = {
                     m4[0],  m4[4],  m4[8],  m4[12],
                     m4[1],  m4[5],  m4[9],  m4[13],
@@ -494,8 +1359,8 @@ bool LoadGLTF(const char* filename) {
         }
 
         // Initialize world poses in correct hierarchy order
-        for (int i = 0; i < skeleton.boneCount; i++) {
-            Bone* bone = &skeleton.bones[i];
+        for (int i = 0; i < skeleton->boneCount; i++) {
+            Bone* bone = &skeleton->bones[i];
 
             // Convert bind pose to matrix (Local transform)
             Matrix translation = MatrixTranslate(
@@ -519,18 +1384,19 @@ bool LoadGLTF(const char* filename) {
             }
             // For child bones, multiply with parent's world transform
             else {
-                bone->worldPose = MatrixMultiply(localTransform, skeleton.bones[bone->parent].worldPose);
+                bone->worldPose = MatrixMultiply(localTransform, skeleton->bones[bone->parent].worldPose);
             }
         }
 
 
         // Load animations if available
         if (data->animations_count > 0) {
-            skeleton.animCount = (int)data->animations_count;
-            skeleton.animations = (Animation*)calloc(skeleton.animCount, sizeof(Animation));
-            for (int i = 0; i < skeleton.animCount; i++) {
+            skeleton->animCount = (int)data->animations_count;
+            skeleton->animations = (Animation*)calloc(skeleton->animCount, sizeof(Animation));
+            size_t quantizedSaved = 0;
+            for (int i = 0; i < skeleton->animCount; i++) {
                 cgltf_animation* srcAnim = &data->animations[i];
-                Animation* dstAnim = &skeleton.animations[i];
+                Animation* dstAnim = &skeleton->animations[i];
 
                 // Set animation name
                 if (srcAnim->name) {
@@ -539,128 +1405,194 @@ bool LoadGLTF(const char* filename) {
                     snprintf(dstAnim->name, sizeof(dstAnim->name), "anim_%d", i);
                 }
 
+                // Copy out the channels that drive bones
+                std::vector<ChannelKeys> channelKeys;
+                std::vector<const cgltf_animation_channel*> channels;
+                channelKeys.reserve(srcAnim->channels_count);
+                for (size_t channelId = 0; channelId < srcAnim->channels_count; channelId++) {
+                    const cgltf_animation_channel* channel = &srcAnim->channels[channelId];
+                    if (GetNodeBoneIndex(channel->target_node, joints) < 0) continue;
+
+                    int components;
+                    switch (channel->target_path) {
+                        case cgltf_animation_path_type_translation:
+                        case cgltf_animation_path_type_scale: components = 3; break;
+                        case cgltf_animation_path_type_rotation: components = 4; break;
+                        default: continue;
+                    }
+                    ChannelKeys keys;
+                    if (!LoadChannelKeys(channel->sampler, components, &keys)) {
+                        LogPrintf("Animation '%s': skipping channel %zu with mismatched keys\n", dstAnim->name, channelId);
+                        continue;
+                    }
+                    channelKeys.push_back(std::move(keys));
+                    channels.push_back(channel);
+                }
+
                 // Find animation duration
                 dstAnim->duration = 0.0f;
                 for (size_t c = 0; c < srcAnim->channels_count; c++) {
-                    cgltf_accessor* input = srcAnim->channels[c].sampler->input;
-                    float* times = (float*)((char*)input->buffer_view->buffer->data +
-                        input->buffer_view->offset + input->offset);
-                    float lastTime = times[input->count - 1];
+                    const cgltf_accessor* input = srcAnim->channels[c].sampler->input;
+                    float lastTime = 0.0f;
+                    if (input->count > 0) cgltf_accessor_read_float(input, input->count - 1, &lastTime, 1);
                     if (lastTime > dstAnim->duration) {
                         dstAnim->duration = lastTime;
                     }
                 }
 
-                // Calculate frame count (30 FPS)
-                dstAnim->frameCount = (int)(dstAnim->duration * 30.0f) + 1;  // Look at this later.
-                dstAnim->boneCount = skeleton.boneCount;
+                std::vector<float> sampleTimes = ClipSampleTimes(channelKeys, dstAnim->duration,
+                                                                 converterOptions.sampleRate,
+                                                                 converterOptions.nativeKeys);
+                dstAnim->frameCount = (int)sampleTimes.size();
+                dstAnim->boneCount = skeleton->boneCount;
 
                 // Allocate frame poses (as array of Transforms)
-                Transform* poses = (Transform*)calloc(dstAnim->frameCount * skeleton.boneCount, sizeof(Transform));
+                Transform* poses = (Transform*)calloc(dstAnim->frameCount * skeleton->boneCount, sizeof(Transform));
                 // Initialize all poses to bind pose
                 for (int frame = 0; frame < dstAnim->frameCount; frame++) {
-                    for (int bone = 0; bone < skeleton.boneCount; bone++) {
-                        poses[frame * skeleton.boneCount + bone] = skeleton.bones[bone].bindPose;
+                    for (int bone = 0; bone < skeleton->boneCount; bone++) {
+                        poses[frame * skeleton->boneCount + bone] = skeleton->bones[bone].bindPose;
                     }
                 }
 
                 // Sample animation channels
-                for (size_t channelId = 0; channelId < srcAnim->channels_count; channelId++) {
-                    cgltf_animation_channel* channel = &srcAnim->channels[channelId];
-                    int boneIndex = GetNodeBoneIndex(channel->target_node, skin);
-                    if (boneIndex < 0) continue;
-
-                    cgltf_animation_sampler* sampler = channel->sampler;
-                    float* times = (float*)((char*)sampler->input->buffer_view->buffer->data +
-                        sampler->input->buffer_view->offset + sampler->input->offset);
-                    float* values = (float*)((char*)sampler->output->buffer_view->buffer->data +
-                        sampler->output->buffer_view->offset + sampler->output->offset);
-
-                    // Sample this channel at each frame time
+                for (size_t c = 0; c < channels.size(); c++) {
+                    const cgltf_animation_channel* channel = channels[c];
+                    int boneIndex = GetNodeBoneIndex(channel->target_node, joints);
                     for (int frame = 0; frame < dstAnim->frameCount; frame++) {
-                        float time = frame * (1.0f / 30.0f);
-
-                        // Find surrounding keyframes
-                        int prevKey = 0;
-                        int nextKey = 0;
-                        for (size_t k = 0; k < sampler->input->count - 1; k++) {
-                            if (times[k] <= time && times[k + 1] >= time) {
-                                prevKey = (int)k;
-                                nextKey = (int)k + 1;
-                                break;
-                            }
-                        }
-
-                        // Get interpolation factor
-                        float alpha = (time - times[prevKey]) / (times[nextKey] - times[prevKey]);
-                        if (alpha < 0.0f) alpha = 0.0f;
-                        if (alpha > 1.0f) alpha = 1.0f;
-
-                        Transform* pose = &poses[frame * skeleton.boneCount + boneIndex];
+                        Transform* pose = &poses[frame * skeleton->boneCount + boneIndex];
+                        float value[4];
+                        EvaluateChannelKeys(&channelKeys[c], sampleTimes[frame], value);
 
                         // Apply channel data based on path
                         switch (channel->target_path) {
-                            case cgltf_animation_path_type_translation: {
-                                Vector3 prev = { values[prevKey * 3], values[prevKey * 3 + 1], values[prevKey * 3 + 2] };
-                                Vector3 next = { values[nextKey * 3], values[nextKey * 3 + 1], values[nextKey * 3 + 2] };
-                                pose->translation = Vector3Lerp(prev, next, alpha);
-                            } break;
-                            case cgltf_animation_path_type_rotation: {
-                                Quaternion prev = {
-                                    values[prevKey * 4], values[prevKey * 4 + 1],
-                                    values[prevKey * 4 + 2], values[prevKey * 4 + 3]
-                                };
-                                Quaternion next = {
-                                    values[nextKey * 4], values[nextKey * 4 + 1],
-                                    values[nextKey * 4 + 2], values[nextKey * 4 + 3]
-                                };
-                                pose->rotation = QuaternionSlerp(prev, next, alpha);
-                            } break;
-                            case cgltf_animation_path_type_scale: {
-                                Vector3 prev = { values[prevKey * 3], values[prevKey * 3 + 1], values[prevKey * 3 + 2] };
-                                Vector3 next = { values[nextKey * 3], values[nextKey * 3 + 1], values[nextKey * 3 + 2] };
-                                pose->scale = Vector3Lerp(prev, next, alpha);
-                            } break;
+                            case cgltf_animation_path_type_translation:
+                                pose->translation = Vector3{ value[0], value[1], value[2] };
+                                break;
+                            case cgltf_animation_path_type_rotation:
+                                pose->rotation = Quaternion{ value[0], value[1], value[2], value[3] };
+                                break;
+                            case cgltf_animation_path_type_scale:
+                                pose->scale = Vector3{ value[0], value[1], value[2] };
+                                break;
                             default: break;
                         }
                     }
                 }
 
-                int reducedFrames = reduceKeyframes(poses, dstAnim->frameCount, dstAnim->boneCount);
-                printf("Animation '%s': Reduced from %d to %d frames\n", dstAnim->name, dstAnim->frameCount, reducedFrames);
-                dstAnim->frameCount = reducedFrames;  // Update the frame count
+                if (converterOptions.dmsVersion >= 2) {
+                    // Bone tolerance over clip tolerance over the default
+                    std::vector<TrackTolerance> tolerances(dstAnim->boneCount, converterOptions.tolerance);
+                    auto clipTolerance = converterOptions.clipTolerances.find(dstAnim->name);
+                    for (int bone = 0; bone < dstAnim->boneCount; bone++) {
+                        auto boneTolerance = converterOptions.boneTolerances.find(skeleton->bones[bone].name);
+                        if (boneTolerance != converterOptions.boneTolerances.end()) {
+                            tolerances[bone] = boneTolerance->second;
+                        } else if (clipTolerance != converterOptions.clipTolerances.end()) {
+                            tolerances[bone] = clipTolerance->second;
+                        }
+                    }
+
+                    dstAnim->tracks = buildBoneTracks(poses, sampleTimes.data(), dstAnim->frameCount,
+                                                      dstAnim->boneCount, tolerances.data());
+                    float worldError = 0.0f, worldTolerance = 0.0f;
+                    int passes = 0;
+                    if (converterOptions.worldTolerance != 0.0f) {
+                        worldError = refineWorldError(dstAnim->tracks, poses, sampleTimes.data(), dstAnim->frameCount,
+                                                      skeleton->bones, dstAnim->boneCount, tolerances.data(),
+                                                      converterOptions.worldTolerance, &worldTolerance, &passes);
+                    }
+
+                    int keys[TRACKS_PER_BONE] = { 0 };
+                    for (int t = 0; t < dstAnim->boneCount * TRACKS_PER_BONE; t++) {
+                        keys[t % TRACKS_PER_BONE] += dstAnim->tracks[t].keyCount;
+                    }
+                    LogPrintf("Animation '%s': %d samples -> %d translation, %d rotation, %d scale keys\n",
+                              dstAnim->name, dstAnim->frameCount, keys[TRACK_TRANSLATION],
+                              keys[TRACK_ROTATION], keys[TRACK_SCALE]);
+                    if (converterOptions.worldTolerance != 0.0f) {
+                        LogPrintf("Animation '%s': max bone position error %.4f (tolerance %.4f) after %d refinement passes\n",
+                                  dstAnim->name, worldError, worldTolerance, passes);
+                    }
+
+                    if (converterOptions.quantizeAnimations) {
+                        // Ticks on the sample grid, or as fine as 16 bits allow
+                        // across the clip for authored key times
+                        float timeStep = 1.0f / converterOptions.sampleRate;
+                        if (converterOptions.nativeKeys && dstAnim->duration > 0.0f) {
+                            timeStep = dstAnim->duration / 65535.0f;
+                        }
+                        dstAnim->quantized = quantizeTracks(dstAnim->tracks, dstAnim->boneCount, timeStep);
+                        if (dstAnim->quantized) {
+                            float maxError[TRACKS_PER_BONE];
+                            measureQuantizedError(dstAnim->quantized, poses, sampleTimes.data(),
+                                                  dstAnim->frameCount, dstAnim->boneCount, maxError);
+                            size_t before = trackBytes(dstAnim->tracks, dstAnim->boneCount);
+                            size_t after = quantizedBytes(dstAnim->quantized);
+                            quantizedSaved += before - after;
+                            LogPrintf("Animation '%s': quantized %zu -> %zu bytes, max error %.4f units, %.3f deg, %.4f scale\n",
+                                      dstAnim->name, before, after, maxError[TRACK_TRANSLATION],
+                                      maxError[TRACK_ROTATION], maxError[TRACK_SCALE]);
+                        } else {
+                            LogPrintf("Animation '%s': too long to quantize, keeping float keys\n", dstAnim->name);
+                        }
+                    }
+                    free(poses);
+                } else {
+                    int reducedFrames = reduceKeyframes(poses, dstAnim->frameCount, dstAnim->boneCount);
+                    LogPrintf("Animation '%s': Reduced from %d to %d frames\n", dstAnim->name, dstAnim->frameCount, reducedFrames);
+                    dstAnim->frameCount = reducedFrames;  // Update the frame count
 
-                dstAnim->framePoses = (Transform**)poses;
+                    dstAnim->framePoses = (Transform**)poses;
+                }
 
  
             }
+            if (converterOptions.quantizeAnimations) {
+                LogPrintf("Quantized animations: %zu bytes saved\n", quantizedSaved);
+            }
         }
     } else {
         // Initialize empty animation data
-        skeleton.animCount = 0;
-        skeleton.animations = NULL;
+        skeleton->animCount = 0;
+        skeleton->animations = NULL;
     }
 
     // Free existing mesh data if it exists
-    if (model.meshes) {
-        for (int i = 0; i < model.meshCount; i++) {
-            if (model.meshes[i].vertices) free(model.meshes[i].vertices);
-            if (model.meshes[i].indices) free(model.meshes[i].indices);
+    if (model->meshes) {
+        for (int i = 0; i < model->meshCount; i++) {
+            if (model->meshes[i].vertices) free(model->meshes[i].vertices);
+            if (model->meshes[i].indices) free(model->meshes[i].indices);
+            if (model->meshes[i].stripLengths) free(model->meshes[i].stripLengths);
         }
-        free(model.meshes);
+        free(model->meshes);
     }
 
     // Reset mesh count and other model data
-    model.meshCount = 0;
-    model.meshes = NULL;
+    model->meshCount = 0;
+    model->meshes = NULL;
 
     // Associate skeleton with model
-    model.skeleton = &skeleton;
+    model->skeleton = skeleton;
+
+    // Texture names for the material table: the image's name, else its file
+    // name without extension
+    free(model->textureNames);
+    model->textureCount = (int)data->images_count;
+    model->textureNames = (char (*)[64])calloc(data->images_count ? data->images_count : 1, 64);
+    for (size_t i = 0; i < data->images_count; i++) {
+        const cgltf_image* image = &data->images[i];
+        std::string name = image->name ? image->name : "";
+        if (name.empty() && image->uri && strncmp(image->uri, "data:", 5) != 0) {
+            name = std::filesystem::path(image->uri).stem().string();
+        }
+        strncpy(model->textureNames[i], name.c_str(), 63);
+    }
 
     // Load meshes
        if (data->meshes_count > 0) {
-        model.meshCount = (int)data->meshes_count;
-        model.meshes = (Mesh*)calloc(model.meshCount, sizeof(Mesh));
+        model->meshCount = (int)data->meshes_count;
+        model->meshes = (Mesh*)calloc(model->meshCount, sizeof(Mesh));
 
 
 
@@ -668,7 +1600,7 @@ bool LoadGLTF(const char* filename) {
 
         for (size_t m = 0; m < data->meshes_count; m++) {
             cgltf_mesh* srcMesh = &data->meshes[m];
-            Mesh* dstMesh = &model.meshes[m];
+            Mesh* dstMesh = &model->meshes[m];
             dstMesh->textureId = -1;
 
             // First, count total vertices and indices across all primitives
@@ -684,7 +1616,7 @@ bool LoadGLTF(const char* filename) {
                     // If there's a base color texture, use its index as texture ID
                     if (pbr->base_color_texture.texture) {
                         dstMesh->textureId = pbr->base_color_texture.texture->image - data->images;
-                        printf("Mesh %zu using texture ID: %d\n", m, dstMesh->textureId);
+                        LogPrintf("Mesh %zu using texture ID: %d\n", m, dstMesh->textureId);
                     }
                 }
                 
@@ -701,9 +1633,7 @@ bool LoadGLTF(const char* filename) {
             }
 
             // Allocate combined buffers
-             dstMesh->vertices = (Vertex*)calloc(totalVertices, sizeof(Vertex));
-            dstMesh->originalVertices = (Vertex*)calloc(totalVertices, sizeof(Vertex));
-            dstMesh->animatedVertices = (Vertex*)calloc(totalVertices, sizeof(Vertex));  
+            dstMesh->vertices = (Vertex*)calloc(totalVertices, sizeof(Vertex));
             dstMesh->indices = (unsigned int*)calloc(totalIndices, sizeof(unsigned int));
             
             // Keep track of current offsets as we combine primitives
@@ -723,95 +1653,68 @@ bool LoadGLTF(const char* filename) {
                     }
                 }
 
-                // Load vertex attributes
+                // Load vertex attributes straight from the (mapped) buffers
                 for (size_t a = 0; a < primitive->attributes_count; a++) {
                     cgltf_attribute* attr = &primitive->attributes[a];
                     cgltf_accessor* accessor = attr->data;
+                    Vertex* dst = &dstMesh->vertices[vertexOffset];
 
                     switch (attr->type) {
                         case cgltf_attribute_type_position: {
-                            for (size_t v = 0; v < accessor->count; v++) {
-                                cgltf_accessor_read_float(accessor, v, 
-                                    &dstMesh->vertices[vertexOffset + v].x, 3);
-                                // Copy to original vertices
-                                dstMesh->originalVertices[vertexOffset + v].x = 
-                                    dstMesh->vertices[vertexOffset + v].x;
-                                dstMesh->originalVertices[vertexOffset + v].y = 
-                                    dstMesh->vertices[vertexOffset + v].y;
-                                dstMesh->originalVertices[vertexOffset + v].z = 
-                                    dstMesh->vertices[vertexOffset + v].z;
-                            }
+                            ForEachFloatElement(accessor, 3, [&](size_t v, const float* position) {
+                                dst[v].x = position[0];
+                                dst[v].y = position[1];
+                                dst[v].z = position[2];
+                            });
                         } break;
 
                         case cgltf_attribute_type_normal: {
-                            for (size_t v = 0; v < accessor->count; v++) {
-                                // Create temporary buffer for float values
-                                float temp[3];
-                                cgltf_accessor_read_float(accessor, v, temp, 3);
-                                
-                                // Convert floats to bytes (normalized from -1.0...1.0 to -127...127)
-                                dstMesh->vertices[vertexOffset + v].nx = (int8_t)(temp[0] * 127.0f);
-                                dstMesh->vertices[vertexOffset + v].ny = (int8_t)(temp[1] * 127.0f);
-                                dstMesh->vertices[vertexOffset + v].nz = (int8_t)(temp[2] * 127.0f);
-                                
-                                // Copy to original vertices
-                                dstMesh->originalVertices[vertexOffset + v].nx = dstMesh->vertices[vertexOffset + v].nx;
-                                dstMesh->originalVertices[vertexOffset + v].ny = dstMesh->vertices[vertexOffset + v].ny;
-                                dstMesh->originalVertices[vertexOffset + v].nz = dstMesh->vertices[vertexOffset + v].nz;
-                            }
+                            // Convert floats to bytes (normalized from -1.0...1.0 to -127...127)
+                            ForEachFloatElement(accessor, 3, [&](size_t v, const float* normal) {
+                                dst[v].nx = (int8_t)(normal[0] * 127.0f);
+                                dst[v].ny = (int8_t)(normal[1] * 127.0f);
+                                dst[v].nz = (int8_t)(normal[2] * 127.0f);
+                            });
                         } break;
 
                         case cgltf_attribute_type_texcoord: {
-                            for (size_t v = 0; v < accessor->count; v++) {
-                                cgltf_accessor_read_float(accessor, v, 
-                                    &dstMesh->vertices[vertexOffset + v].u, 2);
-                                dstMesh->originalVertices[vertexOffset + v].u = 
-                                    dstMesh->vertices[vertexOffset + v].u;
-                                dstMesh->originalVertices[vertexOffset + v].v = 
-                                    dstMesh->vertices[vertexOffset + v].v;
-                            }
+                            ForEachFloatElement(accessor, 2, [&](size_t v, const float* uv) {
+                                dst[v].u = uv[0];
+                                dst[v].v = uv[1];
+                            });
                         } break;
 
-
-
                         case cgltf_attribute_type_joints: {
-                            for (size_t v = 0; v < accessor->count; v++) {
-                                cgltf_uint jointIds[4] = {0};
-                                cgltf_accessor_read_uint(accessor, v, jointIds, 4);
-                                
-                                // Only store the first joint
-                        if (jointIds[0] > 255) {
-                            printf("Warning: Joint ID %u exceeds uint8_t range\n", jointIds[0]);
-                            jointIds[0] = 255;
-                        }
-                        dstMesh->vertices[vertexOffset + v].boneId = (uint8_t)jointIds[0];
-                        dstMesh->originalVertices[vertexOffset + v].boneId = (uint8_t)jointIds[0];
-
-                            }
+                            // Only store the first joint
+                            ForEachUintElement(accessor, 4, [&](size_t v, const cgltf_uint* jointIds) {
+                                cgltf_uint joint = jointIds[0];
+                                if (joint < jointBones.size()) joint = (cgltf_uint)jointBones[joint];
+                                if (joint > 255) {
+                                    LogPrintf("Warning: Joint ID %u exceeds uint8_t range\n", joint);
+                                    joint = 255;
+                                }
+                                dst[v].boneId = (uint8_t)joint;
+                            });
                         } break;
 
-
                         case cgltf_attribute_type_weights: {
-                        for (size_t v = 0; v < accessor->count; v++) {
-                            float weights[4] = {0};
-                            cgltf_accessor_read_float(accessor, v, weights, 4);
-                            
                             // Only store the first weight
-                            dstMesh->vertices[vertexOffset + v].boneWeight = weights[0];
-                            dstMesh->originalVertices[vertexOffset + v].boneWeight = weights[0];
-                        }
-                    } break;
-
+                            ForEachFloatElement(accessor, 4, [&](size_t v, const float* weights) {
+                                dst[v].boneWeight = weights[0];
+                            });
+                        } break;
 
+                        default:
+                            break;
                     }
                 }
 
                 // Load indices
                 if (primitive->indices) {
-                    for (size_t i = 0; i < primitive->indices->count; i++) {
-                        dstMesh->indices[indexOffset + i] = 
-                            (unsigned int)cgltf_accessor_read_index(primitive->indices, i) + vertexOffset;
-                    }
+                    unsigned int* dstIndices = &dstMesh->indices[indexOffset];
+                    ForEachUintElement(primitive->indices, 1, [&](size_t i, const cgltf_uint* index) {
+                        dstIndices[i] = (unsigned int)index[0] + vertexOffset;
+                    });
                     indexOffset += (int)primitive->indices->count;
                 }
 
@@ -822,7 +1725,7 @@ bool LoadGLTF(const char* filename) {
             dstMesh->vertexCount = totalVertices;
             dstMesh->indexCount = totalIndices;
 
-            printf("Loaded mesh %zu with %d vertices and %d indices\n", 
+            LogPrintf("Loaded mesh %zu with %d vertices and %d indices\n", 
                   m, dstMesh->vertexCount, dstMesh->indexCount);
         }
     }
@@ -835,34 +1738,146 @@ bool LoadGLTF(const char* filename) {
 
  
 
-void CreateTristrippedModel(const Model* sourceModel, Model* destModel)
-{
-    printf("Creating tristripped model...\n");
-    
-    // Copy skeleton pointer and allocate new mesh array
-    destModel->skeleton = sourceModel->skeleton;
-    destModel->meshCount = sourceModel->meshCount;
-    destModel->meshes = (Mesh*)calloc(destModel->meshCount, sizeof(Mesh));
+// Bone a vertex follows as a whole when the runtimes skin it, else -1
+static int SkinningBone(const Vertex& v, const Skeleton* skeleton) {
+    return (v.boneWeight > 0.0f && v.boneId < skeleton->boneCount) ? v.boneId : -1;
+}
 
-    // Process each mesh from the source model
-    for (int m = 0; m < sourceModel->meshCount; m++)
-    {
-        const Mesh* srcMesh = &sourceModel->meshes[m];
-        Mesh* dstMesh = &destModel->meshes[m];
+// Triangles of an indexed mesh, given by their first index, as a new mesh
+// holding only the vertices they use
+static Mesh ExtractTriangles(const Mesh* source, const std::vector<int>& triangles) {
+    Mesh mesh = {};
+    mesh.textureId = source->textureId;
+    mesh.indexCount = (int)triangles.size() * 3;
+    mesh.indices = (unsigned int*)calloc(mesh.indexCount, sizeof(unsigned int));
+
+    std::vector<int> remap(source->vertexCount, -1);
+    std::vector<Vertex> vertices;
+    int i = 0;
+    for (int t : triangles) {
+        for (int c = 0; c < 3; c++) {
+            unsigned int index = source->indices[t + c];
+            if (remap[index] < 0) {
+                remap[index] = (int)vertices.size();
+                vertices.push_back(source->vertices[index]);
+            }
+            mesh.indices[i++] = (unsigned int)remap[index];
+        }
+    }
+
+    mesh.vertexCount = (int)vertices.size();
+    mesh.vertices = (Vertex*)calloc(mesh.vertexCount, sizeof(Vertex));
+    memcpy(mesh.vertices, vertices.data(), vertices.size() * sizeof(Vertex));
+    return mesh;
+}
+
+// --rigid-parts: splits every skinned mesh into one mesh per bone with the
+// triangles whose corners all follow that bone, and a skinned remainder with
+// the rest. Runtimes draw a rigid part through its bone's world pose and
+// never skin it. Parts keep their source's texture; the remainder comes
+// first, then the parts in bone order.
+static void SplitRigidParts(Model* model) {
+    const Skeleton* skeleton = model->skeleton;
+    std::vector<Mesh> meshes;
+
+    for (int m = 0; m < model->meshCount; m++) {
+        Mesh* source = &model->meshes[m];
+        std::vector<std::vector<int>> parts(skeleton->boneCount);
+        std::vector<int> remainder;
+        for (int t = 0; source->indices && t + 2 < source->indexCount; t += 3) {
+            int bone = SkinningBone(source->vertices[source->indices[t]], skeleton);
+            if (bone >= 0 && SkinningBone(source->vertices[source->indices[t + 1]], skeleton) == bone &&
+                SkinningBone(source->vertices[source->indices[t + 2]], skeleton) == bone) {
+                parts[bone].push_back(t);
+            } else {
+                remainder.push_back(t);
+            }
+        }
+
+        int partCount = 0;
+        size_t rigidTriangles = 0;
+        for (std::vector<int>& part : parts) {
+            if (part.empty()) continue;
+            if (part.size() < RIGID_PART_MIN_TRIANGLES) {
+                remainder.insert(remainder.end(), part.begin(), part.end());
+                part.clear();
+                continue;
+            }
+            partCount++;
+            rigidTriangles += part.size();
+        }
+        LogPrintf("Rigid parts of mesh %d: %d parts with %zu of %d triangles\n",
+                  m, partCount, rigidTriangles, source->indexCount / 3);
+
+        // Nothing rigid: the mesh stays as it is
+        if (partCount == 0) {
+            meshes.push_back(*source);
+            continue;
+        }
+
+        if (!remainder.empty()) {
+            std::sort(remainder.begin(), remainder.end());  // Source order, for the stripper
+            meshes.push_back(ExtractTriangles(source, remainder));
+        }
+        for (const std::vector<int>& part : parts) {
+            if (part.empty()) continue;
+            meshes.push_back(ExtractTriangles(source, part));
+            meshes.back().rigid = true;
+        }
+        free(source->vertices);
+        free(source->indices);
+        free(source->stripLengths);
+    }
+
+    free(model->meshes);
+    model->meshCount = (int)meshes.size();
+    model->meshes = (Mesh*)calloc(meshes.size(), sizeof(Mesh));
+    memcpy(model->meshes, meshes.data(), meshes.size() * sizeof(Mesh));
+}
+
+void CreateTristrippedModel(const Model* sourceModel, Model* destModel, WorkerPool& pool,
+                            ConversionSummary* summary)
+{
+    LogPrintf("Creating tristripped model (%d threads)...\n", pool.ThreadCount());
+    
+    // Copy skeleton pointer and allocate new mesh array
+    destModel->skeleton = sourceModel->skeleton;
+    destModel->textureNames = sourceModel->textureNames;
+    destModel->textureCount = sourceModel->textureCount;
+    destModel->meshCount = sourceModel->meshCount;
+    destModel->meshes = (Mesh*)calloc(destModel->meshCount, sizeof(Mesh));
+
+    // Strip every mesh on the pool; results land in mesh order so the
+    // output does not depend on the thread count
+    std::vector<MeshTriStrips> meshStrips(sourceModel->meshCount);
+    std::vector<StripStats> meshStats(sourceModel->meshCount);
+    pool.ParallelFor(sourceModel->meshCount, [&](size_t m) {
+        meshStrips[m] = ExtractTriStrips(&sourceModel->meshes[m], &meshStats[m]);
+    });
+
+    // Process each mesh from the source model
+    for (int m = 0; m < sourceModel->meshCount; m++)
+    {
+        const Mesh* srcMesh = &sourceModel->meshes[m];
+        Mesh* dstMesh = &destModel->meshes[m];
                 // Copy texture ID from source mesh
                 dstMesh->textureId = srcMesh->textureId;  // NEW: Copy texture ID
+        dstMesh->rigid = srcMesh->rigid;
 
 
-        printf("Processing mesh %d of %d...\n", m + 1, sourceModel->meshCount);
-        printf("Source mesh has %d vertices and %d indices\n", srcMesh->vertexCount, srcMesh->indexCount);
+        LogPrintf("Processing mesh %d of %d...\n", m + 1, sourceModel->meshCount);
+        LogPrintf("Source mesh has %d vertices and %d indices\n", srcMesh->vertexCount, srcMesh->indexCount);
 
-        // Use the new ExtractTriStrips function to get optimized data
-        MeshTriStrips tristrips = ExtractTriStrips(srcMesh);
+        MeshTriStrips& tristrips = meshStrips[m];
+        if (meshStats[m].input_triangles > 0) {
+            PrintStripStats(meshStats[m]);
+        }
+        summary->triangles += meshStats[m].input_triangles;
+        summary->strips += meshStats[m].strips;
 
         // Allocate destination mesh memory
         dstMesh->vertexCount = tristrips.vertices.size();
         dstMesh->vertices = (Vertex*)calloc(dstMesh->vertexCount, sizeof(Vertex));
-        dstMesh->animatedVertices = (Vertex*)calloc(dstMesh->vertexCount, sizeof(Vertex));
 
         // Copy optimized vertices to bind pose buffer (already done)
         memcpy(dstMesh->vertices, tristrips.vertices.data(), 
@@ -881,14 +1896,16 @@ void CreateTristrippedModel(const Model* sourceModel, Model* destModel)
         // Allocate and fill index buffer
         dstMesh->indexCount = totalIndices;
         dstMesh->indices = (unsigned int*)calloc(dstMesh->indexCount, sizeof(unsigned int));
+        dstMesh->stripCount = (int)tristrips.strips.size();
+        dstMesh->stripLengths = (unsigned int*)calloc(dstMesh->stripCount, sizeof(unsigned int));
 
-        // Copy indices - first the strips
+        // Copy indices - first the strips, with their lengths in the strip table
         size_t indexOffset = 0;
-        for (const auto& strip : tristrips.strips) {
+        for (size_t s = 0; s < tristrips.strips.size(); s++) {
+            const StripInfo& strip = tristrips.strips[s];
+            dstMesh->stripLengths[s] = (unsigned int)strip.indices.size();
             for (size_t i = 0; i < strip.indices.size(); i++) {
-                // Mark strip indices with the high bit and strip ID
-                dstMesh->indices[indexOffset++] = 
-                    (0x80000000 | (strip.stripId << 24)) | strip.indices[i];
+                dstMesh->indices[indexOffset++] = strip.indices[i];
             }
         }
 
@@ -897,15 +1914,18 @@ void CreateTristrippedModel(const Model* sourceModel, Model* destModel)
             dstMesh->indices[indexOffset++] = idx;
         }
 
-        printf("Mesh %d processed:\n", m + 1);
-        printf("  Original vertices:    %d\n", srcMesh->vertexCount);
-        printf("  Optimized vertices:   %d\n", dstMesh->vertexCount);
-        printf("  Total strips:         %zu\n", tristrips.strips.size());
-        printf("  Loose triangles:      %zu\n", tristrips.looseTriangles.size() / 3);
-        printf("  Total indices:        %d\n", dstMesh->indexCount);
+        LogPrintf("Mesh %d processed:\n", m + 1);
+        LogPrintf("  Original vertices:    %d\n", srcMesh->vertexCount);
+        LogPrintf("  Optimized vertices:   %d\n", dstMesh->vertexCount);
+        LogPrintf("  Total strips:         %zu\n", tristrips.strips.size());
+        LogPrintf("  Loose triangles:      %zu\n", tristrips.looseTriangles.size() / 3);
+        LogPrintf("  Total indices:        %d\n", dstMesh->indexCount);
+
+        // Release the per-mesh working set as we go
+        tristrips = MeshTriStrips();
     }
 
-    printf("Tristripped model creation complete!\n");
+    LogPrintf("Tristripped model creation complete!\n");
 }
 
  
@@ -914,141 +1934,564 @@ void CreateTristrippedModel(const Model* sourceModel, Model* destModel)
  
 
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <gltf_file>\n", argv[0]);
-        return 1;
+void Cleanup(Skeleton* skeleton, Model* model, Model* tristrippedModel) {
+    if (skeleton->bones) {
+        free(skeleton->bones);
     }
-
-    const char* inputFilename = argv[1];
     
+    if (skeleton->animations) {
+        for (int i = 0; i < skeleton->animCount; i++) {
+            if (skeleton->animations[i].framePoses) {
+                free(skeleton->animations[i].framePoses);
+            }
+            if (skeleton->animations[i].tracks) {
+                for (int t = 0; t < skeleton->animations[i].boneCount * TRACKS_PER_BONE; t++) {
+                    free(skeleton->animations[i].tracks[t].times);
+                    free(skeleton->animations[i].tracks[t].values);
+                }
+                free(skeleton->animations[i].tracks);
+            }
+            delete skeleton->animations[i].quantized;
+        }
+        free(skeleton->animations);
+    }
+    
+    if (model->meshes) {
+        for (int i = 0; i < model->meshCount; i++) {
+            if (model->meshes[i].vertices) free(model->meshes[i].vertices);
+            if (model->meshes[i].indices) free(model->meshes[i].indices);
+            if (model->meshes[i].stripLengths) free(model->meshes[i].stripLengths);
+        }
+        free(model->meshes);
+    }
+    free(model->textureNames);  // Shared with the tristripped model
+    
+    if (tristrippedModel->meshes) {
+        for (int i = 0; i < tristrippedModel->meshCount; i++) {
+            if (tristrippedModel->meshes[i].vertices) free(tristrippedModel->meshes[i].vertices);
+            if (tristrippedModel->meshes[i].indices) free(tristrippedModel->meshes[i].indices);
+            if (tristrippedModel->meshes[i].stripLengths) free(tristrippedModel->meshes[i].stripLengths);
+        }
+        free(tristrippedModel->meshes);
+    }
+}
+
+// Hash of everything besides the input bytes that shapes the output
+static uint64_t CacheSettingsHash() {
+    char settings[512];
+    const TrackTolerance& tolerance = converterOptions.tolerance;
+    snprintf(settings, sizeof(settings),
+             "%s pos=%a rot=%a scale=%a track=%a,%a,%a span=%d world=%a,%d strip=%d,%d,%d,%d stitch=%d dms=%d quantize=%d rate=%a native=%d pack=%d image=%d bone=%d rigid=%d",
+             CONVERTER_VERSION, (double)POSITION_THRESHOLD, (double)ROTATION_THRESHOLD,
+             (double)SCALE_THRESHOLD, (double)tolerance.position, (double)tolerance.rotation,
+             (double)tolerance.scale, TRACK_MAX_KEY_SPAN, (double)converterOptions.worldTolerance,
+             TRACK_REFINE_PASSES,
+             STRIP_MIN_SIZE, STRIP_CACHE_SIZE, (int)STRIP_BACKWARD_SEARCH, (int)STRIP_PUSH_CACHE_HITS,
+             (int)converterOptions.stitchStrips, converterOptions.dmsVersion,
+             (int)converterOptions.quantizeAnimations, (double)converterOptions.sampleRate,
+             (int)converterOptions.nativeKeys, (int)converterOptions.packVertices,
+             (int)converterOptions.image, (int)converterOptions.boneSpace, (int)converterOptions.rigidParts);
+
+    std::string key = settings;
+    const std::map<std::string, TrackTolerance>* overrides[] = {
+        &converterOptions.clipTolerances, &converterOptions.boneTolerances
+    };
+    for (int i = 0; i < 2; i++) {
+        for (const auto& entry : *overrides[i]) {
+            snprintf(settings, sizeof(settings), " %s:%s=%a,%a,%a", i == 0 ? "clip" : "bone", entry.first.c_str(),
+                     (double)entry.second.position, (double)entry.second.rotation, (double)entry.second.scale);
+            key += settings;
+        }
+    }
+    return ConversionCache::Hash(key.data(), key.size());
+}
+
+// Converts one glTF/GLB file to a .dms. Each call owns its model and
+// skeleton, so several files can be converted at once on the same pool.
+// With a cache, a hit copies the stored .dms out without parsing the input.
+bool ConvertFile(const char* inputFilename, const char* outputFilename, WorkerPool& pool,
+                 const ConversionCache* cache, ConversionSummary* summary) {
+    uint64_t cacheKey = 0;
+    std::filesystem::path inputDir = std::filesystem::path(inputFilename).parent_path();
+    if (cache) {
+        std::vector<uint8_t> input;
+        if (!ConversionCache::ReadFile(inputFilename, &input)) {
+            LogPrintf("Failed to read file: %s\n", inputFilename);
+            return false;
+        }
+        cacheKey = ConversionCache::Hash(input.data(), input.size(), CacheSettingsHash());
+
+        ConversionCache::Entry entry;
+        if (cache->Lookup(cacheKey, inputDir, &entry)) {
+            LogPrintf("Cache hit: %s\n", inputFilename);
+            summary->triangles = entry.triangles;
+            summary->strips = entry.strips;
+            summary->bytes = (long)entry.dms.size();
+            summary->cached = true;
+            return WriteOutput(outputFilename, entry.dms);
+        }
+    }
+
+    Skeleton skeleton = { 0 };
+    Model model = { 0 };
+    Model tristrippedModel = { 0 }; // Second model for tristripped version
+    std::vector<std::string> bufferUris;
+
     // Load the GLTF/GLB file
-    if (!LoadGLTF(inputFilename)) {
-        printf("Failed to load file: %s\n", inputFilename);
-        return 1;
+    if (!LoadGLTF(inputFilename, &model, &skeleton, &bufferUris)) {
+        LogPrintf("Failed to load file: %s\n", inputFilename);
+        Cleanup(&skeleton, &model, &tristrippedModel);
+        return false;
     }
     
+    if (converterOptions.rigidParts && skeleton.boneCount > 0) {
+        SplitRigidParts(&model);
+    }
+
     // Create the tristripped model
-    CreateTristrippedModel(&model, &tristrippedModel);
+    CreateTristrippedModel(&model, &tristrippedModel, pool, summary);
     
     //   conversion stats
-    printf("Original model: %d meshes\n", model.meshCount);
+    LogPrintf("Original model: %d meshes\n", model.meshCount);
     if (model.meshCount > 0) {
-        printf("First mesh: %d verts, %d indices\n", 
+        LogPrintf("First mesh: %d verts, %d indices\n", 
                model.meshes[0].vertexCount, model.meshes[0].indexCount);
     }
     
-    printf("Tristripped model: %d meshes\n", tristrippedModel.meshCount);
+    LogPrintf("Tristripped model: %d meshes\n", tristrippedModel.meshCount);
     if (tristrippedModel.meshCount > 0) {
-        printf("First mesh: %d verts, %d indices\n",
+        LogPrintf("First mesh: %d verts, %d indices\n",
                tristrippedModel.meshes[0].vertexCount, 
                tristrippedModel.meshes[0].indexCount);
     }
     
-    // Generate output filename (same name but with .dms extension)
-    char outputFilename[256] = {0};
-    const char* extension = strrchr(inputFilename, '.');
-    if (extension) {
-        // Copy everything before the extension
-        size_t baseNameLength = extension - inputFilename;
-        strncpy(outputFilename, inputFilename, baseNameLength);
-        // Add new extension
-        strcat(outputFilename, ".dms");
-    } else {
-        // No extension in input, just append .dms
-        strcpy(outputFilename, inputFilename);
-        strcat(outputFilename, ".dms");
-    }
-    
     // Export the file
+    bool ok = true;
+    std::vector<uint8_t> fileBytes;
     if (tristrippedModel.meshCount > 0) {
-        printf("Exporting to: %s\n", outputFilename);
-        ExportTristrippedModel(&tristrippedModel, outputFilename);
+        LogPrintf("Exporting to: %s\n", outputFilename);
+        summary->bytes = ExportTristrippedModel(&tristrippedModel, outputFilename, fileBytes);
+        ok = summary->bytes >= 0;
      } else {
-        printf("No meshes to export\n");
+        LogPrintf("No meshes to export\n");
     }
     
     // Clean up resources
-    if (model.meshes) {
-        for (int i = 0; i < model.meshCount; i++) {
-            if (model.meshes[i].vertices) free(model.meshes[i].vertices);
-            if (model.meshes[i].originalVertices) free(model.meshes[i].originalVertices);
-            if (model.meshes[i].animatedVertices) free(model.meshes[i].animatedVertices);
-            if (model.meshes[i].indices) free(model.meshes[i].indices);
+    Cleanup(&skeleton, &model, &tristrippedModel);
+
+    // Only complete exports are cached; a failed store just means a miss next time
+    if (cache && ok && summary->bytes > 0) {
+        ConversionCache::Entry entry;
+        entry.triangles = summary->triangles;
+        entry.strips = summary->strips;
+        entry.dms.swap(fileBytes);
+        bool stored = true;
+        for (const auto& uri : bufferUris) {
+            ConversionCache::Dependency dependency = { uri, 0 };
+            stored = stored && ConversionCache::HashFile(inputDir / uri, &dependency.hash);
+            entry.dependencies.push_back(dependency);
+        }
+        if (!stored || !cache->Store(cacheKey, entry)) {
+            LogPrintf("Warning: could not store %s in the conversion cache\n", inputFilename);
         }
-        free(model.meshes);
     }
-    
-    if (tristrippedModel.meshes) {
-        for (int i = 0; i < tristrippedModel.meshCount; i++) {
-            if (tristrippedModel.meshes[i].vertices) free(tristrippedModel.meshes[i].vertices);
-            if (tristrippedModel.meshes[i].animatedVertices) free(tristrippedModel.meshes[i].animatedVertices);
-            if (tristrippedModel.meshes[i].indices) free(tristrippedModel.meshes[i].indices);
+    return ok;
+}
+
+static bool HasModelExtension(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    for (auto& c : ext) c = (char)tolower((unsigned char)c);
+    return ext == ".glb" || ext == ".gltf";
+}
+
+// Output name: same name with a .dms extension, next to the input or
+// under outputDir keeping the path relative to the scanned directory
+static std::string OutputPathFor(const std::filesystem::path& input, const std::filesystem::path& relative,
+                                 const char* outputDir) {
+    std::filesystem::path output = outputDir ? std::filesystem::path(outputDir) / relative : input;
+    output.replace_extension(".dms");
+    return output.string();
+}
+
+// Parses "[clip:NAME=|bone:NAME=]position,rotation,scale" into the options
+static bool ParseTolerance(const char* spec) {
+    std::map<std::string, TrackTolerance>* overrides = NULL;
+    std::string name;
+    if (strncmp(spec, "clip:", 5) == 0 || strncmp(spec, "bone:", 5) == 0) {
+        const char* equals = strrchr(spec, '=');
+        if (!equals || equals == spec + 5) return false;
+        overrides = spec[0] == 'c' ? &converterOptions.clipTolerances : &converterOptions.boneTolerances;
+        name.assign(spec + 5, equals - (spec + 5));
+        spec = equals + 1;
+    }
+
+    TrackTolerance tolerance;
+    char trailing;
+    if (sscanf(spec, "%f,%f,%f%c", &tolerance.position, &tolerance.rotation, &tolerance.scale, &trailing) != 3) {
+        return false;
+    }
+    if (tolerance.position < 0.0f || tolerance.rotation < 0.0f || tolerance.scale < 0.0f) return false;
+
+    if (overrides) {
+        (*overrides)[name] = tolerance;
+    } else {
+        converterOptions.tolerance = tolerance;
+    }
+    return true;
+}
+
+static void PrintUsage(const char* program) {
+    printf("Usage: %s [-j threads] [--stitch] [--dms-version n] [--quantize] [--tolerance t] [--world-tol d] [--sample-rate hz] [--native-keys] [--pack-vertices] [--bone-space] [--rigid-parts] [--image] [--cache dir] [-v] [-o output_dir] <gltf_file|directory>...\n", program);
+    printf("  -j threads       Worker threads shared by all conversions (default: CPU count)\n");
+    printf("  --stitch         Bridge strips and loose triangles when it saves PVR vertices\n");
+    printf("  --dms-version n  Write .dms version n (default %d; 1 = whole-frame animations, 2 = float tracks,\n", DMS_VERSION);
+    printf("                   3 = float vertices only, 4 = in-band strip flags on 32-bit indices,\n");
+    printf("                   5 = sequential sections without a chunk table)\n");
+    printf("  --quantize       Pack animation keys into 48-bit values (version 3 and later)\n");
+    printf("  --tolerance t    Animation fit tolerance as position,rotation,scale (units, degrees, factor;\n");
+    printf("                   default %g,%g,%g). Prefix clip:NAME= or bone:NAME= to set one clip or bone\n",
+           (double)TRACK_POSITION_TOLERANCE, (double)TRACK_ROTATION_TOLERANCE, (double)TRACK_SCALE_TOLERANCE);
+    printf("  --world-tol d    Refit until every bone stays within d units of its sampled position\n");
+    printf("                   (default %g of the skeleton's size, 0 = off)\n", (double)TRACK_WORLD_TOLERANCE);
+    printf("  --sample-rate hz Animation samples per second (default %g)\n", (double)ANIMATION_SAMPLE_RATE);
+    printf("  --native-keys    Keep authored key times; resample only cubic and step segments\n");
+    printf("                   (version 2 and later)\n");
+    printf("  --pack-vertices  Store 16-byte vertices with 16-bit positions and UVs (version 4 and later)\n");
+    printf("  --bone-space     Store skinned positions in their bone's space, so skinning is one transform\n");
+    printf("                   per vertex (version 6 or --image; draw the model through instances)\n");
+    printf("  --rigid-parts    Split skinned meshes into parts weighted to one bone, which runtimes draw\n");
+    printf("                   through the bone's matrix without skinning (implies --bone-space)\n");
+    printf("  --image          Write an in-place image the runtime loads with one read and one allocation\n");
+    printf("                   (clips are stored as tracks, so version 2 and later)\n");
+    printf("  --cache dir      Reuse .dms files from earlier runs with identical input and settings\n");
+    printf("  -o dir           Write .dms files to dir; directories keep their layout below it\n");
+    printf("  -o -             Write the .dms of a single input to stdout (log goes to stderr)\n");
+    printf("  -v               Print the full conversion log of every file in batch mode\n");
+    printf("A single file without -o is converted next to the input with the full log.\n");
+    printf("Several inputs, a directory or -o switch to batch mode with a summary table.\n");
+}
+
+static void PrintSummaryTable(const std::vector<ConversionSummary>& summaries) {
+    size_t nameWidth = strlen("Asset");
+    for (const auto& summary : summaries) nameWidth = std::max(nameWidth, summary.input.size());
+
+    size_t totalTriangles = 0, totalStrips = 0, failed = 0, cached = 0;
+    long totalBytes = 0;
+    printf("\n%-*s %12s %10s %12s\n", (int)nameWidth, "Asset", "Triangles", "Strips", "Bytes");
+    for (const auto& summary : summaries) {
+        if (!summary.ok) {
+            printf("%-*s %12s %10s %12s\n", (int)nameWidth, summary.input.c_str(), "-", "-", "FAILED");
+            failed++;
+            continue;
         }
-        free(tristrippedModel.meshes);
+        printf("%-*s %12zu %10zu %12ld\n", (int)nameWidth, summary.input.c_str(),
+               summary.triangles, summary.strips, summary.bytes);
+        totalTriangles += summary.triangles;
+        totalStrips += summary.strips;
+        totalBytes += summary.bytes;
+        if (summary.cached) cached++;
     }
-    
-    if (skeleton.bones) {
-        free(skeleton.bones);
+    printf("%-*s %12zu %10zu %12ld\n", (int)nameWidth, "Total", totalTriangles, totalStrips, totalBytes);
+    printf("%zu assets converted (%zu from cache), %zu failed\n", summaries.size() - failed, cached, failed);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<const char*> inputs;
+    const char* outputDir = NULL;
+    const char* cacheDir = NULL;
+    bool verbose = false;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount < 1) threadCount = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-j", 2) == 0) {
+            const char* value = argv[i][2] ? &argv[i][2] : (i + 1 < argc ? argv[++i] : NULL);
+            threadCount = value ? atoi(value) : 0;
+            if (threadCount < 1) {
+                printf("Invalid thread count for -j\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stitch") == 0) {
+            converterOptions.stitchStrips = true;
+        } else if (strcmp(argv[i], "--dms-version") == 0 && i + 1 < argc) {
+            converterOptions.dmsVersion = atoi(argv[++i]);
+            if (converterOptions.dmsVersion < 1 || converterOptions.dmsVersion > DMS_VERSION) {
+                printf("Unsupported .dms version for --dms-version (1-%d)\n", DMS_VERSION);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--quantize") == 0) {
+            converterOptions.quantizeAnimations = true;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            if (!ParseTolerance(argv[++i])) {
+                printf("Invalid --tolerance %s (expected [clip:NAME=|bone:NAME=]position,rotation,scale)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--world-tol") == 0 && i + 1 < argc) {
+            converterOptions.worldTolerance = (float)atof(argv[++i]);
+            if (converterOptions.worldTolerance < 0.0f) {
+                printf("Invalid distance for --world-tol\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc) {
+            converterOptions.sampleRate = (float)atof(argv[++i]);
+            if (!(converterOptions.sampleRate > 0.0f)) {
+                printf("Invalid rate for --sample-rate\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--native-keys") == 0) {
+            converterOptions.nativeKeys = true;
+        } else if (strcmp(argv[i], "--pack-vertices") == 0) {
+            converterOptions.packVertices = true;
+        } else if (strcmp(argv[i], "--bone-space") == 0) {
+            converterOptions.boneSpace = true;
+        } else if (strcmp(argv[i], "--rigid-parts") == 0) {
+            converterOptions.rigidParts = true;
+            converterOptions.boneSpace = true;
+        } else if (strcmp(argv[i], "--image") == 0) {
+            converterOptions.image = true;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (argv[i][0] == '-') {
+            PrintUsage(argv[0]);
+            return 1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
     }
-    
-    if (skeleton.animations) {
-        for (int i = 0; i < skeleton.animCount; i++) {
-            if (skeleton.animations[i].framePoses) {
-                free(skeleton.animations[i].framePoses);
+
+    if (inputs.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (converterOptions.nativeKeys && converterOptions.dmsVersion < 2) {
+        printf("--native-keys needs .dms version 2 or later\n");
+        return 1;
+    }
+    if (converterOptions.packVertices && converterOptions.dmsVersion < 4) {
+        printf("--pack-vertices needs .dms version 4 or later\n");
+        return 1;
+    }
+    if (converterOptions.boneSpace && converterOptions.dmsVersion < 6 && !converterOptions.image) {
+        printf("%s needs .dms version 6 or --image, which carry the bind-pose bounds\n",
+               converterOptions.rigidParts ? "--rigid-parts" : "--bone-space");
+        return 1;
+    }
+    if (converterOptions.image && converterOptions.dmsVersion < 2) {
+        printf("--image needs .dms version 2 or later\n");
+        return 1;
+    }
+    if (converterOptions.quantizeAnimations && converterOptions.dmsVersion < 3) {
+        printf("--quantize needs .dms version 3 or later\n");
+        return 1;
+    }
+
+    converterOptions.threadCount = threadCount;
+    WorkerPool pool(converterOptions.threadCount);
+    ConversionCache cacheStorage(cacheDir ? cacheDir : "");
+    const ConversionCache* cache = cacheDir ? &cacheStorage : NULL;
+
+    // Single file streamed to stdout; the log moves to stderr
+    if (outputDir && strcmp(outputDir, "-") == 0) {
+        if (inputs.size() != 1 || std::filesystem::is_directory(inputs[0])) {
+            fprintf(stderr, "-o - takes exactly one input file\n");
+            return 1;
+        }
+        logStream = stderr;
+        ConversionSummary summary = {};
+        return ConvertFile(inputs[0], "-", pool, cache, &summary) ? 0 : 1;
+    }
+
+    // Single file, original behaviour: full log, .dms written next to the input
+    if (inputs.size() == 1 && !outputDir && !std::filesystem::is_directory(inputs[0])) {
+        ConversionSummary summary = {};
+        std::filesystem::path input(inputs[0]);
+        std::string outputFilename = OutputPathFor(input, input.filename(), NULL);
+        return ConvertFile(inputs[0], outputFilename.c_str(), pool, cache, &summary) ? 0 : 1;
+    }
+
+    // Batch mode: expand directories, then convert everything on the one pool
+    std::vector<ConversionSummary> summaries;
+    for (const char* arg : inputs) {
+        std::filesystem::path root(arg);
+        std::error_code error;
+        if (std::filesystem::is_directory(root, error)) {
+            std::vector<std::filesystem::path> found;
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(root, error)) {
+                if (entry.is_regular_file() && HasModelExtension(entry.path())) found.push_back(entry.path());
+            }
+            std::sort(found.begin(), found.end());
+            for (const auto& path : found) {
+                ConversionSummary summary = {};
+                summary.input = path.string();
+                summary.output = OutputPathFor(path, path.lexically_relative(root), outputDir);
+                summaries.push_back(summary);
             }
+        } else {
+            ConversionSummary summary = {};
+            summary.input = root.string();
+            summary.output = OutputPathFor(root, root.filename(), outputDir);
+            summaries.push_back(summary);
         }
-        free(skeleton.animations);
     }
-    
+
+    std::mutex outputMutex;
+    std::atomic<size_t> completed(0);
+    pool.ParallelFor(summaries.size(), [&](size_t i) {
+        ConversionSummary& summary = summaries[i];
+        std::string log;
+        std::string* previousCapture = SetLogCapture(&log);
+
+        std::error_code error;
+        std::filesystem::path parent = std::filesystem::path(summary.output).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent, error);
+        summary.ok = ConvertFile(summary.input.c_str(), summary.output.c_str(), pool, cache, &summary);
+
+        SetLogCapture(previousCapture);
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (verbose || !summary.ok) fputs(log.c_str(), stdout);
+        printf("[%zu/%zu] %s %s -> %s\n", ++completed, summaries.size(),
+               summary.ok ? (summary.cached ? "Cached" : "Converted") : "FAILED",
+               summary.input.c_str(), summary.output.c_str());
+        fflush(stdout);
+    });
+
+    PrintSummaryTable(summaries);
+
+    for (const auto& summary : summaries) {
+        if (!summary.ok) return 1;
+    }
     return 0;
 }
 
 
+// Unordered vertex pair, used to look strips up by their end edges
+static uint64_t EdgeKey(size_t a, size_t b) {
+    if (a > b) std::swap(a, b);
+    return ((uint64_t)a << 32) | (uint64_t)b;
+}
 
+// Strips sharing one end edge, in strip order. Strips only ever get used up,
+// so the cursor can skip the used ones for good.
+struct EdgeBucket {
+    std::vector<size_t> strips;
+    size_t cursor = 0;
+};
 
-void Cleanup(void) {
-    if (skeleton.bones) {
-        free(skeleton.bones);
+static size_t NextUnusedInBucket(EdgeBucket& bucket, const std::vector<bool>& used) {
+    while (bucket.cursor < bucket.strips.size() && used[bucket.strips[bucket.cursor]]) {
+        bucket.cursor++;
     }
-    
-    if (skeleton.animations) {
-        for (int i = 0; i < skeleton.animCount; i++) {
-            if (skeleton.animations[i].framePoses) {
-                free(skeleton.animations[i].framePoses);
-            }
+    return bucket.cursor < bucket.strips.size() ? bucket.strips[bucket.cursor] : SIZE_MAX;
+}
+
+// Third vertex of a loose triangle if appending it to a strip ending in
+// (p, q) at this parity keeps its winding, SIZE_MAX otherwise
+static size_t LooseTriangleContinuation(const size_t* tri, size_t p, size_t q, bool evenLength) {
+    // Even-length strips emit (p, q, x) next, odd-length ones (q, p, x)
+    size_t from = evenLength ? p : q;
+    size_t to = evenLength ? q : p;
+    for (int k = 0; k < 3; k++) {
+        if (tri[k] == from && tri[(k + 1) % 3] == to) return tri[(k + 2) % 3];
+    }
+    return SIZE_MAX;
+}
+
+// Extend every joined strip with whatever is left that shares its end edge:
+// even-length strips walked backwards (which keeps their winding) and loose
+// triangles. Each bridge saves two vertices over submitting the piece on its
+// own; bridges that would need a swap vertex to fix the winding cost as much
+// as a separate submission and are left alone.
+static void stitch_strips(std::vector<std::vector<size_t>>& strips, std::vector<size_t>& looseIndices) {
+    std::vector<bool> stripUsed(strips.size(), false);
+    std::vector<bool> absorbed(strips.size(), false);
+    std::unordered_map<uint64_t, EdgeBucket> lastEdges;
+    for (size_t i = 0; i < strips.size(); i++) {
+        const auto& strip = strips[i];
+        if (strip.size() >= 4 && (strip.size() & 1) == 0) {
+            lastEdges[EdgeKey(strip[strip.size() - 2], strip[strip.size() - 1])].strips.push_back(i);
         }
-        free(skeleton.animations);
     }
-    
-    if (model.meshes) {
-        for (int i = 0; i < model.meshCount; i++) {
-            if (model.meshes[i].vertices) free(model.meshes[i].vertices);
-            if (model.meshes[i].originalVertices) free(model.meshes[i].originalVertices);
-            if (model.meshes[i].animatedVertices) free(model.meshes[i].animatedVertices);
-            if (model.meshes[i].indices) free(model.meshes[i].indices);
+
+    size_t looseCount = looseIndices.size() / 3;
+    std::vector<bool> looseUsed(looseCount, false);
+    std::unordered_map<uint64_t, std::vector<size_t>> looseEdges;
+    for (size_t t = 0; t < looseCount; t++) {
+        const size_t* tri = &looseIndices[t * 3];
+        for (int k = 0; k < 3; k++) {
+            looseEdges[EdgeKey(tri[k], tri[(k + 1) % 3])].push_back(t);
         }
-        free(model.meshes);
     }
-    
-    if (tristrippedModel.meshes) {
-        for (int i = 0; i < tristrippedModel.meshCount; i++) {
-            if (tristrippedModel.meshes[i].vertices) free(tristrippedModel.meshes[i].vertices);
-            if (tristrippedModel.meshes[i].animatedVertices) free(tristrippedModel.meshes[i].animatedVertices);
-            if (tristrippedModel.meshes[i].indices) free(tristrippedModel.meshes[i].indices);
+
+    for (size_t i = 0; i < strips.size(); i++) {
+        if (stripUsed[i]) continue;
+        stripUsed[i] = true;
+        std::vector<size_t>& current = strips[i];
+
+        for (;;) {
+            size_t p = current[current.size() - 2];
+            size_t q = current[current.size() - 1];
+            bool evenLength = (current.size() & 1) == 0;
+            uint64_t key = EdgeKey(p, q);
+
+            // Another strip whose reversed start continues this one
+            if (evenLength) {
+                auto it = lastEdges.find(key);
+                size_t j = it != lastEdges.end() ? NextUnusedInBucket(it->second, stripUsed) : SIZE_MAX;
+                if (j != SIZE_MAX) {
+                    const auto& other = strips[j];
+                    if (other[other.size() - 1] == p && other[other.size() - 2] == q) {
+                        current.insert(current.end(), other.rbegin() + 2, other.rend());
+                        stripUsed[j] = true;
+                        absorbed[j] = true;
+                        continue;
+                    }
+                }
+            }
+
+            // A loose triangle hanging off the end edge
+            bool extended = false;
+            auto it = looseEdges.find(key);
+            if (it != looseEdges.end()) {
+                for (size_t t : it->second) {
+                    if (looseUsed[t]) continue;
+                    size_t x = LooseTriangleContinuation(&looseIndices[t * 3], p, q, evenLength);
+                    if (x == SIZE_MAX) continue;
+                    current.push_back(x);
+                    looseUsed[t] = true;
+                    extended = true;
+                    break;
+                }
+            }
+            if (!extended) break;
         }
-        free(tristrippedModel.meshes);
     }
-}
 
+    // Drop the strips and loose triangles that were absorbed
+    std::vector<std::vector<size_t>> kept;
+    for (size_t i = 0; i < strips.size(); i++) {
+        if (!absorbed[i]) {
+            kept.push_back(std::move(strips[i]));
+        }
+    }
+    strips.swap(kept);
 
-bool can_join_strips(const std::vector<size_t>& strip1, const std::vector<size_t>& strip2) {
-    if (strip1.empty() || strip2.empty()) return false;
-    return (strip1[strip1.size()-1] == strip2[1] && strip1[strip1.size()-2] == strip2[0]) ||
-           (strip1[strip1.size()-1] == strip2[0] && strip1[strip1.size()-2] == strip2[1]);
+    std::vector<size_t> remaining;
+    for (size_t t = 0; t < looseCount; t++) {
+        if (!looseUsed[t]) remaining.insert(remaining.end(), &looseIndices[t * 3], &looseIndices[t * 3] + 3);
+    }
+    looseIndices.swap(remaining);
 }
 
-std::vector<std::vector<size_t>> join_strips(const triangle_stripper::primitive_vector& originalStrips) {
+// Greedily chains strips whose start edge matches the current strip's end
+// edge, always taking the lowest-numbered candidate. Candidates are found
+// through an index on each strip's first edge instead of rescanning.
+std::vector<std::vector<size_t>> join_strips(const triangle_stripper::primitive_vector& originalStrips,
+                                             bool stitch, std::vector<size_t>& looseIndices) {
     std::vector<std::vector<size_t>> result;
     std::vector<bool> used(originalStrips.size(), false);
     std::vector<std::vector<size_t>> strips;
@@ -1059,95 +2502,112 @@ std::vector<std::vector<size_t>> join_strips(const triangle_stripper::primitive_
         }
     }
 
+    std::unordered_map<uint64_t, EdgeBucket> firstEdges;
+    for (size_t j = 0; j < strips.size(); j++) {
+        if (strips[j].size() >= 2) {
+            firstEdges[EdgeKey(strips[j][0], strips[j][1])].strips.push_back(j);
+        }
+    }
+
     for (size_t i = 0; i < strips.size(); i++) {
         if (used[i]) continue;
 
         std::vector<size_t> current_strip = strips[i];
         used[i] = true;
         
-        bool found_join;
-        do {
-            found_join = false;
-            for (size_t j = 0; j < strips.size(); j++) {
-                if (!used[j] && can_join_strips(current_strip, strips[j])) {
-                    current_strip.insert(current_strip.end(), 
-                                      strips[j].begin() + 2,
-                                      strips[j].end());
-                    used[j] = true;
-                    found_join = true;
-                    break;
-                }
-            }
-        } while (found_join);
+        while (current_strip.size() >= 2) {
+            auto it = firstEdges.find(EdgeKey(current_strip[current_strip.size() - 2],
+                                              current_strip[current_strip.size() - 1]));
+            if (it == firstEdges.end()) break;
+
+            size_t j = NextUnusedInBucket(it->second, used);
+            if (j == SIZE_MAX) break;
+
+            current_strip.insert(current_strip.end(), 
+                              strips[j].begin() + 2,
+                              strips[j].end());
+            used[j] = true;
+        }
 
         result.push_back(current_strip);
     }
+
+    if (stitch) {
+        stitch_strips(result, looseIndices);
+    }
     return result;
 }
 
-void optimize_mesh() {
+void optimize_mesh(std::vector<Triangle>& triangles, StripStats* stats) {
     if (triangles.empty()) {
-        printf("Warning: No triangles to optimize. Optimization did not happen.\n");
+        LogPrintf("Warning: No triangles to optimize. Optimization did not happen.\n");
         return;
     }
 
 
     using namespace triangle_stripper;
     
-    printf("=== Strip Optimization ===\n");
-    printf("Input triangles: %zu\n", triangles.size());
+    stats->input_triangles = triangles.size();
 
-    // Create vertex index mapping
-    std::map<std::string, uint32_t> vertex_map;
+    // Create vertex index mapping (strip connectivity only cares about position and UV)
+    VertexWelder<5> vertex_map(triangles.size() * 3);
     std::vector<Vertex_Tristripped> unique_vertices;
     indices Indices;
+    Indices.reserve(triangles.size() * 3);
     
     for(const auto& tri : triangles) {
         for(int i = 0; i < 3; i++) {
-            char key[256];
             const auto& v = tri.vertices[i];
-            snprintf(key, sizeof(key), "%.6f,%.6f,%.6f|%.6f,%.6f", 
-                    v.position[0], v.position[1], v.position[2],
-                    v.texcoord[0], v.texcoord[1]);
+            VertexWelder<5>::Key key = {
+                VertexWelder<5>::FloatBits(v.position[0]),
+                VertexWelder<5>::FloatBits(v.position[1]),
+                VertexWelder<5>::FloatBits(v.position[2]),
+                VertexWelder<5>::FloatBits(v.texcoord[0]),
+                VertexWelder<5>::FloatBits(v.texcoord[1])
+            };
             
-            auto it = vertex_map.find(key);
-            if(it == vertex_map.end()) {
-                it = vertex_map.insert({key, unique_vertices.size()}).first;
+            bool inserted;
+            uint32_t index = vertex_map.Weld(key, &inserted);
+            if(inserted) {
                 unique_vertices.push_back(v);
             }
-            Indices.push_back(it->second);
+            Indices.push_back(index);
         }
     }
 
     // Generate strips
     primitive_vector primitives;
     tri_stripper stripper(Indices);
-    stripper.SetMinStripSize(0);
-    stripper.SetCacheSize(0);
-    stripper.SetBackwardSearch(true);
-    stripper.SetPushCacheHits(true);
+    stripper.SetMinStripSize(STRIP_MIN_SIZE);
+    stripper.SetCacheSize(STRIP_CACHE_SIZE);
+    stripper.SetBackwardSearch(STRIP_BACKWARD_SEARCH);
+    stripper.SetPushCacheHits(STRIP_PUSH_CACHE_HITS);
     stripper.Strip(&primitives);
 
-    // Join compatible strips
-    auto joined_strips = join_strips(primitives);
+    // Gather the triangles the stripper left as a plain list
+    std::vector<size_t> loose_indices;
+    for(const auto& prim : primitives) {
+        if(prim.Type == TRIANGLES) {
+            loose_indices.insert(loose_indices.end(), prim.Indices.begin(), prim.Indices.end());
+        }
+    }
+
+    // Join compatible strips (stitching may also absorb loose triangles)
+    auto joined_strips = join_strips(primitives, converterOptions.stitchStrips, loose_indices);
     
     // Create optimized triangles
     std::vector<Triangle> optimized_tris;
     size_t strip_triangles = 0, list_triangles = 0;
 
     // Process non-strip triangles
-    for(const auto& prim : primitives) {
-        if(prim.Type == TRIANGLES) {
-            for(size_t i = 0; i < prim.Indices.size(); i += 3) {
-                Triangle tri;
-                tri.materialId = 0;
-                for(int j = 0; j < 3; j++) {
-                    tri.vertices[j] = unique_vertices[prim.Indices[i + j]];
-                }
-                optimized_tris.push_back(tri);
-                list_triangles++;
-            }
+    for(size_t i = 0; i + 2 < loose_indices.size(); i += 3) {
+        Triangle tri;
+        tri.materialId = 0;
+        for(int j = 0; j < 3; j++) {
+            tri.vertices[j] = unique_vertices[loose_indices[i + j]];
         }
+        optimized_tris.push_back(tri);
+        list_triangles++;
     }
 
     // Process strips
@@ -1187,135 +2647,639 @@ void optimize_mesh() {
     float vertex_reuse = joined_strips.size() > 0 ? 
         (float)strip_triangles * 3.0f / (float)total_strip_vertices : 0;
 
-    printf("Optimization complete:\n");
-    printf("- Strips: %zu\n", joined_strips.size());
-    printf("- Strip triangles: %zu\n", strip_triangles);
-    printf("- List triangles: %zu\n", list_triangles);
-    printf("- Total triangles: %zu\n", optimized_tris.size());
-    
-    printf("\nEfficiency Metrics:\n");
-    printf(" - Strip ratio: %.2f%%\n", strip_ratio * 100.0f);
-    printf(" - Average strip length: %.2f vertices\n", avg_strip_length);
-    printf(" - Longest strip: %zu vertices\n", max_strip_length);
-    printf(" - Vertex reuse factor: %.2f\n", vertex_reuse);
-    printf("=== End of Strip Optimization Statistics ===\n");
+    stats->strips = joined_strips.size();
+    stats->strip_triangles = strip_triangles;
+    stats->list_triangles = list_triangles;
+    stats->total_triangles = optimized_tris.size();
+    stats->max_strip_length = max_strip_length;
+    stats->pvr_vertices = total_strip_vertices + list_triangles * 3;
+    stats->strip_ratio = strip_ratio;
+    stats->avg_strip_length = avg_strip_length;
+    stats->vertex_reuse = vertex_reuse;
+
+    triangles.swap(optimized_tris);
+}
 
-    triangles = optimized_tris;
+void PrintStripStats(const StripStats& stats) {
+    LogPrintf("=== Strip Optimization ===\n");
+    LogPrintf("Input triangles: %zu\n", stats.input_triangles);
+    LogPrintf("Optimization complete:\n");
+    LogPrintf("- Strips: %zu\n", stats.strips);
+    LogPrintf("- Strip triangles: %zu\n", stats.strip_triangles);
+    LogPrintf("- List triangles: %zu\n", stats.list_triangles);
+    LogPrintf("- Total triangles: %zu\n", stats.total_triangles);
+    
+    LogPrintf("\nEfficiency Metrics:\n");
+    LogPrintf(" - Strip ratio: %.2f%%\n", stats.strip_ratio * 100.0f);
+    LogPrintf(" - Average strip length: %.2f vertices\n", stats.avg_strip_length);
+    LogPrintf(" - Longest strip: %zu vertices\n", stats.max_strip_length);
+    LogPrintf(" - Vertex reuse factor: %.2f\n", stats.vertex_reuse);
+    LogPrintf(" - PVR vertices submitted: %zu\n", stats.pvr_vertices);
+    LogPrintf("=== End of Strip Optimization Statistics ===\n");
 }
 
-void ExportTristrippedModel(const Model* model, const char* filename) {
-    FILE* file = fopen(filename, "wb");
+// Returns the number of bytes written, or -1 if the file could not be written
+// Writes a finished file in one go; "-" means stdout so the output can be
+// piped straight into the packing step
+bool WriteOutput(const char* filename, const std::vector<uint8_t>& bytes) {
+    bool toStdout = strcmp(filename, "-") == 0;
+    FILE* file = toStdout ? stdout : fopen(filename, "wb");
     if (!file) {
-        printf("Failed to open file for writing: %s\n", filename);
+        LogPrintf("Failed to open file for writing: %s\n", filename);
+        return false;
+    }
+
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = (toStdout ? fflush(file) : fclose(file)) == 0 && ok;
+    if (!ok) LogPrintf("Failed to write %s\n", filename);
+    return ok;
+}
+
+static int16_t packSigned(float value, float offset, float scale) {
+    if (scale <= 0.0f) return 0;
+    float q = roundf((value - offset) / scale);
+    return (int16_t)std::max(-32767.0f, std::min(32767.0f, q));
+}
+
+static uint16_t packUnsigned(float value, float offset, float scale) {
+    if (scale <= 0.0f) return 0;
+    float q = roundf((value - offset) / scale);
+    return (uint16_t)std::max(0.0f, std::min(65535.0f, q));
+}
+
+// Bytes per index in a v5 index section
+static uint32_t meshIndexSize(const Mesh* mesh) {
+    return mesh->vertexCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// Packs a mesh's vertices against its bounds and UV range. Returns the
+// largest position and UV error the packing introduced.
+static void packMeshVertices(const Mesh* mesh, PackedMesh* packed, float* positionError, float* uvError) {
+    Vector3 lo = { FLT_MAX, FLT_MAX, FLT_MAX }, hi = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    float uvLo[2] = { FLT_MAX, FLT_MAX }, uvHi[2] = { -FLT_MAX, -FLT_MAX };
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        const Vertex& v = mesh->vertices[i];
+        lo = Vector3Min(lo, Vector3{ v.x, v.y, v.z });
+        hi = Vector3Max(hi, Vector3{ v.x, v.y, v.z });
+        uvLo[0] = std::min(uvLo[0], v.u); uvHi[0] = std::max(uvHi[0], v.u);
+        uvLo[1] = std::min(uvLo[1], v.v); uvHi[1] = std::max(uvHi[1], v.v);
+    }
+    if (mesh->vertexCount == 0) {
+        lo = hi = Vector3Zero();
+        uvLo[0] = uvLo[1] = uvHi[0] = uvHi[1] = 0.0f;
+    }
+
+    packed->positionOffset = Vector3Scale(Vector3Add(lo, hi), 0.5f);
+    packed->positionScale = Vector3Scale(Vector3Subtract(hi, lo), 0.5f / 32767.0f);
+    for (int c = 0; c < 2; c++) {
+        packed->uvOffset[c] = uvLo[c];
+        packed->uvScale[c] = (uvHi[c] - uvLo[c]) / 65535.0f;
+    }
+
+    *positionError = *uvError = 0.0f;
+    packed->vertices.resize(mesh->vertexCount);
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        const Vertex& v = mesh->vertices[i];
+        PackedVertex& p = packed->vertices[i];
+        const Vector3& offset = packed->positionOffset;
+        const Vector3& scale = packed->positionScale;
+        p.x = packSigned(v.x, offset.x, scale.x);
+        p.y = packSigned(v.y, offset.y, scale.y);
+        p.z = packSigned(v.z, offset.z, scale.z);
+        p.nx = v.nx;
+        p.ny = v.ny;
+        p.nz = v.nz;
+        p.boneId = v.boneId;
+        p.u = packUnsigned(v.u, packed->uvOffset[0], packed->uvScale[0]);
+        p.v = packUnsigned(v.v, packed->uvOffset[1], packed->uvScale[1]);
+        // Any influence stays nonzero: the runtimes skip weight-0 vertices
+        p.boneWeight = v.boneWeight > 0.0f ? (uint16_t)std::max(1.0f, std::min(65535.0f, roundf(v.boneWeight * 65535.0f))) : 0;
+
+        Vector3 unpacked = { offset.x + p.x * scale.x, offset.y + p.y * scale.y, offset.z + p.z * scale.z };
+        *positionError = std::max(*positionError, Vector3Distance(unpacked, Vector3{ v.x, v.y, v.z }));
+        *uvError = std::max(*uvError, fabsf(packed->uvOffset[0] + p.u * packed->uvScale[0] - v.u));
+        *uvError = std::max(*uvError, fabsf(packed->uvOffset[1] + p.v * packed->uvScale[1] - v.v));
+    }
+}
+
+// Output buffer for the .dms file. Reserved up front so serializing is
+// plain memcpy work with no reallocation.
+struct DmsBuffer {
+    std::vector<uint8_t>& bytes;
+
+    void Write(const void* data, size_t size) {
+        const uint8_t* raw = (const uint8_t*)data;
+        bytes.insert(bytes.end(), raw, raw + size);
+    }
+    template <typename T>
+    void Put(const T& value) { Write(&value, sizeof(T)); }
+    template <typename T>
+    void PutAt(long offset, const T& value) { memcpy(bytes.data() + offset, &value, sizeof(T)); }
+    void Align(size_t alignment) { bytes.resize((bytes.size() + alignment - 1) / alignment * alignment, 0); }
+    long Tell() const { return (long)bytes.size(); }
+};
+
+static size_t TristrippedModelFileSize(const Model* model) {
+    uint32_t boneCount = model->skeleton ? model->skeleton->boneCount : 0;
+    size_t size = 4 * sizeof(uint32_t) + sizeof(uint32_t);
+    if (converterOptions.dmsVersion >= 6) {
+        // Chunk table, the material and bounds chunks, and up to a chunk's
+        // alignment of padding per chunk (a bound; it only sizes the buffer)
+        int animCount = boneCount > 0 ? model->skeleton->animCount : 0;
+        size_t chunkCount = 3 + animCount + model->meshCount;
+        size += chunkCount * (sizeof(ChunkEntry) + DMS_MESH_ALIGNMENT);
+        size += (size_t)model->textureCount * 64 + (size_t)model->meshCount * sizeof(MeshBounds);
+    }
+    if (boneCount > 0) {
+        size += boneCount * (64 + sizeof(int) + sizeof(Transform) + sizeof(Matrix));
+        for (int i = 0; i < model->skeleton->animCount; i++) {
+            const Animation* anim = &model->skeleton->animations[i];
+            size += 32 + 2 * sizeof(int) + sizeof(float);
+            if (!anim->tracks) {
+                size += (size_t)anim->frameCount * anim->boneCount * sizeof(Transform);
+                continue;
+            }
+            if (converterOptions.dmsVersion >= 3) size += sizeof(uint32_t);
+            size += anim->quantized ? quantizedBytes(anim->quantized) : trackBytes(anim->tracks, anim->boneCount);
+        }
+    }
+    for (int m = 0; m < model->meshCount; m++) {
+        const Mesh* mesh = &model->meshes[m];
+        size += 2 * sizeof(uint32_t) + sizeof(int);
+        if (converterOptions.dmsVersion >= 4) size += sizeof(uint32_t);
+        if (converterOptions.packVertices) {
+            size += 2 * sizeof(Vector3) + 4 * sizeof(float) + (size_t)mesh->vertexCount * sizeof(PackedVertex);
+        } else {
+            size += (size_t)mesh->vertexCount * (boneCount > 0 ? sizeof(Vertex) : sizeof(StaticVertex));
+        }
+        if (converterOptions.dmsVersion >= 5) {
+            size += 2 * sizeof(uint32_t) + (size_t)mesh->stripCount * sizeof(uint32_t);
+            size += ((size_t)mesh->indexCount * meshIndexSize(mesh) + 3) & ~(size_t)3;
+        } else {
+            size += (size_t)mesh->indexCount * sizeof(uint32_t);
+        }
+    }
+    return size;
+}
+
+static void WriteBones(DmsBuffer& out, const Skeleton* skeleton) {
+    for (int i = 0; i < skeleton->boneCount; i++) {
+        const Bone& bone = skeleton->bones[i];
+        out.Write(bone.name, 64);
+        out.Put(bone.parent);
+        out.Put(bone.bindPose);
+        out.Put(bone.inverseBindMatrix);
+    }
+}
+
+static void WriteAnimation(DmsBuffer& out, const Animation* anim, int i, uint32_t version) {
+    // Write animation header
+    out.Write(anim->name, 32);
+    out.Put(anim->boneCount);
+    out.Put(anim->frameCount);
+    out.Put(anim->duration);
+
+    LogPrintf("Writing animation %d: %s (%d frames) at %ld\n", 
+           i, anim->name, anim->frameCount, out.Tell());
+
+    if (version >= 3) {
+        // v3: encoding of the clip's tracks
+        uint32_t encoding = anim->quantized ? ANIM_ENCODING_QUANTIZED : ANIM_ENCODING_FLOAT;
+        out.Put(encoding);
+    }
+
+    if (anim->quantized) {
+        // Quantized: time step, translation and scale ranges, then the
+        // words of all tracks (see QuantizedClip)
+        const QuantizedClip* clip = anim->quantized;
+        uint32_t wordCount = (uint32_t)clip->words.size();
+        out.Put(clip->timeStep);
+        out.Put(clip->translationMin);
+        out.Put(clip->translationStep);
+        out.Put(clip->scaleMin);
+        out.Put(clip->scaleStep);
+        out.Put(wordCount);
+        out.Write(clip->words.data(), wordCount * sizeof(uint16_t));
         return;
     }
 
-    //   header
-    uint32_t magic = 0x54534D44;  // "DMST" in hex
-    uint32_t version = 1;
+    if (anim->tracks) {
+        // v2: total floats of all tracks (so loaders allocate once),
+        // then per bone translation/rotation/scale tracks as
+        // keyCount, times[keyCount], values[keyCount * 3 or 4]
+        uint32_t keyFloatCount = 0;
+        for (int t = 0; t < anim->boneCount * TRACKS_PER_BONE; t++) {
+            keyFloatCount += anim->tracks[t].keyCount * (1 + trackComponents(t % TRACKS_PER_BONE));
+        }
+        out.Put(keyFloatCount);
+        for (int t = 0; t < anim->boneCount * TRACKS_PER_BONE; t++) {
+            const Track* track = &anim->tracks[t];
+            uint32_t keyCount = track->keyCount;
+            out.Put(keyCount);
+            out.Write(track->times, keyCount * sizeof(float));
+            out.Write(track->values, keyCount * trackComponents(t % TRACKS_PER_BONE) * sizeof(float));
+        }
+        return;
+    }
+
+    // Write frame poses
+    size_t totalPoses = anim->frameCount * anim->boneCount;
+    out.Write(anim->framePoses, totalPoses * sizeof(Transform));
+}
+
+// Layout of a written mesh, flagged when skinned positions are in bone space
+// and when the mesh is a rigid part
+static uint32_t meshVertexFormat(const Mesh* mesh, bool isAnimated) {
+    uint32_t vertexFormat = converterOptions.packVertices ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_FLOAT;
+    if (isAnimated && converterOptions.boneSpace) vertexFormat |= VERTEX_BONE_SPACE;
+    if (isAnimated && mesh->rigid) vertexFormat |= VERTEX_RIGID;
+    return vertexFormat;
+}
+
+// Copy of a mesh for --bone-space: every vertex the runtimes skin (weighted,
+// with a valid bone) is moved into its bone's space through the inverse bind
+// matrix, so skinning is a single transform by the bone's world pose. The
+// copy's vertices live in `storage`; the rest is shared with `mesh`.
+static Mesh BoneSpaceMesh(const Mesh* mesh, const Skeleton* skeleton, int m, std::vector<Vertex>& storage) {
+    storage.assign(mesh->vertices, mesh->vertices + mesh->vertexCount);
+    int moved = 0;
+    for (Vertex& v : storage) {
+        if (v.boneWeight <= 0.0f || v.boneId >= skeleton->boneCount) continue;
+        Vector3 p = Vector3Transform(Vector3{ v.x, v.y, v.z }, skeleton->bones[v.boneId].inverseBindMatrix);
+        v.x = p.x;
+        v.y = p.y;
+        v.z = p.z;
+        moved++;
+    }
+    LogPrintf("  Bone-space mesh %d: %d of %d vertices\n", m, moved, mesh->vertexCount);
+
+    Mesh copy = *mesh;
+    copy.vertices = storage.data();
+    return copy;
+}
+
+static void WriteMesh(DmsBuffer& out, const Mesh* mesh, int m, bool isAnimated, uint32_t version) {
+    // Write mesh header
+    uint32_t vertCount = mesh->vertexCount;
+    uint32_t idxCount = mesh->indexCount;
+    int textureId = mesh->textureId;  //  Get texture ID
+
+    out.Put(vertCount);
+    out.Put(idxCount);
+    out.Put(textureId);  //  Write texture ID
+
+    if (version >= 4) {
+        // v4: vertex layout of the mesh
+        uint32_t vertexFormat = meshVertexFormat(mesh, isAnimated);
+        out.Put(vertexFormat);
+    }
+
+    if (converterOptions.packVertices) {
+        // Packed: position and UV ranges, then 16-byte vertices
+        PackedMesh packed;
+        float positionError, uvError;
+        packMeshVertices(mesh, &packed, &positionError, &uvError);
+        out.Put(packed.positionOffset);
+        out.Put(packed.positionScale);
+        out.Write(packed.uvOffset, sizeof(packed.uvOffset));
+        out.Write(packed.uvScale, sizeof(packed.uvScale));
+        out.Write(packed.vertices.data(), packed.vertices.size() * sizeof(PackedVertex));
+
+        size_t before = (size_t)mesh->vertexCount * (isAnimated ? sizeof(Vertex) : sizeof(StaticVertex));
+        LogPrintf("  Packed mesh %d: %zu -> %zu vertex bytes, max error %.5f units, %.6f uv\n",
+                  m, before, packed.vertices.size() * sizeof(PackedVertex), positionError, uvError);
+    } else if (!isAnimated) {
+        // Static mesh - write simplified vertex data
+        for (int i = 0; i < mesh->vertexCount; i++) {
+            StaticVertex sv;
+            sv.x = mesh->vertices[i].x;
+            sv.y = mesh->vertices[i].y;
+            sv.z = mesh->vertices[i].z;
+            sv.nx = mesh->vertices[i].nx;
+            sv.ny = mesh->vertices[i].ny;
+            sv.nz = mesh->vertices[i].nz;
+            sv.u = mesh->vertices[i].u;
+            sv.v = mesh->vertices[i].v;
+            out.Put(sv);
+        }
+    } else {
+        // Animated mesh - write full vertex data
+        out.Write(mesh->vertices, sizeof(Vertex) * mesh->vertexCount);
+    }
+    
+    // Write index data
+    if (version >= 5) {
+        // v5: strip table, then the indices at 16 bits whenever they fit
+        uint32_t stripCount = mesh->stripCount;
+        uint32_t indexSize = meshIndexSize(mesh);
+        out.Put(stripCount);
+        out.Put(indexSize);
+        out.Write(mesh->stripLengths, sizeof(uint32_t) * stripCount);
+        if (indexSize == sizeof(uint16_t)) {
+            for (int i = 0; i < mesh->indexCount; i++) out.Put((uint16_t)mesh->indices[i]);
+            if (mesh->indexCount & 1) out.Put((uint16_t)0);  // Keep the next mesh 4-byte aligned
+        } else {
+            out.Write(mesh->indices, sizeof(uint32_t) * mesh->indexCount);
+        }
+    } else {
+        // Earlier versions flag strip indices in-band with the high bit and
+        // a 7-bit strip ID; the triangle list follows unflagged
+        int i = 0;
+        for (int s = 0; s < mesh->stripCount; s++) {
+            uint32_t flag = 0x80000000 | ((uint32_t)(s + 1) << 24);
+            for (unsigned int j = 0; j < mesh->stripLengths[s]; j++, i++) {
+                out.Put((uint32_t)(flag | mesh->indices[i]));
+            }
+        }
+        out.Write(mesh->indices + i, sizeof(uint32_t) * (mesh->indexCount - i));
+    }
+}
+
+static MeshBounds ComputeMeshBounds(const Mesh* mesh) {
+    MeshBounds bounds = {};
+    if (mesh->vertexCount == 0) return bounds;
+
+    Vector3 sum = { 0.0f, 0.0f, 0.0f };
+    bounds.min = bounds.max = Vector3{ mesh->vertices[0].x, mesh->vertices[0].y, mesh->vertices[0].z };
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        Vector3 p = { mesh->vertices[i].x, mesh->vertices[i].y, mesh->vertices[i].z };
+        bounds.min = Vector3Min(bounds.min, p);
+        bounds.max = Vector3Max(bounds.max, p);
+        sum = Vector3Add(sum, p);
+    }
+    bounds.center = Vector3Scale(sum, 1.0f / mesh->vertexCount);
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        Vector3 p = { mesh->vertices[i].x, mesh->vertices[i].y, mesh->vertices[i].z };
+        bounds.radius = std::max(bounds.radius, Vector3Distance(p, bounds.center));
+    }
+    return bounds;
+}
+
+// Writes the v6 container: header, chunk table, then the chunks. Offsets are
+// patched into the table once each chunk is laid out.
+static void WriteChunkedModel(DmsBuffer& out, const Model* model, uint32_t version) {
+    uint32_t meshCount = model->meshCount;
+    uint32_t boneCount = model->skeleton ? model->skeleton->boneCount : 0;
+    bool isAnimated = (boneCount > 0);
+    uint32_t animCount = isAnimated ? model->skeleton->animCount : 0;
+    uint32_t chunkCount = (isAnimated ? 1 : 0) + animCount + 2 + meshCount;
+
+    out.Put((uint32_t)DMS_MAGIC);
+    out.Put(version);
+    out.Put(meshCount);
+    out.Put(boneCount);
+    out.Put(chunkCount);
+
+    long table = out.Tell();
+    std::vector<ChunkEntry> chunks;
+    out.Write(std::vector<ChunkEntry>(chunkCount).data(), chunkCount * sizeof(ChunkEntry));
+
+    auto beginChunk = [&](uint32_t type, uint32_t alignment) {
+        out.Align(alignment);
+        chunks.push_back(ChunkEntry{ type, (uint32_t)out.Tell(), 0, alignment });
+    };
+    auto endChunk = [&]() {
+        chunks.back().size = (uint32_t)out.Tell() - chunks.back().offset;
+    };
+
+    if (isAnimated) {
+        LogPrintf("Writing %d bones at %ld\n", boneCount, out.Tell());
+        beginChunk(CHUNK_SKELETON, DMS_CHUNK_ALIGNMENT);
+        WriteBones(out, model->skeleton);
+        endChunk();
+
+        for (uint32_t i = 0; i < animCount; i++) {
+            beginChunk(CHUNK_ANIMATION, DMS_CHUNK_ALIGNMENT);
+            WriteAnimation(out, &model->skeleton->animations[i], i, version);
+            endChunk();
+        }
+    }
+
+    beginChunk(CHUNK_MATERIALS, DMS_CHUNK_ALIGNMENT);
+    out.Put((uint32_t)model->textureCount);
+    out.Write(model->textureNames, (size_t)model->textureCount * 64);
+    endChunk();
+
+    beginChunk(CHUNK_BOUNDS, DMS_CHUNK_ALIGNMENT);
+    for (uint32_t m = 0; m < meshCount; m++) out.Put(ComputeMeshBounds(&model->meshes[m]));
+    endChunk();
+
+    // Bounds above stay in bind pose; only the written vertices move
+    LogPrintf("Writing %d meshes at %ld\n", meshCount, out.Tell());
+    for (uint32_t m = 0; m < meshCount; m++) {
+        const Mesh* mesh = &model->meshes[m];
+        LogPrintf("  Writing mesh %d: %d vertices, %d indices\n", m, mesh->vertexCount, mesh->indexCount);
+        std::vector<Vertex> boneSpaceVertices;
+        Mesh boneSpaceMesh;
+        if (isAnimated && converterOptions.boneSpace) {
+            boneSpaceMesh = BoneSpaceMesh(mesh, model->skeleton, m, boneSpaceVertices);
+            mesh = &boneSpaceMesh;
+        }
+        beginChunk(CHUNK_MESH, DMS_MESH_ALIGNMENT);
+        WriteMesh(out, mesh, m, isAnimated, version);
+        endChunk();
+    }
+
+    for (uint32_t c = 0; c < chunkCount; c++) out.PutAt(table + c * sizeof(ChunkEntry), chunks[c]);
+}
+
+// Writes an in-place image (--image): header, the mesh, bone and clip tables,
+// then vertices, strip tables, indices and clip data. Offsets are patched
+// into the tables once the data is laid out.
+static void WriteImageModel(DmsBuffer& out, const Model* model) {
+    const Skeleton* skeleton = model->skeleton;
+    bool isAnimated = skeleton && skeleton->boneCount > 0;
+
+    ImageHeader header = {};
+    header.magic = DMS_IMAGE_MAGIC;
+    header.version = DMS_IMAGE_VERSION;
+    header.meshCount = model->meshCount;
+    header.boneCount = isAnimated ? skeleton->boneCount : 0;
+    header.animCount = isAnimated ? skeleton->animCount : 0;
+    header.textureCount = model->textureCount;
+
+    std::vector<ImageMesh> meshes(header.meshCount);
+    std::vector<ImageClip> clips(header.animCount);
+    long meshTable = out.Tell() + (long)sizeof(ImageHeader);
+    long clipTable = meshTable + (long)(meshes.size() * sizeof(ImageMesh)) + (long)(header.boneCount * sizeof(ImageBone));
+
+    out.Put(header);
+    out.Write(meshes.data(), meshes.size() * sizeof(ImageMesh));
+    for (uint32_t i = 0; i < header.boneCount; i++) {
+        const Bone& bone = skeleton->bones[i];
+        ImageBone record = {};
+        memcpy(record.name, bone.name, sizeof(record.name));
+        record.parent = bone.parent;
+        record.bindPose = bone.bindPose;
+        record.inverseBindMatrix = bone.inverseBindMatrix;
+        out.Put(record);
+    }
+    out.Write(clips.data(), clips.size() * sizeof(ImageClip));
+
+    for (uint32_t m = 0; m < header.meshCount; m++) {
+        const Mesh* mesh = &model->meshes[m];
+        ImageMesh& record = meshes[m];
+        MeshBounds bounds = ComputeMeshBounds(mesh);
+        std::vector<Vertex> boneSpaceVertices;
+        Mesh boneSpaceMesh;
+        if (isAnimated && converterOptions.boneSpace) {
+            boneSpaceMesh = BoneSpaceMesh(mesh, skeleton, m, boneSpaceVertices);
+            mesh = &boneSpaceMesh;
+        }
+        record.vertexCount = mesh->vertexCount;
+        record.indexCount = mesh->indexCount;
+        record.textureId = mesh->textureId;
+        record.vertexFormat = meshVertexFormat(mesh, isAnimated);
+        record.stripCount = mesh->stripCount;
+        record.indexSize = meshIndexSize(mesh);
+        record.center = bounds.center;
+        record.radius = bounds.radius;
+        for (int s = 0; s < mesh->stripCount; s++) {
+            record.stripIndexCount += mesh->stripLengths[s];
+            if (mesh->stripLengths[s] >= 3) record.triangleCount += mesh->stripLengths[s] - 2;
+        }
+        record.triangleCount += (mesh->indexCount - record.stripIndexCount) / 3;
+        if (isAnimated && !mesh->rigid) header.skinnedVertexCount += mesh->vertexCount;
+
+        // Vertices in the runtime layout, so nothing is converted at load
+        out.Align(DMS_IMAGE_ALIGNMENT);
+        record.vertices = (uint32_t)out.Tell();
+        if (converterOptions.packVertices) {
+            PackedMesh packed;
+            float positionError, uvError;
+            packMeshVertices(mesh, &packed, &positionError, &uvError);
+            record.positionOffset = packed.positionOffset;
+            record.positionScale = packed.positionScale;
+            memcpy(record.uvOffset, packed.uvOffset, sizeof(record.uvOffset));
+            memcpy(record.uvScale, packed.uvScale, sizeof(record.uvScale));
+            out.Write(packed.vertices.data(), packed.vertices.size() * sizeof(PackedVertex));
+            header.packedVertexCount += mesh->vertexCount;
+        } else {
+            out.Write(mesh->vertices, sizeof(Vertex) * mesh->vertexCount);
+        }
+
+        record.stripLengths = (uint32_t)out.Tell();
+        out.Write(mesh->stripLengths, sizeof(uint32_t) * mesh->stripCount);
+        record.indices = (uint32_t)out.Tell();
+        if (record.indexSize == sizeof(uint16_t)) {
+            for (int i = 0; i < mesh->indexCount; i++) out.Put((uint16_t)mesh->indices[i]);
+        } else {
+            out.Write(mesh->indices, sizeof(uint32_t) * mesh->indexCount);
+        }
+        out.Align(sizeof(uint32_t));
+    }
+
+    for (uint32_t i = 0; i < header.animCount; i++) {
+        const Animation* anim = &skeleton->animations[i];
+        ImageClip& record = clips[i];
+        memcpy(record.name, anim->name, sizeof(record.name));
+        record.boneCount = anim->boneCount;
+        record.frameCount = anim->frameCount;
+        record.duration = anim->duration;
+        record.data = (uint32_t)out.Tell();
+        header.trackCount += anim->boneCount * TRACKS_PER_BONE;
+
+        if (anim->quantized) {
+            const QuantizedClip* clip = anim->quantized;
+            record.encoding = ANIM_ENCODING_QUANTIZED;
+            record.timeStep = clip->timeStep;
+            record.translationMin = clip->translationMin;
+            record.translationStep = clip->translationStep;
+            record.scaleMin = clip->scaleMin;
+            record.scaleStep = clip->scaleStep;
+            record.dataCount = (uint32_t)clip->words.size();
+            out.Write(clip->words.data(), clip->words.size() * sizeof(uint16_t));
+            out.Align(sizeof(uint32_t));
+            continue;
+        }
+
+        record.encoding = ANIM_ENCODING_FLOAT;
+        for (int t = 0; t < anim->boneCount * TRACKS_PER_BONE; t++) {
+            const Track* track = &anim->tracks[t];
+            uint32_t keyCount = track->keyCount;
+            uint32_t values = keyCount * trackComponents(t % TRACKS_PER_BONE);
+            out.Put(keyCount);
+            out.Write(track->times, keyCount * sizeof(float));
+            out.Write(track->values, values * sizeof(float));
+            record.dataCount += 1 + keyCount + values;
+        }
+    }
+
+    out.Align(DMS_IMAGE_ALIGNMENT);
+    header.size = (uint32_t)out.Tell();
+    out.PutAt(meshTable - (long)sizeof(ImageHeader), header);
+    for (uint32_t m = 0; m < header.meshCount; m++) out.PutAt(meshTable + m * sizeof(ImageMesh), meshes[m]);
+    for (uint32_t i = 0; i < header.animCount; i++) out.PutAt(clipTable + i * sizeof(ImageClip), clips[i]);
+    LogPrintf("Wrote a %u byte in-place image (%u meshes, %u bones, %u clips)\n",
+              header.size, header.meshCount, header.boneCount, header.animCount);
+}
+
+// Lays the whole file out in `bytes`, then writes it with a single call.
+// Returns the file size, or -1 if it could not be written.
+long ExportTristrippedModel(const Model* model, const char* filename, std::vector<uint8_t>& bytes) {
+    bytes.clear();
+    bytes.reserve(TristrippedModelFileSize(model));
+    DmsBuffer out = { bytes };
+
+    uint32_t version = converterOptions.dmsVersion;
+    if (converterOptions.image) {
+        WriteImageModel(out, model);
+        if (!WriteOutput(filename, bytes)) return -1;
+        return out.Tell();
+    }
+    if (version >= 6) {
+        WriteChunkedModel(out, model, version);
+        if (!WriteOutput(filename, bytes)) return -1;
+        LogPrintf("File writing complete at %ld bytes\n", out.Tell());
+        return out.Tell();
+    }
+
+    // Versions 1-5: header, bones, animations and meshes in sequence
+    uint32_t magic = DMS_MAGIC;
     uint32_t meshCount = model->meshCount;
     uint32_t boneCount = model->skeleton ? model->skeleton->boneCount : 0;
     bool isAnimated = (boneCount > 0);
     
-    fwrite(&magic, sizeof(uint32_t), 1, file);
-    fwrite(&version, sizeof(uint32_t), 1, file);
-    fwrite(&meshCount, sizeof(uint32_t), 1, file);
-    fwrite(&boneCount, sizeof(uint32_t), 1, file);
+    out.Put(magic);
+    out.Put(version);
+    out.Put(meshCount);
+    out.Put(boneCount);
 
-    printf("Writing file header at %ld\n", ftell(file));
+    LogPrintf("Writing file header at %ld\n", out.Tell());
 
     // Write skeleton data if it exists
     if (isAnimated && model->skeleton) {
-        printf("Writing %d bones at %ld\n", boneCount, ftell(file));
-        
-        for (uint32_t i = 0; i < boneCount; i++) {
-            const Bone& bone = model->skeleton->bones[i];
-            fwrite(bone.name, sizeof(char), 64, file);
-            fwrite(&bone.parent, sizeof(int), 1, file);
-            fwrite(&bone.bindPose, sizeof(Transform), 1, file);
-            fwrite(&bone.inverseBindMatrix, sizeof(Matrix), 1, file);
-        }
+        LogPrintf("Writing %d bones at %ld\n", boneCount, out.Tell());
+        WriteBones(out, model->skeleton);
 
         // Write animation data
         uint32_t animCount = model->skeleton->animCount;
-        fwrite(&animCount, sizeof(uint32_t), 1, file);
+        out.Put(animCount);
         
-        printf("Writing %d animations at %ld\n", animCount, ftell(file));
+        LogPrintf("Writing %d animations at %ld\n", animCount, out.Tell());
 
         for (uint32_t i = 0; i < animCount; i++) {
-            const Animation* anim = &model->skeleton->animations[i];
-            
-            // Write animation header
-            fwrite(anim->name, sizeof(char), 32, file);
-            fwrite(&anim->boneCount, sizeof(int), 1, file);
-            fwrite(&anim->frameCount, sizeof(int), 1, file);
-            fwrite(&anim->duration, sizeof(float), 1, file);
-
-            printf("Writing animation %d: %s (%d frames) at %ld\n", 
-                   i, anim->name, anim->frameCount, ftell(file));
-
-            // Write frame poses
-            size_t totalPoses = anim->frameCount * anim->boneCount;
-            for (size_t j = 0; j < totalPoses; j++) {
-                Transform* pose = &((Transform*)anim->framePoses)[j];
-                fwrite(pose, sizeof(Transform), 1, file);
-            }
+            WriteAnimation(out, &model->skeleton->animations[i], i, version);
         }
     } else {
         // Write zero animations if no skeleton
         uint32_t animCount = 0;
-        fwrite(&animCount, sizeof(uint32_t), 1, file);
+        out.Put(animCount);
     }
 
     // Write mesh data
-    printf("Writing %d meshes at %ld\n", meshCount, ftell(file));
+    LogPrintf("Writing %d meshes at %ld\n", meshCount, out.Tell());
     
     for (uint32_t m = 0; m < meshCount; m++) {
         const Mesh* mesh = &model->meshes[m];
         
         // Debug print
-        printf("  Writing mesh %d: %d vertices, %d indices\n", 
+        LogPrintf("  Writing mesh %d: %d vertices, %d indices\n", 
                m, mesh->vertexCount, mesh->indexCount);
-        
-        // Write mesh header
-        uint32_t vertCount = mesh->vertexCount;
-        uint32_t idxCount = mesh->indexCount;
-        int textureId = mesh->textureId;  //  Get texture ID
-
-        fwrite(&vertCount, sizeof(uint32_t), 1, file);
-        fwrite(&idxCount, sizeof(uint32_t), 1, file);
-        fwrite(&textureId, sizeof(int), 1, file);  //  Write texture ID
-
-        // Write vertex data based on whether it's animated or static
-        if (!isAnimated) {
-            // Static mesh - write simplified vertex data
-            for (uint32_t i = 0; i < mesh->vertexCount; i++) {
-                StaticVertex sv;
-                sv.x = mesh->vertices[i].x;
-                sv.y = mesh->vertices[i].y;
-                sv.z = mesh->vertices[i].z;
-                sv.nx = mesh->vertices[i].nx;
-                sv.ny = mesh->vertices[i].ny;
-                sv.nz = mesh->vertices[i].nz;
-                sv.u = mesh->vertices[i].u;
-                sv.v = mesh->vertices[i].v;
-                fwrite(&sv, sizeof(StaticVertex), 1, file);
-            }
-        } else {
-            // Animated mesh - write full vertex data
-            fwrite(mesh->vertices, sizeof(Vertex), mesh->vertexCount, file);
-        }
-        
-        // Write index data
-        if (mesh->indexCount > 0) {
-            fwrite(mesh->indices, sizeof(uint32_t), mesh->indexCount, file);
-        }
+        WriteMesh(out, mesh, m, isAnimated, version);
     }
 
-    long pos = ftell(file);
-    fclose(file);
-    printf("File writing complete at %ld bytes\n", pos);
+    if (!WriteOutput(filename, bytes)) return -1;
+    LogPrintf("File writing complete at %ld bytes\n", out.Tell());
+    return out.Tell();
 }
-
- 
- 
\ No newline at end of file
@@ -1,14 +1,23 @@
 #include "include/public_types.h"
 #include "include/tri_stripper.h"
+#include "vertex_welder.h"
+#include "worker_pool.h"
+#include "conversion_cache.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <float.h>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <filesystem>
 
 
 #define RAYMATH_IMPLEMENTATION
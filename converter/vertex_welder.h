@@ -0,0 +1,84 @@
+#ifndef VERTEX_WELDER_H
+#define VERTEX_WELDER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <array>
+#include <vector>
+
+// Open-addressing hash table that welds vertices by the raw bits of their
+// attributes. Keys are N 32-bit words (float bits, packed bytes, ...), so two
+// vertices only weld when every attribute is bitwise identical.
+template <size_t N>
+class VertexWelder {
+public:
+    typedef std::array<uint32_t, N> Key;
+
+    explicit VertexWelder(size_t expectedKeys = 0) {
+        size_t capacity = 16;
+        while (capacity < expectedKeys * 2) capacity <<= 1;
+        slots.assign(capacity, 0);
+        keys.reserve(expectedKeys);
+    }
+
+    // Returns the index of the key, adding it if it was not seen before.
+    // `inserted` tells the caller whether a new vertex has to be emitted.
+    uint32_t Weld(const Key& key, bool* inserted) {
+        if ((keys.size() + 1) * 2 > slots.size()) Grow();
+
+        size_t mask = slots.size() - 1;
+        size_t slot = Hash(key) & mask;
+        while (slots[slot] != 0) {
+            uint32_t index = slots[slot] - 1;
+            if (memcmp(keys[index].data(), key.data(), sizeof(Key)) == 0) {
+                *inserted = false;
+                return index;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        uint32_t index = (uint32_t)keys.size();
+        keys.push_back(key);
+        slots[slot] = index + 1;
+        *inserted = true;
+        return index;
+    }
+
+    size_t Size() const { return keys.size(); }
+
+    static uint32_t FloatBits(float f) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+
+private:
+    static size_t Hash(const Key& key) {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for (size_t i = 0; i < N; i++) {
+            h ^= key[i];
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 32;
+        }
+        return (size_t)h;
+    }
+
+    void Grow() {
+        std::vector<uint32_t> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, 0);
+
+        size_t mask = slots.size() - 1;
+        for (uint32_t entry : old) {
+            if (entry == 0) continue;
+            size_t slot = Hash(keys[entry - 1]) & mask;
+            while (slots[slot] != 0) slot = (slot + 1) & mask;
+            slots[slot] = entry;
+        }
+    }
+
+    std::vector<uint32_t> slots;  // 0 = empty, otherwise key index + 1
+    std::vector<Key> keys;
+};
+
+#endif // VERTEX_WELDER_H
@@ -0,0 +1,114 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool. ParallelFor() queues one batch of indexed jobs and
+// the calling thread helps run queued jobs until its own batch is done, so a
+// job may itself call ParallelFor() without starving the pool.
+class WorkerPool {
+public:
+    // threadCount counts the calling thread; 1 runs everything inline
+    explicit WorkerPool(int threadCount) : stopping(false) {
+        for (int i = 1; i < threadCount; i++) {
+            threads.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+    int ThreadCount() const { return (int)threads.size() + 1; }
+
+    void ParallelFor(size_t count, const std::function<void(size_t)>& job) {
+        if (count == 0) return;
+        if (threads.empty() || count == 1) {
+            for (size_t i = 0; i < count; i++) job(i);
+            return;
+        }
+
+        Batch batch;
+        batch.job = &job;
+        batch.count = count;
+        batch.next = 0;
+        batch.done = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(&batch);
+        }
+        wake.notify_all();
+
+        while (batch.done.load() < count) {
+            if (RunOne()) continue;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&]() {
+                return batch.done.load() == count || !batches.empty();
+            });
+        }
+    }
+
+private:
+    struct Batch {
+        const std::function<void(size_t)>* job;
+        size_t count;
+        size_t next;                 // guarded by mutex
+        std::atomic<size_t> done;
+    };
+
+    // Claims and runs one queued job; returns false if the queue was empty
+    bool RunOne() {
+        Batch* batch;
+        size_t index, count;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (batches.empty()) return false;
+            batch = batches.front();
+            count = batch->count;
+            index = batch->next++;
+            if (batch->next == count) batches.pop_front();
+        }
+
+        (*batch->job)(index);
+
+        // The batch lives on its caller's stack: don't touch it after the
+        // last job has been counted
+        if (batch->done.fetch_add(1) + 1 == count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+        return true;
+    }
+
+    void WorkerLoop() {
+        for (;;) {
+            if (RunOne()) continue;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !batches.empty(); });
+            if (stopping && batches.empty()) return;
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;      // workers: new batch queued or stopping
+    std::condition_variable finished;  // callers: a batch completed
+    std::deque<Batch*> batches;
+    std::vector<std::thread> threads;
+    bool stopping;
+};
+
+#endif // WORKER_POOL_H
@@ -45,9 +45,9 @@ int main(int argc, char **argv) {
     // Load textures
     LoadDMSTextures(model, "/rd", "/rd/texture0.tex");
     
-    // Initialize animation if available
+    // The instance holds the pose; the model stays shared
+    DMSInstance* dragon = CreateDMSInstance(model);
     if (GetDMSModelAnimationCount(model) > 0) {
-        SetDMSModelAnimation(model, currentAnim);
         printf("Model has %d animations\n", GetDMSModelAnimationCount(model));
     }
     
@@ -104,7 +104,7 @@ int main(int argc, char **argv) {
                     int animCount = GetDMSModelAnimationCount(model);
                     if(animCount > 0) {
                         currentAnim = (currentAnim + 1) % animCount;
-                        SetDMSModelAnimation(model, currentAnim);
+                        SetDMSInstanceAnimation(dragon, currentAnim);
                         printf("Changed to animation: %s\n", 
                                GetDMSModelAnimationName(model, currentAnim));
                         
@@ -119,12 +119,10 @@ int main(int argc, char **argv) {
         rotation += dr;
         
         if (model->skeleton && model->skeleton->animCount > 0) {
-            UpdateDMSModelAnimation(model, deltaTime);
+            UpdateDMSInstanceAnimation(dragon, deltaTime);
             
             // Update all meshes with the new animation state
-            for (int i = 0; i < model->meshCount; i++) {
-                UpdateDMSMeshAnimation(&model->meshes[i], model->skeleton);
-            }
+            UpdateDMSInstanceSkinning(dragon);
         }
         
         // Draw the model
@@ -136,7 +134,7 @@ int main(int argc, char **argv) {
         glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
         
         // Render model
-        RenderDMSModel(model, (Vector3){0.0f, 0.0f, 0.0f}, 1.0f, WHITE);
+        RenderDMSInstance(dragon, (Vector3){0.0f, 0.0f, 0.0f}, 1.0f, WHITE);
 
         // Finish the frame
         glKosSwapBuffers();
@@ -145,6 +143,7 @@ int main(int argc, char **argv) {
     // Final FPS report
     printf("Final stats - Average FPS: %.2f\n", fps);
     
+    DestroyDMSInstance(dragon);
     UnloadDMSModel(model);
     
     return 0;
@@ -73,41 +73,7 @@ int main(int argc, char **argv) {
     // Count actual triangles in the model
     for (int m = 0; m < model->meshCount; m++) {
         DMSMesh* mesh = &model->meshes[m];
-        int i = 0;
-        
-        // Count triangles in strips
-        while (i < mesh->indexCount) {
-            uint32_t rawIndex = mesh->indices[i];
-            
-            if ((rawIndex & 0x80000000) != 0) {
-                // Triangle strip
-                uint32_t stripId = (rawIndex >> 24) & 0x7F;
-                int stripLength = 0;
-                
-                while (i < mesh->indexCount) {
-                    rawIndex = mesh->indices[i];
-                    if (!(rawIndex & 0x80000000) || ((rawIndex >> 24) & 0x7F) != stripId)
-                        break;
-                    stripLength++;
-                    i++;
-                }
-                
-                if (stripLength >= 3) {
-                    // A strip of length N has N-2 triangles
-                    mesh->triangleCount += stripLength - 2;
-                }
-            } else {
-                // Individual triangle
-                if (i + 2 < mesh->indexCount) {
-                    mesh->triangleCount++;
-                    i += 3;
-                } else {
-                    i++;
-                }
-            }
-        }
-        
-        // Add to total
+        // Add to total, as counted by the loader from the strip table
         total_polys += mesh->triangleCount;
     }
     
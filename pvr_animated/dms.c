@@ -1,4 +1,5 @@
 #include "dms.h"
+#include <malloc.h>
 
 
 void mat_mult(const Matrix* matrix1, const Matrix* matrix2, Matrix* dst) {
@@ -7,7 +8,739 @@ void mat_mult(const Matrix* matrix1, const Matrix* matrix2, Matrix* dst) {
     mat_store((matrix_t*)dst);
 }
 
+// Reads the v2 per-bone tracks of an animation into a single allocation
+static void ReadTracks(Animation* anim, FILE* file) {
+    uint32_t keyFloatCount = 0;
+    fread(&keyFloatCount, sizeof(uint32_t), 1, file);
+
+    anim->tracks = (Track*)calloc(anim->boneCount * TRACKS_PER_BONE, sizeof(Track));
+    anim->keyData = (float*)malloc(keyFloatCount * sizeof(float));
+
+    uint32_t used = 0;
+    for (int t = 0; t < anim->boneCount * TRACKS_PER_BONE; t++) {
+        Track* track = &anim->tracks[t];
+        uint32_t keyCount = 0;
+        fread(&keyCount, sizeof(uint32_t), 1, file);
+
+        int components = (t % TRACKS_PER_BONE == TRACK_ROTATION) ? 4 : 3;
+        uint32_t floats = keyCount * (1 + components);
+        if (used + floats > keyFloatCount) {
+            // Damaged file: skip the track and fall back to the bind pose
+            fseek(file, floats * sizeof(float), SEEK_CUR);
+            continue;
+        }
+
+        track->keyCount = keyCount;
+        track->times = anim->keyData + used;
+        track->values = track->times + keyCount;
+        fread(track->times, sizeof(float), floats, file);
+        used += floats;
+    }
+}
+
+// Reads a quantized clip. Its words stay packed and are decoded while sampling.
+static void ReadQuantizedTracks(Animation* anim, FILE* file) {
+    uint32_t wordCount = 0;
+    fread(&anim->timeStep, sizeof(float), 1, file);
+    fread(&anim->translationMin, sizeof(Vector3), 1, file);
+    fread(&anim->translationStep, sizeof(Vector3), 1, file);
+    fread(&anim->scaleMin, sizeof(Vector3), 1, file);
+    fread(&anim->scaleStep, sizeof(Vector3), 1, file);
+    fread(&wordCount, sizeof(uint32_t), 1, file);
+
+    anim->keyWords = (uint16_t*)malloc(wordCount * sizeof(uint16_t));
+    fread(anim->keyWords, sizeof(uint16_t), wordCount, file);
+    anim->tracks = (Track*)calloc(anim->boneCount * TRACKS_PER_BONE, sizeof(Track));
+
+    // Per track: keyCount, ticks[keyCount], 3 words per key
+    uint32_t used = 0;
+    for (int t = 0; t < anim->boneCount * TRACKS_PER_BONE && used < wordCount; t++) {
+        Track* track = &anim->tracks[t];
+        uint32_t keyCount = anim->keyWords[used++];
+        if (used + keyCount * 4 > wordCount) break;   // Damaged file
+
+        track->keyCount = keyCount;
+        track->ticks = anim->keyWords + used;
+        used += keyCount * 4;
+    }
+}
+
+// Converts v1 whole-frame poses into tracks. Every track gets a closing key at
+// `duration` holding frame 0, which keeps the old last-to-first frame blend.
+static void BuildTracksFromFrames(Animation* anim, FILE* file) {
+    int frameCount = anim->frameCount;
+    int boneCount = anim->boneCount;
+    size_t totalPoses = frameCount * boneCount;
+    Transform* poses = (Transform*)calloc(totalPoses, sizeof(Transform));
+    fread(poses, sizeof(Transform), totalPoses, file);
+
+    anim->tracks = (Track*)calloc(boneCount * TRACKS_PER_BONE, sizeof(Track));
+    if (frameCount < 1) {
+        free(poses);
+        return;
+    }
+
+    // Key times are shared by all tracks; values follow per bone
+    int keyCount = frameCount + 1;
+    anim->keyData = (float*)malloc((keyCount + (size_t)boneCount * keyCount * 10) * sizeof(float));
+    float* times = anim->keyData;
+    for (int k = 0; k < keyCount; k++) {
+        times[k] = anim->duration * (float)k / (float)frameCount;
+    }
+
+    float* values = times + keyCount;
+    for (int t = 0; t < boneCount * TRACKS_PER_BONE; t++) {
+        Track* track = &anim->tracks[t];
+        int bone = t / TRACKS_PER_BONE;
+        int channel = t % TRACKS_PER_BONE;
+        int components = (channel == TRACK_ROTATION) ? 4 : 3;
+
+        track->keyCount = keyCount;
+        track->times = times;
+        track->values = values;
+        for (int k = 0; k < keyCount; k++) {
+            const Transform* pose = &poses[(k % frameCount) * boneCount + bone];
+            const float* source = (channel == TRACK_TRANSLATION) ? &pose->translation.x :
+                                  (channel == TRACK_ROTATION) ? &pose->rotation.x : &pose->scale.x;
+            memcpy(values + k * components, source, components * sizeof(float));
+        }
+        values += keyCount * components;
+    }
+
+    free(poses);
+}
+
+static void StoreIndex(DMSMesh* mesh, int i, uint32_t index) {
+    if (mesh->indexSize == sizeof(uint16_t)) {
+        ((uint16_t*)mesh->indices)[i] = (uint16_t)index;
+    } else {
+        ((uint32_t*)mesh->indices)[i] = index;
+    }
+}
+
+// Reads a mesh's index section into its strip table and 16- or 32-bit
+// indices. Before v5 strips were flagged in-band on 32-bit indices (high
+// bit plus a 7-bit strip ID), so older files are split into a table here.
+static void ReadIndices(DMSMesh* mesh, uint32_t version, FILE* file) {
+    if (mesh->indexCount < 0) {
+        printf("Invalid index count: %d\n", mesh->indexCount);
+        mesh->indexCount = 0;
+    }
+
+    if (version >= 5) {
+        uint32_t stripCount = 0, indexSize = 0;
+        fread(&stripCount, sizeof(uint32_t), 1, file);
+        fread(&indexSize, sizeof(uint32_t), 1, file);
+        mesh->stripCount = stripCount;
+        mesh->indexSize = indexSize;
+        mesh->stripLengths = (uint32_t*)malloc(stripCount * sizeof(uint32_t));
+        fread(mesh->stripLengths, sizeof(uint32_t), stripCount, file);
+        mesh->indices = malloc((size_t)mesh->indexCount * indexSize);
+        fread(mesh->indices, indexSize, mesh->indexCount, file);
+        if ((mesh->indexCount * indexSize) & 3) fseek(file, 2, SEEK_CUR);  // Alignment padding
+    } else {
+        uint32_t* raw = (uint32_t*)malloc((size_t)mesh->indexCount * sizeof(uint32_t));
+        fread(raw, sizeof(uint32_t), mesh->indexCount, file);
+
+        // A strip is a run of flagged indices sharing one strip ID
+        mesh->stripCount = 0;
+        for (int i = 0; i < mesh->indexCount; i++) {
+            if ((raw[i] & 0x80000000) && (i == 0 || ((raw[i - 1] ^ raw[i]) & 0xFF000000))) mesh->stripCount++;
+        }
+        mesh->stripLengths = (uint32_t*)calloc(mesh->stripCount, sizeof(uint32_t));
+        mesh->indexSize = (mesh->vertexCount <= 65536) ? sizeof(uint16_t) : sizeof(uint32_t);
+        mesh->indices = malloc((size_t)mesh->indexCount * mesh->indexSize);
+
+        // Strip indices first, then the unflagged triangle list
+        int strip = -1, count = 0;
+        for (int i = 0; i < mesh->indexCount; i++) {
+            if (!(raw[i] & 0x80000000)) continue;
+            if (i == 0 || ((raw[i - 1] ^ raw[i]) & 0xFF000000)) strip++;
+            mesh->stripLengths[strip]++;
+            StoreIndex(mesh, count++, raw[i] & 0x00FFFFFF);
+        }
+        for (int i = 0; i < mesh->indexCount; i++) {
+            if (!(raw[i] & 0x80000000)) StoreIndex(mesh, count++, raw[i]);
+        }
+        free(raw);
+    }
+
+    mesh->stripIndexCount = 0;
+    mesh->triangleCount = 0;
+    for (int s = 0; s < mesh->stripCount; s++) {
+        mesh->stripIndexCount += mesh->stripLengths[s];
+        if (mesh->stripLengths[s] >= 3) mesh->triangleCount += mesh->stripLengths[s] - 2;
+    }
+    if (mesh->stripIndexCount > mesh->indexCount) {
+        printf("Invalid strip table: %d strip indices, %d indices\n", mesh->stripIndexCount, mesh->indexCount);
+        mesh->stripCount = 0;
+        mesh->stripIndexCount = 0;
+        mesh->triangleCount = 0;
+    }
+    mesh->triangleCount += (mesh->indexCount - mesh->stripIndexCount) / 3;
+}
+
+// Reads the v4 quantization ranges and packed vertices of a mesh
+static void ReadPackedVertices(DMSMesh* mesh, FILE* file) {
+    fread(&mesh->positionOffset, sizeof(Vector3), 1, file);
+    fread(&mesh->positionScale, sizeof(Vector3), 1, file);
+    fread(mesh->uvOffset, sizeof(float), 2, file);
+    fread(mesh->uvScale, sizeof(float), 2, file);
+
+    mesh->packedVertices = (DMSPackedVertex*)malloc(mesh->vertexCount * sizeof(DMSPackedVertex));
+    fread(mesh->packedVertices, sizeof(DMSPackedVertex), mesh->vertexCount, file);
+}
+
+static void UnpackVertices(const DMSMesh* mesh, DMSVertex* out) {
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        const DMSPackedVertex* p = &mesh->packedVertices[i];
+        Vector3 position = DMSMeshPosition(mesh, i);
+        out[i].x = position.x;
+        out[i].y = position.y;
+        out[i].z = position.z;
+        out[i].nx = p->nx;
+        out[i].ny = p->ny;
+        out[i].nz = p->nz;
+        out[i].u = mesh->uvOffset[0] + p->u * mesh->uvScale[0];
+        out[i].v = mesh->uvOffset[1] + p->v * mesh->uvScale[1];
+        out[i].boneId = p->boneId;
+        out[i].boneWeight = p->boneWeight * (1.0f / 65535.0f);
+    }
+}
+
+void UnpackDMSMesh(DMSMesh* mesh) {
+    if (!mesh || mesh->vertices) return;
+
+    mesh->vertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
+    UnpackVertices(mesh, mesh->vertices);
+    free(mesh->packedVertices);
+    mesh->packedVertices = NULL;
+}
+
+// Reads one clip: the v1-v5 animation record, which v6 ANIM chunks hold as is
+static void ReadAnimation(Animation* A, uint32_t version, FILE* file) {
+    fread(A->name, sizeof(char), 32, file);
+    fread(&A->boneCount, sizeof(int), 1, file);
+    fread(&A->frameCount, sizeof(int), 1, file);
+    fread(&A->duration, sizeof(float), 1, file);
+
+    uint32_t encoding = ANIM_ENCODING_FLOAT;
+    if (version >= 3) fread(&encoding, sizeof(uint32_t), 1, file);
+
+    if (encoding == ANIM_ENCODING_QUANTIZED) {
+        ReadQuantizedTracks(A, file);
+    } else if (version >= 2) {
+        ReadTracks(A, file);
+    } else {
+        BuildTracksFromFrames(A, file);
+    }
+}
+
+static void ReadBones(Skeleton* skeleton, FILE* file) {
+    for (int i = 0; i < skeleton->boneCount; i++) {
+        Bone* b = &skeleton->bones[i];
+        fread(b->name, sizeof(char), 64, file);
+        fread(&b->parent, sizeof(int), 1, file);
+        fread(&b->bindPose, sizeof(Transform), 1, file);
+        fread(&b->inverseBindMatrix, sizeof(Matrix), 1, file);
+    }
+}
+
+// Reads one mesh record: counts, texture ID, vertices and index section.
+// Skinned float meshes get animatedVertices only with `skinning`; packed
+// ones always do.
+static void ReadMesh(DMSMesh* mesh, int animated, int skinning, uint32_t version, FILE* file) {
+    fread(&mesh->vertexCount, sizeof(uint32_t), 1, file);
+    fread(&mesh->indexCount, sizeof(uint32_t), 1, file);
+    fread(&mesh->textureId, sizeof(int), 1, file);  // Read texture ID
+
+    uint32_t vertexFormat = VERTEX_FORMAT_FLOAT;
+    if (version >= 4) fread(&vertexFormat, sizeof(uint32_t), 1, file);
+    mesh->boneSpace = (vertexFormat & VERTEX_BONE_SPACE) != 0;
+    int rigid = (vertexFormat & VERTEX_RIGID) != 0;
+    vertexFormat &= ~(VERTEX_BONE_SPACE | VERTEX_RIGID);
+    mesh->rigidBone = -1;
+
+    if (vertexFormat == VERTEX_FORMAT_PACKED) {
+        // Packed meshes are drawn straight from packedVertices, with the
+        // dequantization folded into the transform. Skinning still writes
+        // float results, seeded with the bind pose once here.
+        ReadPackedVertices(mesh, file);
+        if (rigid && mesh->vertexCount > 0) {
+            mesh->rigidBone = mesh->packedVertices[0].boneId;
+        } else if (animated) {
+            mesh->animatedVertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
+            UnpackVertices(mesh, mesh->animatedVertices);
+        }
+    } else if (rigid || (animated && !skinning)) {
+        // Rigid meshes are drawn from the bind pose through their bone, and
+        // so are skinned ones without skinning results, through the palette
+        mesh->vertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
+        fread(mesh->vertices, sizeof(DMSVertex), mesh->vertexCount, file);
+        if (rigid && mesh->vertexCount > 0) mesh->rigidBone = mesh->vertices[0].boneId;
+    } else if (animated) {
+        // For animated models,  allocate animated vertices buffer
+        mesh->vertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
+        mesh->animatedVertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
+        
+        // Read full Vertex1 data for animated models
+        fread(mesh->vertices, sizeof(DMSVertex), mesh->vertexCount, file);
+        
+        // Initialize animated vertices with bind pose
+        for (int i = 0; i < mesh->vertexCount; i++) {
+            mesh->animatedVertices[i] = mesh->vertices[i];
+        }
+    } else {
+        mesh->vertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
+
+        // For static models, read simplified StaticVertex data and convert
+        typedef struct {
+            float x, y, z;        // Position
+            float nx, ny, nz;     // Normal
+            float u, v;           // Texture coordinates
+        } StaticVertex;
+
+        StaticVertex* tempVerts = (StaticVertex*)malloc(mesh->vertexCount * sizeof(StaticVertex));
+        fread(tempVerts, sizeof(StaticVertex), mesh->vertexCount, file);
+        
+        // Convert to Vertex1 format (with default bone data)
+        for (int i = 0; i < mesh->vertexCount; i++) {
+            mesh->vertices[i].x = tempVerts[i].x;
+            mesh->vertices[i].y = tempVerts[i].y;
+            mesh->vertices[i].z = tempVerts[i].z;
+            mesh->vertices[i].nx = tempVerts[i].nx;
+            mesh->vertices[i].ny = tempVerts[i].ny;
+            mesh->vertices[i].nz = tempVerts[i].nz;
+            mesh->vertices[i].u = tempVerts[i].u;
+            mesh->vertices[i].v = tempVerts[i].v;
+            mesh->vertices[i].boneId = 0;
+            mesh->vertices[i].boneWeight = 0.0f;
+        }
+        
+        free(tempVerts);
+        mesh->animatedVertices = NULL; // Static models don't need this
+    }
+
+    // Read the strip table and indices
+    ReadIndices(mesh, version, file);
+}
+
+// Inverse of an affine matrix: inverted 3x3 part, translation brought back
+// through it
+static void InvertAffine(const Matrix* m, Matrix* out) {
+    float c00 = m->m5 * m->m10 - m->m9 * m->m6;
+    float c01 = m->m8 * m->m6 - m->m4 * m->m10;
+    float c02 = m->m4 * m->m9 - m->m8 * m->m5;
+    float c10 = m->m9 * m->m2 - m->m1 * m->m10;
+    float c11 = m->m0 * m->m10 - m->m8 * m->m2;
+    float c12 = m->m8 * m->m1 - m->m0 * m->m9;
+    float c20 = m->m1 * m->m6 - m->m5 * m->m2;
+    float c21 = m->m4 * m->m2 - m->m0 * m->m6;
+    float c22 = m->m0 * m->m5 - m->m4 * m->m1;
+    float det = m->m0 * c00 + m->m4 * c10 + m->m8 * c20;
+    float invDet = (det != 0.0f) ? 1.0f / det : 0.0f;
+
+    out->m0 = c00 * invDet; out->m4 = c01 * invDet; out->m8 = c02 * invDet;
+    out->m1 = c10 * invDet; out->m5 = c11 * invDet; out->m9 = c12 * invDet;
+    out->m2 = c20 * invDet; out->m6 = c21 * invDet; out->m10 = c22 * invDet;
+    out->m12 = -(out->m0 * m->m12 + out->m4 * m->m13 + out->m8 * m->m14);
+    out->m13 = -(out->m1 * m->m12 + out->m5 * m->m13 + out->m9 * m->m14);
+    out->m14 = -(out->m2 * m->m12 + out->m6 * m->m13 + out->m10 * m->m14);
+    out->m3 = 0.0f;
+    out->m7 = 0.0f;
+    out->m11 = 0.0f;
+    out->m15 = 1.0f;
+}
+
+// Bones start in the pose the mesh was bound in, the inverted inverse bind
+// matrices, which rigid meshes are drawn through until the first animation
+// update. Bone-space meshes start their animatedVertices from it, like
+// model-space meshes.
+static void SetBindWorldPoses(DMSModel* model) {
+    Skeleton* skeleton = model->skeleton;
+    for (int b = 0; b < skeleton->boneCount; b++) {
+        InvertAffine(&skeleton->bones[b].inverseBindMatrix, &skeleton->bones[b].worldPose);
+    }
+
+    for (int m = 0; m < model->meshCount; m++) {
+        DMSMesh* mesh = &model->meshes[m];
+        if (!mesh->boneSpace || !mesh->animatedVertices) continue;
+
+        for (int i = 0; i < mesh->vertexCount; i++) {
+            DMSVertex* v = &mesh->animatedVertices[i];
+            if (v->boneWeight <= 0.0f || v->boneId >= skeleton->boneCount) continue;
+
+            Vector3 position = Vector3Transform(DMSMeshPosition(mesh, i), skeleton->bones[v->boneId].worldPose);
+            v->x = position.x;
+            v->y = position.y;
+            v->z = position.z;
+        }
+    }
+}
+
+// v1-v5 files: bones, every clip and every mesh in sequence
+static void ReadSections(DMSModel* model, uint32_t version, uint32_t sections, FILE* file) {
+    if (model->skeleton) {
+        ReadBones(model->skeleton, file);
+    }
+
+    uint32_t animCount = 0;
+    fread(&animCount, sizeof(uint32_t), 1, file);
+    if (model->skeleton && animCount > 0) {
+        model->skeleton->animCount = animCount;
+        model->skeleton->animations = (Animation*)calloc(animCount, sizeof(Animation));
+        for (uint32_t i = 0; i < animCount; i++) {
+            ReadAnimation(&model->skeleton->animations[i], version, file);
+        }
+    }
+
+    for (int m = 0; m < model->meshCount; m++) {
+        ReadMesh(&model->meshes[m], model->skeleton != NULL, (sections & DMS_LOAD_SKINNING) != 0, version, file);
+    }
+}
+
+// v6 files: seeks to each chunk in `sections` through the chunk table and
+// skips the rest, including chunk types this loader does not know. Meshes of
+// a skinned file keep their skinned layout even when the skeleton is left out.
+static void ReadChunks(DMSModel* model, uint32_t version, uint32_t boneCount, uint32_t sections, FILE* file) {
+    uint32_t chunkCount = 0;
+    fread(&chunkCount, sizeof(uint32_t), 1, file);
+    DMSChunk* chunks = (DMSChunk*)malloc(chunkCount * sizeof(DMSChunk));
+    fread(chunks, sizeof(DMSChunk), chunkCount, file);
+
+    int animCount = 0;
+    for (uint32_t c = 0; c < chunkCount; c++) {
+        if (chunks[c].type == DMS_CHUNK_ANIMATION) animCount++;
+    }
+    if (model->skeleton && (sections & DMS_LOAD_ANIMATIONS) && animCount > 0) {
+        model->skeleton->animCount = animCount;
+        model->skeleton->animations = (Animation*)calloc(animCount, sizeof(Animation));
+    }
+
+    int anim = 0, mesh = 0;
+    for (uint32_t c = 0; c < chunkCount; c++) {
+        const DMSChunk* chunk = &chunks[c];
+        switch (chunk->type) {
+        case DMS_CHUNK_SKELETON:
+            if (!model->skeleton) break;
+            fseek(file, chunk->offset, SEEK_SET);
+            ReadBones(model->skeleton, file);
+            break;
+        case DMS_CHUNK_ANIMATION:
+            if (!model->skeleton || !model->skeleton->animations) break;
+            fseek(file, chunk->offset, SEEK_SET);
+            ReadAnimation(&model->skeleton->animations[anim++], version, file);
+            break;
+        case DMS_CHUNK_MATERIALS:
+            fseek(file, chunk->offset, SEEK_SET);
+            fread(&model->textureCount, sizeof(uint32_t), 1, file);
+            break;
+        case DMS_CHUNK_MESH:
+            if (mesh >= model->meshCount) break;
+            fseek(file, chunk->offset, SEEK_SET);
+            ReadMesh(&model->meshes[mesh++], boneCount > 0, (sections & DMS_LOAD_SKINNING) != 0, version, file);
+            break;
+        default:
+            break;
+        }
+    }
+    free(chunks);
+}
+
+// Bump allocation within an image model's block. Every array starts on a
+// 32-byte boundary; with a base of 0 it only measures.
+static void* TakeImageSpace(uintptr_t* cursor, size_t size) {
+    uintptr_t p = (*cursor + 31) & ~(uintptr_t)31;
+    *cursor = p + size;
+    return (void*)p;
+}
+
+// Runtime structs of an image model, carved from one block
+typedef struct {
+    DMSModel* model;
+    DMSMesh* meshes;
+    Skeleton* skeleton;
+    Bone* bones;
+    Animation* animations;
+    Track* tracks;
+    DMSVertex* vertices;    // Skinning results
+    matrix_t* palette;
+} ImageParts;
+
+static size_t LayoutImageModel(const DMSImageHeader* header, uintptr_t base, ImageParts* parts) {
+    uintptr_t cursor = base;
+    parts->model = (DMSModel*)TakeImageSpace(&cursor, sizeof(DMSModel));
+    parts->meshes = (DMSMesh*)TakeImageSpace(&cursor, header->meshCount * sizeof(DMSMesh));
+    parts->skeleton = (Skeleton*)TakeImageSpace(&cursor, sizeof(Skeleton));
+    parts->bones = (Bone*)TakeImageSpace(&cursor, header->boneCount * sizeof(Bone));
+    parts->animations = (Animation*)TakeImageSpace(&cursor, header->animCount * sizeof(Animation));
+    parts->tracks = (Track*)TakeImageSpace(&cursor, header->trackCount * sizeof(Track));
+    parts->vertices = (DMSVertex*)TakeImageSpace(&cursor, header->skinnedVertexCount * sizeof(DMSVertex));
+    parts->palette = (matrix_t*)TakeImageSpace(&cursor, (header->boneCount + 1) * sizeof(matrix_t));
+    return ((cursor + 31) & ~(uintptr_t)31) - base;
+}
+
+// Points the clip's tracks into its data in the image
+static void LinkImageTracks(Animation* anim, const DMSImageClip* clip, const uint8_t* image) {
+    uint32_t used = 0;
+    if (clip->encoding == ANIM_ENCODING_QUANTIZED) {
+        uint16_t* words = (uint16_t*)(image + clip->data);
+        anim->keyWords = words;     // Marks the clip quantized; never freed
+        for (int t = 0; t < anim->boneCount * TRACKS_PER_BONE && used < clip->dataCount; t++) {
+            uint32_t keyCount = words[used++];
+            if (keyCount > (clip->dataCount - used) / 4) break;   // Damaged image
+            anim->tracks[t].keyCount = keyCount;
+            anim->tracks[t].ticks = words + used;
+            used += keyCount * 4;
+        }
+        return;
+    }
+
+    uint32_t* words = (uint32_t*)(image + clip->data);
+    for (int t = 0; t < anim->boneCount * TRACKS_PER_BONE && used < clip->dataCount; t++) {
+        uint32_t keyCount = words[used++];
+        int components = (t % TRACKS_PER_BONE == TRACK_ROTATION) ? 4 : 3;
+        if (keyCount > (clip->dataCount - used) / (1 + components)) break;   // Damaged image
+        anim->tracks[t].keyCount = keyCount;
+        anim->tracks[t].times = (float*)(words + used);
+        anim->tracks[t].values = anim->tracks[t].times + keyCount;
+        used += keyCount * (1 + components);
+    }
+}
+
+// True when `count` items of `itemSize` bytes at `offset` lie inside an image
+// of `size` bytes
+static int ImageSpanFits(uint32_t size, uint32_t offset, uint32_t count, uint32_t itemSize) {
+    return offset <= size && (uint64_t)count * itemSize <= size - offset;
+}
+
+// Checks the header against the `available` bytes before anything is
+// allocated for it: the tables have to fit the image, and the image has to
+// account for the tracks and vertices LayoutImageModel() makes room for
+static int CheckImageHeader(const DMSImageHeader* header, size_t available) {
+    if (header->size < sizeof(DMSImageHeader) || header->size > available) return 0;
+    uint64_t tables = sizeof(DMSImageHeader) + (uint64_t)header->meshCount * sizeof(DMSImageMesh) +
+                      (uint64_t)header->boneCount * sizeof(DMSImageBone) +
+                      (uint64_t)header->animCount * sizeof(DMSImageClip);
+    return tables <= header->size &&
+           (uint64_t)header->trackCount * sizeof(uint16_t) <= header->size &&
+           (uint64_t)header->skinnedVertexCount * sizeof(DMSPackedVertex) <= header->size;
+}
+
+// Checks every offset and length in the tables against the image, so
+// BuildImageModel() only touches bytes inside it
+static int CheckImageRecords(const uint8_t* image) {
+    const DMSImageHeader* header = (const DMSImageHeader*)image;
+    const DMSImageMesh* meshRecords = (const DMSImageMesh*)(header + 1);
+    const DMSImageBone* boneRecords = (const DMSImageBone*)(meshRecords + header->meshCount);
+    const DMSImageClip* clipRecords = (const DMSImageClip*)(boneRecords + header->boneCount);
+
+    uint64_t skinnedVertexCount = 0;
+    for (uint32_t m = 0; m < header->meshCount; m++) {
+        const DMSImageMesh* record = &meshRecords[m];
+        int packed = (record->vertexFormat & ~(VERTEX_BONE_SPACE | VERTEX_RIGID)) == VERTEX_FORMAT_PACKED;
+        uint32_t vertexSize = packed ? sizeof(DMSPackedVertex) : sizeof(DMSVertex);
+        if ((record->indexSize != 2 && record->indexSize != 4) ||
+            record->vertices % 32 || record->stripLengths % 4 || record->indices % record->indexSize ||
+            !ImageSpanFits(header->size, record->vertices, record->vertexCount, vertexSize) ||
+            !ImageSpanFits(header->size, record->stripLengths, record->stripCount, sizeof(uint32_t)) ||
+            !ImageSpanFits(header->size, record->indices, record->indexCount, record->indexSize)) {
+            return 0;
+        }
+        if (!(record->vertexFormat & VERTEX_RIGID) && header->boneCount > 0) skinnedVertexCount += record->vertexCount;
+    }
+    if (skinnedVertexCount > header->skinnedVertexCount) return 0;
+
+    for (uint32_t i = 0; i < header->boneCount; i++) {
+        if (boneRecords[i].parent < -1 || boneRecords[i].parent >= (int32_t)header->boneCount) return 0;
+    }
+
+    uint64_t trackCount = 0;
+    for (uint32_t i = 0; i < header->animCount; i++) {
+        const DMSImageClip* clip = &clipRecords[i];
+        uint32_t wordSize = clip->encoding == ANIM_ENCODING_QUANTIZED ? sizeof(uint16_t) : sizeof(uint32_t);
+        if (clip->boneCount < 0 || (uint32_t)clip->boneCount > header->boneCount || clip->data % wordSize ||
+            !ImageSpanFits(header->size, clip->data, clip->dataCount, wordSize)) {
+            return 0;
+        }
+        trackCount += (uint64_t)clip->boneCount * TRACKS_PER_BONE;
+    }
+    return trackCount <= header->trackCount;
+}
+
+// Builds the model's structs in `block` (LayoutImageModel() bytes) around an
+// image. Everything but skinning results stays in the image and is used in
+// place; packed meshes are drawn straight from it.
+static DMSModel* BuildImageModel(uint8_t* block, const uint8_t* image) {
+    const DMSImageHeader* header = (const DMSImageHeader*)image;
+    const DMSImageMesh* meshRecords = (const DMSImageMesh*)(header + 1);
+    const DMSImageBone* boneRecords = (const DMSImageBone*)(meshRecords + header->meshCount);
+    const DMSImageClip* clipRecords = (const DMSImageClip*)(boneRecords + header->boneCount);
+
+    ImageParts parts;
+    size_t runtimeSize = LayoutImageModel(header, (uintptr_t)block, &parts);
+    memset(block, 0, runtimeSize);
+
+    DMSModel* model = parts.model;
+    model->image = image;
+    model->meshes = parts.meshes;
+    model->meshCount = header->meshCount;
+
+    DMSVertex* vertexPool = parts.vertices;
+    int maxTextureId = -1;
+    for (uint32_t m = 0; m < header->meshCount; m++) {
+        const DMSImageMesh* record = &meshRecords[m];
+        DMSMesh* mesh = &model->meshes[m];
+        mesh->vertexCount = record->vertexCount;
+        mesh->indexCount = record->indexCount;
+        mesh->textureId = record->textureId;
+        mesh->stripCount = record->stripCount;
+        mesh->stripIndexCount = record->stripIndexCount;
+        mesh->indexSize = record->indexSize;
+        mesh->triangleCount = record->triangleCount;
+        mesh->stripLengths = (uint32_t*)(image + record->stripLengths);
+        mesh->indices = (void*)(image + record->indices);
+        mesh->boneSpace = (record->vertexFormat & VERTEX_BONE_SPACE) != 0;
+
+        if ((record->vertexFormat & ~(VERTEX_BONE_SPACE | VERTEX_RIGID)) == VERTEX_FORMAT_PACKED) {
+            mesh->packedVertices = (DMSPackedVertex*)(image + record->vertices);
+            mesh->positionOffset = record->positionOffset;
+            mesh->positionScale = record->positionScale;
+            memcpy(mesh->uvOffset, record->uvOffset, sizeof(mesh->uvOffset));
+            memcpy(mesh->uvScale, record->uvScale, sizeof(mesh->uvScale));
+        } else {
+            mesh->vertices = (DMSVertex*)(image + record->vertices);
+        }
+        mesh->rigidBone = -1;
+        if ((record->vertexFormat & VERTEX_RIGID) && mesh->vertexCount > 0) {
+            // Rigid meshes have no skinning results
+            mesh->rigidBone = mesh->vertices ? mesh->vertices[0].boneId : mesh->packedVertices[0].boneId;
+        } else if (header->boneCount > 0) {
+            mesh->animatedVertices = vertexPool;
+            vertexPool += mesh->vertexCount;
+            if (mesh->vertices) {
+                memcpy(mesh->animatedVertices, mesh->vertices, mesh->vertexCount * sizeof(DMSVertex));
+            } else {
+                UnpackVertices(mesh, mesh->animatedVertices);
+            }
+        }
+        if (mesh->textureId > maxTextureId) maxTextureId = mesh->textureId;
+    }
+
+    if (header->boneCount > 0) {
+        Skeleton* skeleton = parts.skeleton;
+        model->skeleton = skeleton;
+        skeleton->bones = parts.bones;
+        skeleton->boneCount = header->boneCount;
+        skeleton->composedAnim = -1;
+        skeleton->palette = parts.palette;
+        for (uint32_t i = 0; i < header->boneCount; i++) {
+            memcpy(skeleton->bones[i].name, boneRecords[i].name, sizeof(skeleton->bones[i].name));
+            skeleton->bones[i].parent = boneRecords[i].parent;
+            skeleton->bones[i].bindPose = boneRecords[i].bindPose;
+            skeleton->bones[i].inverseBindMatrix = boneRecords[i].inverseBindMatrix;
+        }
+
+        skeleton->animations = header->animCount > 0 ? parts.animations : NULL;
+        skeleton->animCount = header->animCount;
+        Track* trackPool = parts.tracks;
+        for (uint32_t i = 0; i < header->animCount; i++) {
+            const DMSImageClip* clip = &clipRecords[i];
+            Animation* anim = &skeleton->animations[i];
+            memcpy(anim->name, clip->name, sizeof(anim->name));
+            anim->boneCount = clip->boneCount;
+            anim->frameCount = clip->frameCount;
+            anim->duration = clip->duration;
+            anim->timeStep = clip->timeStep;
+            anim->translationMin = clip->translationMin;
+            anim->translationStep = clip->translationStep;
+            anim->scaleMin = clip->scaleMin;
+            anim->scaleStep = clip->scaleStep;
+            anim->tracks = trackPool;
+            trackPool += clip->boneCount * TRACKS_PER_BONE;
+            LinkImageTracks(anim, clip, image);
+        }
+        SetBindWorldPoses(model);
+    }
+
+    // The texture table is filled by the caller, so it stays separate
+    model->textureCount = (int)header->textureCount > maxTextureId ? (int)header->textureCount : maxTextureId + 1;
+    if (model->textureCount > 0) {
+        model->textures = (kos_texture_t**)calloc(model->textureCount, sizeof(kos_texture_t*));
+        if (!model->textures) {
+            printf("Out of memory for %d DMS textures\n", model->textureCount);
+            free(block);
+            return NULL;
+        }
+    }
+    return model;
+}
+
+// Reads a whole image with one fread into the block that also holds the
+// model's structs
+static DMSModel* ReadImage(FILE* file) {
+    DMSImageHeader header;
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.version != DMS_IMAGE_VERSION) {
+        printf("Unsupported DMS image\n");
+        return NULL;
+    }
+    if (fileSize < 0 || !CheckImageHeader(&header, (size_t)fileSize)) {
+        printf("Damaged DMS image\n");
+        return NULL;
+    }
+
+    ImageParts parts;
+    size_t runtimeSize = LayoutImageModel(&header, 0, &parts);
+    uint8_t* block = (uint8_t*)memalign(32, runtimeSize + header.size);
+    if (!block) {
+        printf("Out of memory for a %lu byte DMS image\n", (unsigned long)(runtimeSize + header.size));
+        return NULL;
+    }
+    uint8_t* image = block + runtimeSize;
+
+    fseek(file, 0, SEEK_SET);
+    if (fread(image, 1, header.size, file) != header.size) {
+        printf("Truncated DMS image\n");
+        free(block);
+        return NULL;
+    }
+    if (!CheckImageRecords(image)) {
+        printf("Damaged DMS image\n");
+        free(block);
+        return NULL;
+    }
+    return BuildImageModel(block, image);
+}
+
+DMSModel* LoadDMSModelImage(const void* image) {
+    const DMSImageHeader* header = (const DMSImageHeader*)image;
+    if (header->magic != DMS_IMAGE_MAGIC || header->version != DMS_IMAGE_VERSION) {
+        printf("Unsupported DMS image\n");
+        return NULL;
+    }
+    // The caller vouches for header->size bytes; the tables are checked within them
+    if (!CheckImageHeader(header, header->size) || !CheckImageRecords((const uint8_t*)image)) {
+        printf("Damaged DMS image\n");
+        return NULL;
+    }
+
+    ImageParts parts;
+    uint8_t* block = (uint8_t*)memalign(32, LayoutImageModel(header, 0, &parts));
+    if (!block) {
+        printf("Out of memory for a DMS image\n");
+        return NULL;
+    }
+    return BuildImageModel(block, (const uint8_t*)image);
+}
+
 DMSModel* LoadDMSModel(const char* filename) {
+    return LoadDMSModelSections(filename, DMS_LOAD_ALL);
+}
+
+DMSModel* LoadDMSModelSections(const char* filename, uint32_t sections) {
     FILE* file = fopen(filename, "rb");
     if (!file) {
         printf("Failed to open %s\n", filename);
@@ -20,175 +753,185 @@ DMSModel* LoadDMSModel(const char* filename) {
     fread(&meshCount, sizeof(uint32_t), 1, file);
     fread(&boneCount, sizeof(uint32_t), 1, file);
 
+    // In-place images load whole, in one read
+    if (magic == DMS_IMAGE_MAGIC) {
+        DMSModel* model = ReadImage(file);
+        fclose(file);
+        return model;
+    }
+
     if (magic != 0x54534D44) { // "DMS\0" in little endian
         printf("Invalid file format: magic mismatch\n");
         fclose(file);
         return NULL;
     }
 
+    // Only chunked files can leave sections out; older ones load whole.
+    // Skinning results are not a section, so any file can go without.
+    if (version < 6) sections = (DMS_LOAD_ALL & ~DMS_LOAD_SKINNING) | (sections & DMS_LOAD_SKINNING);
+
     DMSModel* model = (DMSModel*)calloc(1, sizeof(DMSModel));
-    model->meshCount = meshCount;
+    model->meshCount = (sections & DMS_LOAD_MESHES) ? meshCount : 0;
     model->meshes = (DMSMesh*)calloc(meshCount, sizeof(DMSMesh));
 
     // If skeleton
-    if (boneCount > 0) {
+    if (boneCount > 0 && (sections & DMS_LOAD_SKELETON)) {
         model->skeleton = (Skeleton*)calloc(1, sizeof(Skeleton));
         model->skeleton->boneCount = boneCount;
         model->skeleton->bones = (Bone*)calloc(boneCount, sizeof(Bone));
-
-        // Read bones
-        for (uint32_t i = 0; i < boneCount; i++) {
-            Bone* b = &model->skeleton->bones[i];
-            fread(b->name, sizeof(char), 64, file);
-            fread(&b->parent, sizeof(int), 1, file);
-            fread(&b->bindPose, sizeof(Transform), 1, file);
-            fread(&b->inverseBindMatrix, sizeof(Matrix), 1, file);
-        }
-
-        // Animations
-        uint32_t animCount = 0;
-        fread(&animCount, sizeof(uint32_t), 1, file);
-        if (animCount > 0) {
-            model->skeleton->animCount = animCount;
-            model->skeleton->animations = (Animation*)calloc(animCount, sizeof(Animation));
-
-            for (uint32_t i = 0; i < animCount; i++) {
-                Animation* A = &model->skeleton->animations[i];
-                fread(A->name, sizeof(char), 32, file);
-                fread(&A->boneCount, sizeof(int), 1, file);
-                fread(&A->frameCount, sizeof(int), 1, file);
-                fread(&A->duration, sizeof(float), 1, file);
-
-                size_t totalPoses = A->frameCount * A->boneCount;
-                Transform* T = (Transform*)calloc(totalPoses, sizeof(Transform));
-                fread(T, sizeof(Transform), totalPoses, file);
-                A->framePoses = (Transform**)T;
-            }
-            // default anim
-            model->skeleton->currentAnim = 0;
-            model->skeleton->currentTime = 0.0f;
-        }
-    } else {
+        // default anim
+        model->skeleton->currentAnim = 0;
+        model->skeleton->currentTime = 0.0f;
+        model->skeleton->composedAnim = -1;
+        model->skeleton->palette = (matrix_t*)memalign(32, (boneCount + 1) * sizeof(matrix_t));
+    } else if (boneCount == 0) {
         // No skeleton - static model
         printf("Loading static model (no skeleton)\n");
-        model->skeleton = NULL;
-        
-        // Still need to read past animation count field
-        uint32_t animCount = 0;
-        fread(&animCount, sizeof(uint32_t), 1, file);
     }
 
-    // Meshes
-    for (uint32_t m = 0; m < meshCount; m++) {
-        DMSMesh* mesh = &model->meshes[m];
-        fread(&mesh->vertexCount, sizeof(uint32_t), 1, file);
-        fread(&mesh->indexCount, sizeof(uint32_t), 1, file);
-        fread(&mesh->textureId, sizeof(int), 1, file);  // Read texture ID
+    if (version >= 6) {
+        ReadChunks(model, version, boneCount, sections, file);
+    } else {
+        ReadSections(model, version, sections, file);
+    }
+    fclose(file);
+    if (model->skeleton) SetBindWorldPoses(model);
 
-        mesh->vertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
-        
-        // For animated models,  allocate animated vertices buffer
-        if (model->skeleton) {
-            mesh->animatedVertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
-            
-            // Read full Vertex1 data for animated models
-            fread(mesh->vertices, sizeof(DMSVertex), mesh->vertexCount, file);
-            
-            // Initialize animated vertices with bind pose
-            for (int i = 0; i < mesh->vertexCount; i++) {
-                mesh->animatedVertices[i] = mesh->vertices[i];
-            }
-        } else {
-            // For static models, read simplified StaticVertex data and convert
-            typedef struct {
-                float x, y, z;        // Position
-                float nx, ny, nz;     // Normal
-                float u, v;           // Texture coordinates
-            } StaticVertex;
-
-            StaticVertex* tempVerts = (StaticVertex*)malloc(mesh->vertexCount * sizeof(StaticVertex));
-            fread(tempVerts, sizeof(StaticVertex), mesh->vertexCount, file);
-            
-            // Convert to Vertex1 format (with default bone data)
-            for (int i = 0; i < mesh->vertexCount; i++) {
-                mesh->vertices[i].x = tempVerts[i].x;
-                mesh->vertices[i].y = tempVerts[i].y;
-                mesh->vertices[i].z = tempVerts[i].z;
-                mesh->vertices[i].nx = tempVerts[i].nx;
-                mesh->vertices[i].ny = tempVerts[i].ny;
-                mesh->vertices[i].nz = tempVerts[i].nz;
-                mesh->vertices[i].u = tempVerts[i].u;
-                mesh->vertices[i].v = tempVerts[i].v;
-                mesh->vertices[i].boneId = 0;
-                mesh->vertices[i].boneWeight = 0.0f;
-            }
-            
-            free(tempVerts);
-            mesh->animatedVertices = NULL; // Static models don't need this
+    // Without a material table, the highest texture ID gives the texture count
+    int maxTextureId = -1;
+    for (int m = 0; m < model->meshCount; m++) {
+        if (model->meshes[m].textureId > maxTextureId) {
+            maxTextureId = model->meshes[m].textureId;
         }
+    }
+    if (model->textureCount <= maxTextureId) {
+        model->textureCount = maxTextureId + 1;
+    }
 
-        int maxTextureId = -1;
-        for (uint32_t m = 0; m < meshCount; m++) {
-            if (model->meshes[m].textureId > maxTextureId) {
-                maxTextureId = model->meshes[m].textureId;
-            }
-        }
-        
-        // Set texture count and allocate texture array
-        model->textureCount = (maxTextureId >= 0) ? (maxTextureId + 1) : 0;
-        if (model->textureCount > 0) {
-            model->textures = (kos_texture_t**)calloc(model->textureCount, sizeof(kos_texture_t*));
-        }
+    // Allocate texture array
+    if (model->textureCount > 0) {
+        model->textures = (kos_texture_t**)calloc(model->textureCount, sizeof(kos_texture_t*));
+    }
 
-        // Read indices
-        mesh->indices = (unsigned int*)calloc(mesh->indexCount, sizeof(unsigned int));
-        fread(mesh->indices, sizeof(unsigned int), mesh->indexCount, file);
+    return model;
+}
 
-        // Precompute triangle count for this mesh
-        unsigned int triCount = 0;
-        if (mesh->indices == NULL || mesh->indexCount <= 0) {
-            triCount = mesh->vertexCount / 3;
-        } else {
-            int i = 0;
-            while (i < mesh->indexCount) {
-                uint32_t rawIndex = mesh->indices[i];
-                int isStrip = (rawIndex & 0x80000000) != 0;
-                uint32_t sId = (rawIndex >> 24) & 0x7F;
-
-                if (isStrip) {
-                    // Start of a TRIANGLE_STRIP
-                    int stripLength = 0;
-
-                    while (i < mesh->indexCount) {
-                        rawIndex = mesh->indices[i];
-                        isStrip = (rawIndex & 0x80000000) != 0;
-                        uint32_t thisSid = (rawIndex >> 24) & 0x7F;
-                        if (!isStrip || thisSid != sId)
-                            break;
-                        stripLength++;
-                        i++;
-                    }
-
-                    if (stripLength >= 3)
-                        triCount += (stripLength - 2);
-                }
-                else {
-                    // Normal triangle list
-                    if (i + 2 < mesh->indexCount) {
-                        triCount += 1;
-                        i += 3;
-                    }
-                    else {
-                        i++;
-                    }
-                }
-            }
-        }
-        mesh->triangleCount = triCount;
+// Finds the key at or before `time`, continuing from the bone's last key so
+// forward playback is O(1); seeks from the start when time moved backward
+static int SeekTrack(const Track* track, float time, int* cursor, float* alpha) {
+    int k = *cursor;
+    if (k < 0 || k >= track->keyCount || track->times[k] > time) k = 0;
+    while (k + 1 < track->keyCount && track->times[k + 1] <= time) k++;
+    *cursor = k;
+
+    *alpha = 0.0f;
+    if (k + 1 < track->keyCount && time > track->times[k]) {
+        *alpha = (time - track->times[k]) / (track->times[k + 1] - track->times[k]);
+    }
+    return k;
+}
+
+static Vector3 SampleVector3(const Track* track, float time, int* cursor, Vector3 fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const float* v = track->values + SeekTrack(track, time, cursor, &alpha) * 3;
+    Vector3 a = { v[0], v[1], v[2] };
+    if (alpha == 0.0f) return a;
+    Vector3 b = { v[3], v[4], v[5] };
+    return Vector3Lerp(a, b, alpha);
+}
+
+// Keys closer than this (cosine of half the angle) are nlerped; the
+// converter fits tracks with QuaternionSlerp(), which switches at the same
+// point, so the fit tolerance holds either way
+#define NLERP_MIN_DOT 0.95f
+
+static inline Quaternion InterpolateQuaternion(Quaternion a, Quaternion b, float alpha) {
+    float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    if (dot < 0.0f) {
+        b.x = -b.x; b.y = -b.y; b.z = -b.z; b.w = -b.w;
+        dot = -dot;
     }
+    if (dot <= NLERP_MIN_DOT) return QuaternionSlerp(a, b, alpha);
 
-    fclose(file);
-    return model;
+    Quaternion q = { a.x + (b.x - a.x) * alpha, a.y + (b.y - a.y) * alpha,
+                     a.z + (b.z - a.z) * alpha, a.w + (b.w - a.w) * alpha };
+    float invLength = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    q.x *= invLength;
+    q.y *= invLength;
+    q.z *= invLength;
+    q.w *= invLength;
+    return q;
+}
+
+static Quaternion SampleQuaternion(const Track* track, float time, int* cursor, Quaternion fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const float* q = track->values + SeekTrack(track, time, cursor, &alpha) * 4;
+    Quaternion a = { q[0], q[1], q[2], q[3] };
+    if (alpha == 0.0f) return a;
+    Quaternion b = { q[4], q[5], q[6], q[7] };
+    return InterpolateQuaternion(a, b, alpha);
+}
+
+// SeekTrack over the tick times of a quantized track
+static int SeekTicks(const Track* track, float tick, int* cursor, float* alpha) {
+    const uint16_t* ticks = track->ticks;
+    int k = *cursor;
+    if (k < 0 || k >= track->keyCount || ticks[k] > tick) k = 0;
+    while (k + 1 < track->keyCount && ticks[k + 1] <= tick) k++;
+    *cursor = k;
+
+    *alpha = 0.0f;
+    if (k + 1 < track->keyCount && tick > ticks[k]) {
+        *alpha = (tick - ticks[k]) / (float)(ticks[k + 1] - ticks[k]);
+    }
+    return k;
+}
+
+static Vector3 DecodeFixed(const uint16_t* q, Vector3 min, Vector3 step) {
+    Vector3 v = { min.x + q[0] * step.x, min.y + q[1] * step.y, min.z + q[2] * step.z };
+    return v;
+}
+
+// Smallest three: bit 15 of the first two words indexes the dropped
+// (largest, positive) component, the low 15 bits hold the other three
+static Quaternion DecodeQuaternion(const uint16_t* q) {
+    const float limit = 0.70710678f;
+    float c[4];
+    int largest = (q[0] >> 15) | ((q[1] >> 15) << 1);
+    float sum = 0.0f;
+    for (int i = 0, w = 0; i < 4; i++) {
+        if (i == largest) continue;
+        c[i] = (q[w++] & 0x7FFF) * (2.0f * limit / 32767.0f) - limit;
+        sum += c[i] * c[i];
+    }
+    c[largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+    Quaternion r = { c[0], c[1], c[2], c[3] };
+    return r;
+}
+
+static Vector3 SampleFixedVector3(const Track* track, float tick, int* cursor,
+                                  Vector3 min, Vector3 step, Vector3 fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const uint16_t* q = track->ticks + track->keyCount + SeekTicks(track, tick, cursor, &alpha) * 3;
+    Vector3 a = DecodeFixed(q, min, step);
+    if (alpha == 0.0f) return a;
+    return Vector3Lerp(a, DecodeFixed(q + 3, min, step), alpha);
+}
+
+static Quaternion SampleQuantizedQuaternion(const Track* track, float tick, int* cursor, Quaternion fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const uint16_t* q = track->ticks + track->keyCount + SeekTicks(track, tick, cursor, &alpha) * 3;
+    Quaternion a = DecodeQuaternion(q);
+    if (alpha == 0.0f) return a;
+    return InterpolateQuaternion(a, DecodeQuaternion(q + 3), alpha);
 }
 
 void UpdateDMSModelAnimation(DMSModel* model, float deltaTime) {
@@ -199,35 +942,68 @@ void UpdateDMSModelAnimation(DMSModel* model, float deltaTime) {
     sk->currentTime += deltaTime;
 
     // Loop
-    while (sk->currentTime >= anim->duration) {
-        sk->currentTime -= anim->duration;
+    if (anim->duration > 0.0f) {
+        while (sk->currentTime >= anim->duration) {
+            sk->currentTime -= anim->duration;
+        }
+    } else {
+        sk->currentTime = 0.0f;
     }
 
-    if (anim->frameCount < 2) return;
-
-    float timePerFrame = anim->duration / (float)anim->frameCount;
-    int frame = (int)(sk->currentTime / timePerFrame);
-    int nextFrame = (frame + 1) % anim->frameCount;
-    float alpha = fmodf(sk->currentTime, timePerFrame) / timePerFrame;
+    if (!anim->tracks) return;
 
+    // Bones with constant tracks keep the pose sampled for the same clip last
+    // time, and their world pose too unless an ancestor moved
+    int sameClip = sk->composedAnim == sk->currentAnim;
+    sk->composedAnim = sk->currentAnim;
     for (int i = 0; i < sk->boneCount; i++) {
         Bone* bone = &sk->bones[i];
-        Transform* curr = &((Transform*)anim->framePoses)[frame * sk->boneCount + i];
-        Transform* nxt  = &((Transform*)anim->framePoses)[nextFrame * sk->boneCount + i];
-
-        // Interp
-        bone->localPose.translation = Vector3Lerp(curr->translation, nxt->translation, alpha);
-        bone->localPose.rotation    = QuaternionSlerp(curr->rotation, nxt->rotation, alpha);
-        bone->localPose.scale       = Vector3Lerp(curr->scale, nxt->scale, alpha);
-
-        Matrix __attribute__((aligned(32))) S = MatrixScale(bone->localPose.scale.x, bone->localPose.scale.y, bone->localPose.scale.z);
-        Matrix __attribute__((aligned(32))) R = QuaternionToMatrix(bone->localPose.rotation);
-        Matrix __attribute__((aligned(32))) T = MatrixTranslate(bone->localPose.translation.x, bone->localPose.translation.y, bone->localPose.translation.z);
-        Matrix __attribute__((aligned(32))) SR, local;
-        
-        mat_mult(&S, &R, &SR);
-        mat_mult(&SR, &T, &local);
-        
+        const Track* tracks = &anim->tracks[i * TRACKS_PER_BONE];
+        float time = sk->currentTime;
+
+        int parentMoved = bone->parent >= 0 && sk->bones[bone->parent].moved;
+        bone->moved = !sameClip || tracks[TRACK_TRANSLATION].keyCount > 1 ||
+                      tracks[TRACK_ROTATION].keyCount > 1 || tracks[TRACK_SCALE].keyCount > 1;
+
+        // Sample each channel at its own keys
+        if (!bone->moved) {
+            if (!parentMoved) continue;
+            bone->moved = 1;
+        } else if (anim->keyWords) {
+            float tick = anim->timeStep > 0.0f ? time / anim->timeStep : 0.0f;
+            Vector3 one = { 1.0f, 1.0f, 1.0f };
+            bone->localPose.translation = SampleFixedVector3(&tracks[TRACK_TRANSLATION], tick,
+                &bone->trackCursor[TRACK_TRANSLATION], anim->translationMin, anim->translationStep,
+                bone->bindPose.translation);
+            bone->localPose.rotation    = SampleQuantizedQuaternion(&tracks[TRACK_ROTATION], tick,
+                &bone->trackCursor[TRACK_ROTATION], bone->bindPose.rotation);
+            // Scale tracks without keys are constant 1
+            bone->localPose.scale       = SampleFixedVector3(&tracks[TRACK_SCALE], tick,
+                &bone->trackCursor[TRACK_SCALE], anim->scaleMin, anim->scaleStep, one);
+        } else {
+            bone->localPose.translation = SampleVector3(&tracks[TRACK_TRANSLATION], time,
+                &bone->trackCursor[TRACK_TRANSLATION], bone->bindPose.translation);
+            bone->localPose.rotation    = SampleQuaternion(&tracks[TRACK_ROTATION], time,
+                &bone->trackCursor[TRACK_ROTATION], bone->bindPose.rotation);
+            bone->localPose.scale       = SampleVector3(&tracks[TRACK_SCALE], time,
+                &bone->trackCursor[TRACK_SCALE], bone->bindPose.scale);
+        }
+
+        // Local transform straight from scale, rotation (unit quaternion) and
+        // translation; only the parent multiply goes through the matrix unit
+        Quaternion q = bone->localPose.rotation;
+        Vector3 s = bone->localPose.scale;
+        float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+        Matrix __attribute__((aligned(32))) local = {
+            .m0 = (1.0f - 2.0f * (yy + zz)) * s.x, .m1 = 2.0f * (xy + wz) * s.x, .m2 = 2.0f * (xz - wy) * s.x,
+            .m4 = 2.0f * (xy - wz) * s.y, .m5 = (1.0f - 2.0f * (xx + zz)) * s.y, .m6 = 2.0f * (yz + wx) * s.y,
+            .m8 = 2.0f * (xz + wy) * s.z, .m9 = 2.0f * (yz - wx) * s.z, .m10 = (1.0f - 2.0f * (xx + yy)) * s.z,
+            .m12 = bone->localPose.translation.x, .m13 = bone->localPose.translation.y,
+            .m14 = bone->localPose.translation.z, .m15 = 1.0f
+        };
+
         if (bone->parent >= 0) {
             mat_mult(&local, &sk->bones[bone->parent].worldPose, &bone->worldPose);
         } else {
@@ -236,34 +1012,92 @@ void UpdateDMSModelAnimation(DMSModel* model, float deltaTime) {
     }
 }
 
-
-
-
-
 void UpdateDMSMeshAnimation(DMSMesh* mesh, const Skeleton* sk) {
-    if (!mesh || !sk) return;
+    // Rigid meshes and float meshes loaded without DMS_LOAD_SKINNING have no results
+    if (!mesh || !sk || !mesh->animatedVertices) return;
 
     //  an aligned matrix for hardware operations
     static Matrix __attribute__((aligned(32))) tempMatrix;
 
+    // animatedVertices hold the bind pose from the load on, and only weighted
+    // positions move. Bone-space meshes take the bone's world pose as is;
+    // the others go through the inverse bind matrix first.
     for (int i = 0; i < mesh->vertexCount; i++) {
-        mesh->animatedVertices[i] = mesh->vertices[i];
-
-        // If weighted
-        if (mesh->vertices[i].boneWeight > 0.0f) {
-            uint8_t bId = mesh->vertices[i].boneId;
-            if (bId < sk->boneCount) {
-                mat_mult(&sk->bones[bId].inverseBindMatrix, &sk->bones[bId].worldPose, &tempMatrix);
-                
-                Vector3 bindPos = (Vector3){mesh->vertices[i].x, mesh->vertices[i].y, mesh->vertices[i].z};
-                Vector3 newPos = Vector3Transform(bindPos, tempMatrix);
-                mesh->animatedVertices[i].x = newPos.x;
-                mesh->animatedVertices[i].y = newPos.y;
-                mesh->animatedVertices[i].z = newPos.z;
-            }
+        uint8_t bId;
+        if (mesh->vertices) {
+            if (mesh->vertices[i].boneWeight <= 0.0f) continue;
+            bId = mesh->vertices[i].boneId;
+        } else {
+            if (mesh->packedVertices[i].boneWeight == 0) continue;
+            bId = mesh->packedVertices[i].boneId;
         }
+        if (bId >= sk->boneCount) continue;
+
+        const Matrix* boneMatrix = &sk->bones[bId].worldPose;
+        if (!mesh->boneSpace) {
+            mat_mult(&sk->bones[bId].inverseBindMatrix, boneMatrix, &tempMatrix);
+            boneMatrix = &tempMatrix;
+        }
+        Vector3 newPos = Vector3Transform(DMSMeshPosition(mesh, i), *boneMatrix);
+        mesh->animatedVertices[i].x = newPos.x;
+        mesh->animatedVertices[i].y = newPos.y;
+        mesh->animatedVertices[i].z = newPos.z;
     }
 }
 
+void BuildDMSPalette(Skeleton* sk, int boneSpace) {
+    static matrix_t __attribute__((aligned(32))) base;
+    mat_store(&base);
+
+    // Bone-space meshes take the bone's world pose as is; the others go
+    // through the inverse bind matrix first, like UpdateDMSMeshAnimation()
+    for (int b = 0; b < sk->boneCount; b++) {
+        ApplyDMSMatrix(&sk->bones[b].worldPose);
+        if (!boneSpace) ApplyDMSMatrix(&sk->bones[b].inverseBindMatrix);
+        mat_store(&sk->palette[b]);
+        mat_load(&base);
+    }
+    mat_store(&sk->palette[sk->boneCount]);
+}
+
+// Frees what the loader allocated. Textures themselves belong to the caller;
+// only the table pointing at them is freed.
+void UnloadDMSModel(DMSModel* model) {
+    if (!model) return;
+
+    // An image model is a single block; only the texture table lives outside it
+    if (model->image) {
+        if (model->textures) free(model->textures);
+        free(model);
+        return;
+    }
+
+    for (int m = 0; m < model->meshCount; m++) {
+        DMSMesh* mesh = &model->meshes[m];
+        if (mesh->vertices) free(mesh->vertices);
+        if (mesh->animatedVertices) free(mesh->animatedVertices);
+        if (mesh->packedVertices) free(mesh->packedVertices);
+        if (mesh->indices) free(mesh->indices);
+        if (mesh->stripLengths) free(mesh->stripLengths);
+    }
+    free(model->meshes);
+
+    if (model->skeleton) {
+        for (int i = 0; i < model->skeleton->animCount; i++) {
+            Animation* anim = &model->skeleton->animations[i];
+            if (anim->tracks) free(anim->tracks);
+            if (anim->keyData) free(anim->keyData);
+            if (anim->keyWords) free(anim->keyWords);
+        }
+        if (model->skeleton->animations) free(model->skeleton->animations);
+        free(model->skeleton->bones);
+        free(model->skeleton->palette);
+        free(model->skeleton);
+    }
+
+    if (model->textures) free(model->textures);
+    free(model);
+}
+
 
 
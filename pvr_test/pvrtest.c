@@ -10,6 +10,11 @@ int total_model_triangles = 0;
 
 #define NUM_BALLS 44
 
+// Experimental: skin float meshes while drawing them rather than into
+// animatedVertices. Off until it is measured against CPU skinning on the
+// SH4; bench/pvr_skinning compares the two on the host.
+#define FUSED_SKINNING 0
+
 typedef struct {
     float x, y, z;         
     float rx, ry, rz;      
@@ -65,12 +70,31 @@ void setupModelMatrix(float scale, float x_rot, float y_rot, float z_rot, float
     mat_scale(scale, scale, scale);
 }
 
+// Fused meshes through their bone's palette entry, the others from
+// vertexBuffer through the matrix already loaded
+static inline void transformVertex(const DMSModel* model, const DMSMesh* mesh, const DMSVertex* vertexBuffer,
+    int fused, uint32_t idx, int* loadedBone, pvr_vertex_t* vert) {
+    if (fused) {
+        SkinTransformDMSVertex(mesh, model->skeleton, idx, loadedBone, vert);
+    } else {
+        TransformDMSVertex(mesh, vertexBuffer, idx, vert);
+    }
+}
+
 void RenderDMSModel(const DMSModel* model, float scale, float rotX, float rotY, float rotZ, 
     float posX, float posY, float posZ, pvr_dr_state_t* dr_state) {
     if (!model) return;
 
     setupModelMatrix(scale, rotX, rotY, rotZ, posX, posY, posZ);
 
+    // Packed meshes append their dequantization to this per mesh
+    static matrix_t __attribute__((aligned(32))) modelMatrix;
+    mat_store(&modelMatrix);
+
+    // Fused meshes share one bone palette on the model matrix, built for
+    // the first one and again only if a mesh differs in boneSpace
+    int paletteBoneSpace = -1;
+
     for (int m = 0; m < model->meshCount; m++) {
         const DMSMesh* mesh = &model->meshes[m];
         
@@ -84,84 +108,81 @@ void RenderDMSModel(const DMSModel* model, float scale, float rotX, float rotY,
         setupRenderState(dr_state, texture);
         
         int i = 0;
-        const DMSVertex* vertexBuffer = model->skeleton ? mesh->animatedVertices : mesh->vertices;
+        // NULL for static and rigid packed meshes, which TransformDMSVertex
+        // reads packed. Rigid meshes take their bone's matrix instead of
+        // skinning. With FUSED_SKINNING, skinned float meshes are drawn from
+        // the bind pose through the palette; packed ones keep their
+        // animatedVertices.
+        int rigid = model->skeleton && mesh->rigidBone >= 0;
+        int fused = FUSED_SKINNING && model->skeleton && !rigid && mesh->vertices;
+        const DMSVertex* vertexBuffer = (model->skeleton && !rigid) ? mesh->animatedVertices : mesh->vertices;
+        int loadedBone = -1;
 
-        while (i < mesh->indexCount) {
-            uint32_t rawIndex = mesh->indices[i];
-            int isStrip = (rawIndex & 0x80000000) != 0;
-            uint32_t sId = (rawIndex >> 24) & 0x7F;
+        mat_load(&modelMatrix);
+        if (fused) {
+            if (mesh->boneSpace != paletteBoneSpace) {
+                BuildDMSPalette(model->skeleton, mesh->boneSpace);
+                paletteBoneSpace = mesh->boneSpace;
+            }
+        } else {
+            if (rigid) ApplyDMSMeshBone(mesh, model->skeleton);
+            if (!vertexBuffer) ApplyDMSMeshDequantization(mesh);
+        }
 
-            if (isStrip) {
-                // Find strip length
-                int stripLength = 0;
-                while ((i + stripLength) < mesh->indexCount) {
-                    rawIndex = mesh->indices[i + stripLength];
-                    if (!(rawIndex & 0x80000000) || ((rawIndex >> 24) & 0x7F) != sId)
-                        break;
-                    stripLength++;
-                }
+        // Strips straight from the strip table
+        for (int s = 0; s < mesh->stripCount; s++) {
+            int stripLength = mesh->stripLengths[s];
 
-                // Each strip consists of (stripLength-2) triangles
-                if (stripLength >= 3) {
-                    frame_triangle_count += (stripLength - 2);
-                }
+            // Each strip consists of (stripLength-2) triangles
+            if (stripLength >= 3) {
+                frame_triangle_count += (stripLength - 2);
+            }
 
-                // Process entire strip at once
-                for (int j = 0; j < stripLength; j++) {
-                    uint32_t idx = mesh->indices[i + j] & 0x00FFFFFF;
-                    const DMSVertex* v = &vertexBuffer[idx];
-                    
-                    pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                    vert->flags = (j == stripLength - 1) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
-                    mat_trans_single3_nomod(v->x, v->y, v->z, vert->x, vert->y, vert->z);
-                    vert->u = v->u;
-                    vert->v = v->v;
-                    vert->argb = 0xFFFFFFFF;
-                    
-                    pvr_dr_commit(vert);
-                }
-                
-                i += stripLength;
-            } else {
-                // Normal triangles
-                uint32_t idx1 = mesh->indices[i] & 0x00FFFFFF;
-                uint32_t idx2 = mesh->indices[i + 1] & 0x00FFFFFF;
-                uint32_t idx3 = mesh->indices[i + 2] & 0x00FFFFFF;
-                
-                const DMSVertex* v1 = &vertexBuffer[idx1];
-                const DMSVertex* v2 = &vertexBuffer[idx2];
-                const DMSVertex* v3 = &vertexBuffer[idx3];
+            // Process entire strip at once
+            for (int j = 0; j < stripLength; j++) {
+                uint32_t idx = DMSMeshIndex(mesh, i + j);
                 
-                // First vertex
                 pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                vert->flags = PVR_CMD_VERTEX;
-                mat_trans_single3_nomod(v1->x, v1->y, v1->z, vert->x, vert->y, vert->z);
-                vert->u = v1->u;
-                vert->v = v1->v;
+                vert->flags = (j == stripLength - 1) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+                transformVertex(model, mesh, vertexBuffer, fused, idx, &loadedBone, vert);
                 vert->argb = 0xFFFFFFFF;
-                pvr_dr_commit(vert);
-                
-                // Second vertex
-                vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                vert->flags = PVR_CMD_VERTEX;
-                mat_trans_single3_nomod(v2->x, v2->y, v2->z, vert->x, vert->y, vert->z);
-                vert->u = v2->u;
-                vert->v = v2->v;
-                vert->argb = 0xFFFFFFFF;
-                pvr_dr_commit(vert);
                 
-                // Third vertex
-                vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                vert->flags = PVR_CMD_VERTEX_EOL;
-                mat_trans_single3_nomod(v3->x, v3->y, v3->z, vert->x, vert->y, vert->z);
-                vert->u = v3->u;
-                vert->v = v3->v;
-                vert->argb = 0xFFFFFFFF;
                 pvr_dr_commit(vert);
-                
-                frame_triangle_count++;
-                i += 3;
             }
+            
+            i += stripLength;
+        }
+
+        // Then the triangle list
+        while (i + 2 < mesh->indexCount) {
+            // Normal triangles
+            uint32_t idx1 = DMSMeshIndex(mesh, i);
+            uint32_t idx2 = DMSMeshIndex(mesh, i + 1);
+            uint32_t idx3 = DMSMeshIndex(mesh, i + 2);
+            
+            // First vertex
+            pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
+            vert->flags = PVR_CMD_VERTEX;
+            transformVertex(model, mesh, vertexBuffer, fused, idx1, &loadedBone, vert);
+            vert->argb = 0xFFFFFFFF;
+            pvr_dr_commit(vert);
+            
+            // Second vertex
+            vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
+            vert->flags = PVR_CMD_VERTEX;
+            transformVertex(model, mesh, vertexBuffer, fused, idx2, &loadedBone, vert);
+            vert->argb = 0xFFFFFFFF;
+            pvr_dr_commit(vert);
+            
+            // Third vertex
+            vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
+            vert->flags = PVR_CMD_VERTEX_EOL;
+            transformVertex(model, mesh, vertexBuffer, fused, idx3, &loadedBone, vert);
+            vert->argb = 0xFFFFFFFF;
+            pvr_dr_commit(vert);
+            
+            frame_triangle_count++;
+            i += 3;
         }
     }
 }
@@ -266,40 +287,8 @@ int main(int argc, char **argv) {
 
     total_model_triangles = 0;
     for (int m = 0; m < gModel->meshCount; m++) {
-        int i = 0;
-        int mesh_triangles = 0;
-        
-        while (i < gModel->meshes[m].indexCount) {
-            uint32_t rawIndex = gModel->meshes[m].indices[i];
-            
-            if ((rawIndex & 0x80000000) != 0) {
-                // Triangle strip
-                uint32_t stripId = (rawIndex >> 24) & 0x7F;
-                int stripLength = 0;
-                
-                while (i < gModel->meshes[m].indexCount) {
-                    rawIndex = gModel->meshes[m].indices[i];
-                    if (!(rawIndex & 0x80000000) || ((rawIndex >> 24) & 0x7F) != stripId)
-                        break;
-                    stripLength++;
-                    i++;
-                }
-                
-                if (stripLength >= 3) {
-                    mesh_triangles += stripLength - 2;
-                }
-            } else {
-                if (i + 2 < gModel->meshes[m].indexCount) {
-                    mesh_triangles++;
-                    i += 3;
-                } else {
-                    i++;
-                }
-            }
-        }
-        
-        gModel->meshes[m].triangleCount = mesh_triangles;
-        total_model_triangles += mesh_triangles;
+        // The loader counts triangles from the strip table
+        total_model_triangles += gModel->meshes[m].triangleCount;
     }
     
     // Total triangles for all models
@@ -160,7 +160,9 @@ void RenderDMSMesh(const DMSModel* model, int meshIndex, float scale, float rotX
     setupModelMatrix(scale, rotX, rotY, rotZ, posX, posY, posZ);
 
     const DMSMesh* mesh = &model->meshes[meshIndex];
-    const DMSVertex* vertexBuffer = model->skeleton ? mesh->animatedVertices : mesh->vertices;
+    int rigid = model->skeleton && mesh->rigidBone >= 0;
+    const DMSVertex* vertexBuffer = (model->skeleton && !rigid) ? mesh->animatedVertices : mesh->vertices;
+    if (rigid) ApplyDMSMeshBone(mesh, model->skeleton);
 
     float envMat[16];
     memset(envMat, 0, sizeof(envMat));
@@ -189,170 +191,156 @@ void RenderDMSMesh(const DMSModel* model, int meshIndex, float scale, float rotX
     }
 
     int i = 0;
-    while (i < mesh->indexCount) {
-        uint32_t rawIndex = mesh->indices[i];
-        int isStrip = (rawIndex & 0x80000000) != 0;
-        uint32_t sId = (rawIndex >> 24) & 0x7F;
-
-        if (isStrip) {
-            // Find strip length
-            int stripLength = 0;
-            while ((i + stripLength) < mesh->indexCount) {
-                rawIndex = mesh->indices[i + stripLength];
-                if (!(rawIndex & 0x80000000) || ((rawIndex >> 24) & 0x7F) != sId)
-                    break;
-                stripLength++;
-            }
-
-            // Process entire strip at once
-            for (int j = 0; j < stripLength; j++) {
-                uint32_t idx = mesh->indices[i + j] & 0x00FFFFFF;
-                const DMSVertex* v = &vertexBuffer[idx];
-                
-                pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                vert->flags = (j == stripLength - 1) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
-                mat_trans_single3_nomod(v->x, v->y, v->z, vert->x, vert->y, vert->z);
-                
-                if (use_env_mapping) {
-                    // Normalize the normal before calculating texture coordinates
-                    float nx = v->nx, ny = v->ny, nz = v->nz;
-                    float len = fsqrt(nx*nx + ny*ny + nz*nz);
-                    
-                    if (len > 0.0001f) {
-                        nx /= len;
-                        ny /= len;
-                        nz /= len;
-                    } else {
-                        nx = 0.0f;
-                        ny = 0.0f;
-                        nz = 1.0f;
-                    }
-                    
-                    vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
-                    vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
-                    
-                    // Make the reflection fully opaque for the glass part (textureId 0)
-                    if (model->meshes[meshIndex].textureId == 0) {
-                        vert->argb = 0xFFFFFFFF;  // Fully opaque for glass reflection
-                    } else {
-                        vert->argb = 0xE0FFFFFF;  // Regular opacity for silver
-                    }
-                } else {
-                    vert->u = 1.0f - v->u;  // Flip horizontally
-                    vert->v = v->v;
-                    vert->argb = 0xC0FFFFFF;  // Original opacity
-                }
-                
-                pvr_dr_commit(vert);
-            }
+    // Strips straight from the strip table
+    for (int s = 0; s < mesh->stripCount; s++) {
+        int stripLength = mesh->stripLengths[s];
+
+        // Process entire strip at once
+        for (int j = 0; j < stripLength; j++) {
+            uint32_t idx = DMSMeshIndex(mesh, i + j);
+            const DMSVertex* v = &vertexBuffer[idx];
             
-            i += stripLength;
-        } else {
-            // Triangle list (3 vertices at a time)
-            if (i + 2 < mesh->indexCount) {
-                uint32_t idx1 = mesh->indices[i] & 0x00FFFFFF;
-                uint32_t idx2 = mesh->indices[i + 1] & 0x00FFFFFF;
-                uint32_t idx3 = mesh->indices[i + 2] & 0x00FFFFFF;
-                
-                const DMSVertex* v1 = &vertexBuffer[idx1];
-                const DMSVertex* v2 = &vertexBuffer[idx2];
-                const DMSVertex* v3 = &vertexBuffer[idx3];
-                
-                pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                vert->flags = PVR_CMD_VERTEX;
-                mat_trans_single3_nomod(v1->x, v1->y, v1->z, vert->x, vert->y, vert->z);
-                
-                if (use_env_mapping) {
-                    // Normalize the normal before calculating texture coordinates
-                    float nx = v1->nx, ny = v1->ny, nz = v1->nz;
-                    float len = fsqrt(nx*nx + ny*ny + nz*nz);
-                    
-                    if (len > 0.0001f) {
-                        nx /= len;
-                        ny /= len;
-                        nz /= len;
-                    } else {
-                        // Default normal if length is too small
-                        nx = 0.0f;
-                        ny = 0.0f;
-                        nz = 1.0f;
-                    }
-                    
-                    vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
-                    vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
-                    vert->argb = 0xE0FFFFFF;
-                } else {
-                    vert->u = v1->u;
-                    vert->v = v1->v;
-                    vert->argb = 0xC0FFFFFF;
-                }
-                
-                pvr_dr_commit(vert);
-                
-                // Vertex 2
-                vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                vert->flags = PVR_CMD_VERTEX;
-                mat_trans_single3_nomod(v2->x, v2->y, v2->z, vert->x, vert->y, vert->z);
+            pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
+            vert->flags = (j == stripLength - 1) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+            mat_trans_single3_nomod(v->x, v->y, v->z, vert->x, vert->y, vert->z);
+            
+            if (use_env_mapping) {
+                // Normalize the normal before calculating texture coordinates
+                float nx = v->nx, ny = v->ny, nz = v->nz;
+                float len = fsqrt(nx*nx + ny*ny + nz*nz);
                 
-                if (use_env_mapping) {
-                    float nx = v2->nx, ny = v2->ny, nz = v2->nz;
-                    float len = fsqrt(nx*nx + ny*ny + nz*nz);
-                    
-                    if (len > 0.0001f) {
-                        nx /= len;
-                        ny /= len;
-                        nz /= len;
-                    } else {
-                        nx = 0.0f;
-                        ny = 0.0f;
-                        nz = 1.0f;
-                    }
-                    
-                    vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
-                    vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
-                    vert->argb = 0xE0FFFFFF;
+                if (len > 0.0001f) {
+                    nx /= len;
+                    ny /= len;
+                    nz /= len;
                 } else {
-                    vert->u = v2->u;
-                    vert->v = v2->v;
-                    vert->argb = 0xC0FFFFFF;
+                    nx = 0.0f;
+                    ny = 0.0f;
+                    nz = 1.0f;
                 }
                 
-                pvr_dr_commit(vert);
-                
-                vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
-                vert->flags = PVR_CMD_VERTEX_EOL;
-                mat_trans_single3_nomod(v3->x, v3->y, v3->z, vert->x, vert->y, vert->z);
+                vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
+                vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
                 
-                if (use_env_mapping) {
-                    float nx = v3->nx, ny = v3->ny, nz = v3->nz;
-                    float len = fsqrt(nx*nx + ny*ny + nz*nz);
-                    
-                    if (len > 0.0001f) {
-                        nx /= len;
-                        ny /= len;
-                        nz /= len;
-                    } else {
-                        nx = 0.0f;
-                        ny = 0.0f;
-                        nz = 1.0f;
-                    }
-                    
-                    vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
-                    vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
-                    vert->argb = 0xE0FFFFFF;
+                // Make the reflection fully opaque for the glass part (textureId 0)
+                if (model->meshes[meshIndex].textureId == 0) {
+                    vert->argb = 0xFFFFFFFF;  // Fully opaque for glass reflection
                 } else {
-                    vert->u = v3->u;
-                    vert->v = v3->v;
-                    vert->argb = 0xC0FFFFFF;
+                    vert->argb = 0xE0FFFFFF;  // Regular opacity for silver
                 }
-                
-                pvr_dr_commit(vert);
-                
-                i += 3;
             } else {
-                i++;
+                vert->u = 1.0f - v->u;  // Flip horizontally
+                vert->v = v->v;
+                vert->argb = 0xC0FFFFFF;  // Original opacity
             }
+            
+            pvr_dr_commit(vert);
         }
+        
+        i += stripLength;
+    }
+
+    // Then the triangle list, 3 vertices at a time
+    while (i + 2 < mesh->indexCount) {
+        uint32_t idx1 = DMSMeshIndex(mesh, i);
+        uint32_t idx2 = DMSMeshIndex(mesh, i + 1);
+        uint32_t idx3 = DMSMeshIndex(mesh, i + 2);
+        
+        const DMSVertex* v1 = &vertexBuffer[idx1];
+        const DMSVertex* v2 = &vertexBuffer[idx2];
+        const DMSVertex* v3 = &vertexBuffer[idx3];
+        
+        pvr_vertex_t *vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
+        vert->flags = PVR_CMD_VERTEX;
+        mat_trans_single3_nomod(v1->x, v1->y, v1->z, vert->x, vert->y, vert->z);
+        
+        if (use_env_mapping) {
+            // Normalize the normal before calculating texture coordinates
+            float nx = v1->nx, ny = v1->ny, nz = v1->nz;
+            float len = fsqrt(nx*nx + ny*ny + nz*nz);
+            
+            if (len > 0.0001f) {
+                nx /= len;
+                ny /= len;
+                nz /= len;
+            } else {
+                // Default normal if length is too small
+                nx = 0.0f;
+                ny = 0.0f;
+                nz = 1.0f;
+            }
+            
+            vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
+            vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
+            vert->argb = 0xE0FFFFFF;
+        } else {
+            vert->u = v1->u;
+            vert->v = v1->v;
+            vert->argb = 0xC0FFFFFF;
+        }
+        
+        pvr_dr_commit(vert);
+        
+        // Vertex 2
+        vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
+        vert->flags = PVR_CMD_VERTEX;
+        mat_trans_single3_nomod(v2->x, v2->y, v2->z, vert->x, vert->y, vert->z);
+        
+        if (use_env_mapping) {
+            float nx = v2->nx, ny = v2->ny, nz = v2->nz;
+            float len = fsqrt(nx*nx + ny*ny + nz*nz);
+            
+            if (len > 0.0001f) {
+                nx /= len;
+                ny /= len;
+                nz /= len;
+            } else {
+                nx = 0.0f;
+                ny = 0.0f;
+                nz = 1.0f;
+            }
+            
+            vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
+            vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
+            vert->argb = 0xE0FFFFFF;
+        } else {
+            vert->u = v2->u;
+            vert->v = v2->v;
+            vert->argb = 0xC0FFFFFF;
+        }
+        
+        pvr_dr_commit(vert);
+        
+        vert = (pvr_vertex_t *)pvr_dr_target(*dr_state);
+        vert->flags = PVR_CMD_VERTEX_EOL;
+        mat_trans_single3_nomod(v3->x, v3->y, v3->z, vert->x, vert->y, vert->z);
+        
+        if (use_env_mapping) {
+            float nx = v3->nx, ny = v3->ny, nz = v3->nz;
+            float len = fsqrt(nx*nx + ny*ny + nz*nz);
+            
+            if (len > 0.0001f) {
+                nx /= len;
+                ny /= len;
+                nz /= len;
+            } else {
+                nx = 0.0f;
+                ny = 0.0f;
+                nz = 1.0f;
+            }
+            
+            vert->u = (nx * envMat[0] + ny * envMat[4] + nz * envMat[8] + 0.5f);
+            vert->v = (nx * envMat[1] + ny * envMat[5] + nz * envMat[9] + 0.5f);
+            vert->argb = 0xE0FFFFFF;
+        } else {
+            vert->u = v3->u;
+            vert->v = v3->v;
+            vert->argb = 0xC0FFFFFF;
+        }
+        
+        pvr_dr_commit(vert);
+        
+        i += 3;
     }
 }
 
@@ -382,6 +370,8 @@ int main(int argc, char **argv) {
     // Print mesh information
     printf("Model loaded with %d meshes\n", gVaseModel->meshCount);
     for (int i = 0; i < gVaseModel->meshCount; i++) {
+        // Environment mapping reads float normals, so expand packed meshes
+        UnpackDMSMesh(&gVaseModel->meshes[i]);
         printf("Mesh %d: textureId = %d, %d vertices, %d indices\n", 
                i, 
                gVaseModel->meshes[i].textureId,
@@ -559,6 +549,8 @@ int main(int argc, char **argv) {
                 free(gVaseModel->meshes[m].animatedVertices);
             if (gVaseModel->meshes[m].indices)
                 free(gVaseModel->meshes[m].indices);
+            if (gVaseModel->meshes[m].stripLengths)
+                free(gVaseModel->meshes[m].stripLengths);
         }
         free(gVaseModel->meshes);
         free(gVaseModel);
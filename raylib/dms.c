@@ -6,8 +6,1006 @@
 #include <GL/gl.h>
 #include "gl_png.h"   
 
+// Reads the v2 per-bone tracks of an animation into a single allocation
+static void ReadDMSTracks(DMSAnimation* anim, FILE* file) {
+    uint32_t keyFloatCount = 0;
+    fread(&keyFloatCount, sizeof(uint32_t), 1, file);
+
+    anim->tracks = (DMSTrack*)calloc(anim->boneCount * DMS_TRACKS_PER_BONE, sizeof(DMSTrack));
+    anim->keyData = (float*)malloc(keyFloatCount * sizeof(float));
+
+    uint32_t used = 0;
+    for (int t = 0; t < anim->boneCount * DMS_TRACKS_PER_BONE; t++) {
+        DMSTrack* track = &anim->tracks[t];
+        uint32_t keyCount = 0;
+        fread(&keyCount, sizeof(uint32_t), 1, file);
+
+        int components = (t % DMS_TRACKS_PER_BONE == DMS_TRACK_ROTATION) ? 4 : 3;
+        uint32_t floats = keyCount * (1 + components);
+        if (used + floats > keyFloatCount) {
+            // Damaged file: skip the track and fall back to the bind pose
+            fseek(file, floats * sizeof(float), SEEK_CUR);
+            continue;
+        }
+
+        track->keyCount = keyCount;
+        track->times = anim->keyData + used;
+        track->values = track->times + keyCount;
+        fread(track->times, sizeof(float), floats, file);
+        used += floats;
+    }
+}
+
+// Reads a quantized clip. Its words stay packed and are decoded while sampling.
+static void ReadDMSQuantizedTracks(DMSAnimation* anim, FILE* file) {
+    uint32_t wordCount = 0;
+    fread(&anim->timeStep, sizeof(float), 1, file);
+    fread(&anim->translationMin, sizeof(Vector3), 1, file);
+    fread(&anim->translationStep, sizeof(Vector3), 1, file);
+    fread(&anim->scaleMin, sizeof(Vector3), 1, file);
+    fread(&anim->scaleStep, sizeof(Vector3), 1, file);
+    fread(&wordCount, sizeof(uint32_t), 1, file);
+
+    anim->keyWords = (uint16_t*)malloc(wordCount * sizeof(uint16_t));
+    fread(anim->keyWords, sizeof(uint16_t), wordCount, file);
+    anim->tracks = (DMSTrack*)calloc(anim->boneCount * DMS_TRACKS_PER_BONE, sizeof(DMSTrack));
+
+    // Per track: keyCount, ticks[keyCount], 3 words per key
+    uint32_t used = 0;
+    for (int t = 0; t < anim->boneCount * DMS_TRACKS_PER_BONE && used < wordCount; t++) {
+        DMSTrack* track = &anim->tracks[t];
+        uint32_t keyCount = anim->keyWords[used++];
+        if (used + keyCount * 4 > wordCount) break;   // Damaged file
+
+        track->keyCount = keyCount;
+        track->ticks = anim->keyWords + used;
+        used += keyCount * 4;
+    }
+}
+
+// Converts v1 whole-frame poses into tracks. Every track gets a closing key at
+// `duration` holding frame 0, which keeps the old last-to-first frame blend.
+static void BuildDMSTracksFromFrames(DMSAnimation* anim, FILE* file) {
+    int frameCount = anim->frameCount;
+    int boneCount = anim->boneCount;
+    size_t totalPoses = frameCount * boneCount;
+    DMSTransform* poses = (DMSTransform*)calloc(totalPoses, sizeof(DMSTransform));
+    fread(poses, sizeof(DMSTransform), totalPoses, file);
+
+    anim->tracks = (DMSTrack*)calloc(boneCount * DMS_TRACKS_PER_BONE, sizeof(DMSTrack));
+    if (frameCount < 1) {
+        free(poses);
+        return;
+    }
+
+    // Key times are shared by all tracks; values follow per bone
+    int keyCount = frameCount + 1;
+    anim->keyData = (float*)malloc((keyCount + (size_t)boneCount * keyCount * 10) * sizeof(float));
+    float* times = anim->keyData;
+    for (int k = 0; k < keyCount; k++) {
+        times[k] = anim->duration * (float)k / (float)frameCount;
+    }
+
+    float* values = times + keyCount;
+    for (int t = 0; t < boneCount * DMS_TRACKS_PER_BONE; t++) {
+        DMSTrack* track = &anim->tracks[t];
+        int bone = t / DMS_TRACKS_PER_BONE;
+        int channel = t % DMS_TRACKS_PER_BONE;
+        int components = (channel == DMS_TRACK_ROTATION) ? 4 : 3;
+
+        track->keyCount = keyCount;
+        track->times = times;
+        track->values = values;
+        for (int k = 0; k < keyCount; k++) {
+            const DMSTransform* pose = &poses[(k % frameCount) * boneCount + bone];
+            const float* source = (channel == DMS_TRACK_TRANSLATION) ? &pose->translation.x :
+                                  (channel == DMS_TRACK_ROTATION) ? &pose->rotation.x : &pose->scale.x;
+            memcpy(values + k * components, source, components * sizeof(float));
+        }
+        values += keyCount * components;
+    }
+
+    free(poses);
+}
+
+// Expands packed vertices into float vertices. GL draws from float client
+// arrays, so packing only shrinks the file for this renderer.
+static void UnpackDMSVertices(const DMSPackedVertex* packed, int vertexCount, Vector3 positionOffset,
+                              Vector3 positionScale, const float* uvOffset, const float* uvScale,
+                              DMSVertex* vertices) {
+    for (int i = 0; i < vertexCount; i++) {
+        const DMSPackedVertex* p = &packed[i];
+        DMSVertex* v = &vertices[i];
+        v->x = positionOffset.x + p->x * positionScale.x;
+        v->y = positionOffset.y + p->y * positionScale.y;
+        v->z = positionOffset.z + p->z * positionScale.z;
+        v->nx = p->nx;
+        v->ny = p->ny;
+        v->nz = p->nz;
+        v->u = uvOffset[0] + p->u * uvScale[0];
+        v->v = uvOffset[1] + p->v * uvScale[1];
+        v->boneId = p->boneId;
+        v->boneWeight = p->boneWeight * (1.0f / 65535.0f);
+    }
+}
+
+// Reads a v4 packed mesh (position and UV ranges, then 16-byte vertices)
+// into float vertices
+static void ReadDMSPackedVertices(DMSVertex* vertices, int vertexCount, FILE* file) {
+    Vector3 positionOffset, positionScale;
+    float uvOffset[2], uvScale[2];
+    fread(&positionOffset, sizeof(Vector3), 1, file);
+    fread(&positionScale, sizeof(Vector3), 1, file);
+    fread(uvOffset, sizeof(float), 2, file);
+    fread(uvScale, sizeof(float), 2, file);
+
+    DMSPackedVertex* packed = (DMSPackedVertex*)malloc(vertexCount * sizeof(DMSPackedVertex));
+    fread(packed, sizeof(DMSPackedVertex), vertexCount, file);
+    UnpackDMSVertices(packed, vertexCount, positionOffset, positionScale, uvOffset, uvScale, vertices);
+    free(packed);
+}
+
+static void StoreDMSIndex(DMSMesh* mesh, int i, uint32_t index) {
+    if (mesh->indexSize == sizeof(uint16_t)) {
+        ((uint16_t*)mesh->indices)[i] = (uint16_t)index;
+    } else {
+        ((uint32_t*)mesh->indices)[i] = index;
+    }
+}
+
+// Reads a mesh's index section into its strip table and 16- or 32-bit
+// indices. Before v5 strips were flagged in-band on 32-bit indices (high
+// bit plus a 7-bit strip ID), so older files are split into a table here.
+static void ReadDMSIndices(DMSMesh* mesh, uint32_t version, FILE* file) {
+    if (mesh->indexCount < 0) {
+        printf("Invalid index count: %d\n", mesh->indexCount);
+        mesh->indexCount = 0;
+    }
+
+    if (version >= 5) {
+        uint32_t stripCount = 0, indexSize = 0;
+        fread(&stripCount, sizeof(uint32_t), 1, file);
+        fread(&indexSize, sizeof(uint32_t), 1, file);
+        mesh->stripCount = stripCount;
+        mesh->indexSize = indexSize;
+        mesh->stripLengths = (uint32_t*)malloc(stripCount * sizeof(uint32_t));
+        fread(mesh->stripLengths, sizeof(uint32_t), stripCount, file);
+        mesh->indices = malloc((size_t)mesh->indexCount * indexSize);
+        fread(mesh->indices, indexSize, mesh->indexCount, file);
+        if ((mesh->indexCount * indexSize) & 3) fseek(file, 2, SEEK_CUR);  // Alignment padding
+    } else {
+        uint32_t* raw = (uint32_t*)malloc((size_t)mesh->indexCount * sizeof(uint32_t));
+        fread(raw, sizeof(uint32_t), mesh->indexCount, file);
+
+        // A strip is a run of flagged indices sharing one strip ID
+        mesh->stripCount = 0;
+        for (int i = 0; i < mesh->indexCount; i++) {
+            if ((raw[i] & 0x80000000) && (i == 0 || ((raw[i - 1] ^ raw[i]) & 0xFF000000))) mesh->stripCount++;
+        }
+        mesh->stripLengths = (uint32_t*)calloc(mesh->stripCount, sizeof(uint32_t));
+        mesh->indexSize = (mesh->vertexCount <= 65536) ? sizeof(uint16_t) : sizeof(uint32_t);
+        mesh->indices = malloc((size_t)mesh->indexCount * mesh->indexSize);
+
+        // Strip indices first, then the unflagged triangle list
+        int strip = -1, count = 0;
+        for (int i = 0; i < mesh->indexCount; i++) {
+            if (!(raw[i] & 0x80000000)) continue;
+            if (i == 0 || ((raw[i - 1] ^ raw[i]) & 0xFF000000)) strip++;
+            mesh->stripLengths[strip]++;
+            StoreDMSIndex(mesh, count++, raw[i] & 0x00FFFFFF);
+        }
+        for (int i = 0; i < mesh->indexCount; i++) {
+            if (!(raw[i] & 0x80000000)) StoreDMSIndex(mesh, count++, raw[i]);
+        }
+        free(raw);
+    }
+
+    mesh->stripIndexCount = 0;
+    mesh->triangleCount = 0;
+    for (int s = 0; s < mesh->stripCount; s++) {
+        mesh->stripIndexCount += mesh->stripLengths[s];
+        if (mesh->stripLengths[s] >= 3) mesh->triangleCount += mesh->stripLengths[s] - 2;
+    }
+    if (mesh->stripIndexCount > mesh->indexCount) {
+        printf("Invalid strip table: %d strip indices, %d indices\n", mesh->stripIndexCount, mesh->indexCount);
+        mesh->stripCount = 0;
+        mesh->stripIndexCount = 0;
+        mesh->triangleCount = 0;
+    }
+    mesh->triangleCount += (mesh->indexCount - mesh->stripIndexCount) / 3;
+}
+
+// Reads the start of a clip record: name, bone and frame counts, duration
+static void ReadDMSAnimationHeader(DMSAnimation* anim, FILE* file) {
+    fread(anim->name, sizeof(char), 32, file);
+    fread(&anim->boneCount, sizeof(int), 1, file);
+    fread(&anim->frameCount, sizeof(int), 1, file);
+    fread(&anim->duration, sizeof(float), 1, file);
+}
+
+// Reads one clip: the v1-v5 animation record, which v6 ANIM chunks hold as is
+static void ReadDMSAnimation(DMSAnimation* anim, uint32_t version, FILE* file) {
+    ReadDMSAnimationHeader(anim, file);
+
+    uint32_t encoding = DMS_ANIM_ENCODING_FLOAT;
+    if (version >= 3) fread(&encoding, sizeof(uint32_t), 1, file);
+
+    if (encoding == DMS_ANIM_ENCODING_QUANTIZED) {
+        ReadDMSQuantizedTracks(anim, file);
+    } else if (version >= 2) {
+        ReadDMSTracks(anim, file);
+    } else {
+        BuildDMSTracksFromFrames(anim, file);
+    }
+}
+
+// Counts each bone's ancestors for the bone LOD. Walks the parent chain,
+// since files from older converters do not have to list parents first.
+static void SetDMSBoneDepths(DMSSkeleton* skeleton) {
+    for (int i = 0; i < skeleton->boneCount; i++) {
+        if (skeleton->bones[i].parent >= i) {
+            printf("Bone %d comes before its parent; convert the model again for correct poses\n", i);
+        }
+        int depth = 0;
+        int parent = skeleton->bones[i].parent;
+        while (parent >= 0 && parent < skeleton->boneCount && depth < skeleton->boneCount) {
+            parent = skeleton->bones[parent].parent;
+            depth++;
+        }
+        skeleton->bones[i].depth = depth;
+    }
+}
+
+static void ReadDMSBones(DMSSkeleton* skeleton, FILE* file) {
+    for (int i = 0; i < skeleton->boneCount; i++) {
+        DMSBone* bone = &skeleton->bones[i];
+        fread(bone->name, sizeof(char), 64, file);
+        fread(&bone->parent, sizeof(int), 1, file);
+        fread(&bone->bindPose, sizeof(DMSTransform), 1, file);
+        fread(&bone->inverseBindMatrix, sizeof(Matrix), 1, file);
+    }
+    SetDMSBoneDepths(skeleton);
+}
+
+// Grows a model's bounding sphere to take in another sphere
+static void MergeDMSBounds(DMSModel* model, Vector3 center, float radius) {
+    Vector3 offset = { center.x - model->boundsCenter.x, center.y - model->boundsCenter.y,
+                       center.z - model->boundsCenter.z };
+    float distance = sqrtf(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+    if (model->boundsRadius <= 0.0f || distance + model->boundsRadius <= radius) {
+        model->boundsCenter = center;
+        model->boundsRadius = radius;
+        return;
+    }
+    if (distance + radius <= model->boundsRadius) return;
+
+    float grownRadius = (distance + radius + model->boundsRadius) * 0.5f;
+    float shift = (grownRadius - model->boundsRadius) / distance;
+    model->boundsCenter.x += offset.x * shift;
+    model->boundsCenter.y += offset.y * shift;
+    model->boundsCenter.z += offset.z * shift;
+    model->boundsRadius = grownRadius;
+}
+
+// Files before v6 have no bounds chunk; measure the sphere around the mean
+// of the vertices the way the converter does
+static void MergeDMSMeshBounds(DMSModel* model, const DMSMesh* mesh) {
+    if (mesh->vertexCount == 0) return;
+
+    Vector3 center = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        center.x += mesh->vertices[i].x;
+        center.y += mesh->vertices[i].y;
+        center.z += mesh->vertices[i].z;
+    }
+    center.x /= mesh->vertexCount;
+    center.y /= mesh->vertexCount;
+    center.z /= mesh->vertexCount;
+
+    float radiusSq = 0.0f;
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        float dx = mesh->vertices[i].x - center.x;
+        float dy = mesh->vertices[i].y - center.y;
+        float dz = mesh->vertices[i].z - center.z;
+        float distanceSq = dx * dx + dy * dy + dz * dz;
+        if (distanceSq > radiusSq) radiusSq = distanceSq;
+    }
+    MergeDMSBounds(model, center, sqrtf(radiusSq));
+}
+
+// Reads one mesh record: counts, texture ID, vertices and index section
+static void ReadDMSMesh(DMSMesh* mesh, int animated, uint32_t version, FILE* file) {
+    fread(&mesh->vertexCount, sizeof(uint32_t), 1, file);
+    fread(&mesh->indexCount, sizeof(uint32_t), 1, file);
+    fread(&mesh->textureId, sizeof(int), 1, file);
+
+    uint32_t vertexFormat = DMS_VERTEX_FORMAT_FLOAT;
+    if (version >= 4) fread(&vertexFormat, sizeof(uint32_t), 1, file);
+    mesh->boneSpace = (vertexFormat & DMS_VERTEX_BONE_SPACE) != 0;
+    int rigid = (vertexFormat & DMS_VERTEX_RIGID) != 0;
+    vertexFormat &= ~(DMS_VERTEX_BONE_SPACE | DMS_VERTEX_RIGID);
+
+    // Allocate and load vertices
+    if (mesh->vertexCount > 0) {
+        mesh->vertices = (DMSVertex*)memalign(32, mesh->vertexCount * sizeof(DMSVertex));
+        memset(mesh->vertices, 0, mesh->vertexCount * sizeof(DMSVertex));
+        
+        if (vertexFormat == DMS_VERTEX_FORMAT_PACKED) {
+            ReadDMSPackedVertices(mesh->vertices, mesh->vertexCount, file);
+        } else if (animated) {
+            // Animated model - read full vertex data; instances skin copies of it
+            fread(mesh->vertices, sizeof(DMSVertex), mesh->vertexCount, file);
+        } else {
+            // Static model - read simplified vertex data
+            typedef struct {
+                float x, y, z;        // Position
+                float nx, ny, nz;     // Normal
+                float u, v;           // Texture coordinates
+            } StaticVertex;
+
+            StaticVertex* tempVerts = (StaticVertex*)malloc(mesh->vertexCount * sizeof(StaticVertex));
+            fread(tempVerts, sizeof(StaticVertex), mesh->vertexCount, file);
+            
+            // Convert to DMSVertex format
+            for (int i = 0; i < mesh->vertexCount; i++) {
+                mesh->vertices[i].x = tempVerts[i].x;
+                mesh->vertices[i].y = tempVerts[i].y;
+                mesh->vertices[i].z = tempVerts[i].z;
+                // Written as floats, but already scaled by 127 like DMSVertex normals
+                mesh->vertices[i].nx = (int8_t)tempVerts[i].nx;
+                mesh->vertices[i].ny = (int8_t)tempVerts[i].ny;
+                mesh->vertices[i].nz = (int8_t)tempVerts[i].nz;
+                mesh->vertices[i].u = tempVerts[i].u;
+                mesh->vertices[i].v = tempVerts[i].v;
+                mesh->vertices[i].boneId = 0;
+                mesh->vertices[i].boneWeight = 0.0f;
+            }
+            
+            free(tempVerts);
+        }
+    } else if (vertexFormat == DMS_VERTEX_FORMAT_PACKED) {
+        ReadDMSPackedVertices(NULL, 0, file);  // Ranges only
+    }
+    mesh->rigidBone = (rigid && mesh->vertexCount > 0) ? mesh->vertices[0].boneId : -1;
+
+    // Load the strip table and indices
+    ReadDMSIndices(mesh, version, file);
+}
+
+// v1-v5 files: bones, every clip and every mesh in sequence
+static void ReadDMSSections(DMSModel* model, uint32_t version, FILE* file) {
+    if (model->skeleton) {
+        ReadDMSBones(model->skeleton, file);
+    }
+
+    uint32_t animCount = 0;
+    fread(&animCount, sizeof(uint32_t), 1, file);
+    if (model->skeleton && animCount > 0) {
+        model->skeleton->animCount = animCount;
+        model->skeleton->animations = (DMSAnimation*)calloc(animCount, sizeof(DMSAnimation));
+        for (uint32_t i = 0; i < animCount; i++) {
+            ReadDMSAnimation(&model->skeleton->animations[i], version, file);
+        }
+    }
+
+    for (int m = 0; m < model->meshCount; m++) {
+        ReadDMSMesh(&model->meshes[m], model->skeleton != NULL, version, file);
+        MergeDMSMeshBounds(model, &model->meshes[m]);
+    }
+}
+
+// v6 files: seeks to each chunk in `sections` through the chunk table and
+// skips the rest, including chunk types this loader does not know. Meshes of
+// a skinned file keep their skinned layout even when the skeleton is left out.
+static void ReadDMSChunks(DMSModel* model, uint32_t version, uint32_t boneCount, uint32_t sections, FILE* file) {
+    uint32_t chunkCount = 0;
+    fread(&chunkCount, sizeof(uint32_t), 1, file);
+    DMSChunk* chunks = (DMSChunk*)malloc(chunkCount * sizeof(DMSChunk));
+    fread(chunks, sizeof(DMSChunk), chunkCount, file);
+
+    int animCount = 0;
+    for (uint32_t c = 0; c < chunkCount; c++) {
+        if (chunks[c].type == DMS_CHUNK_ANIMATION) animCount++;
+    }
+    if (model->skeleton && (sections & DMS_LOAD_ANIMATIONS) && animCount > 0) {
+        model->skeleton->animCount = animCount;
+        model->skeleton->animations = (DMSAnimation*)calloc(animCount, sizeof(DMSAnimation));
+    }
+
+    int anim = 0, mesh = 0;
+    for (uint32_t c = 0; c < chunkCount; c++) {
+        const DMSChunk* chunk = &chunks[c];
+        switch (chunk->type) {
+        case DMS_CHUNK_SKELETON:
+            if (!model->skeleton) break;
+            fseek(file, chunk->offset, SEEK_SET);
+            ReadDMSBones(model->skeleton, file);
+            break;
+        case DMS_CHUNK_ANIMATION:
+            if (!model->skeleton || !model->skeleton->animations) break;
+            fseek(file, chunk->offset, SEEK_SET);
+            if (sections & DMS_LOAD_ALL_CLIPS) {
+                ReadDMSAnimation(&model->skeleton->animations[anim++], version, file);
+            } else {
+                // Keys are read on first use; see AcquireDMSClip()
+                ReadDMSAnimationHeader(&model->skeleton->animations[anim], file);
+                model->skeleton->animations[anim++].fileOffset = chunk->offset;
+            }
+            break;
+        case DMS_CHUNK_MATERIALS:
+            fseek(file, chunk->offset, SEEK_SET);
+            fread(&model->textureCount, sizeof(uint32_t), 1, file);
+            break;
+        case DMS_CHUNK_BOUNDS:
+            fseek(file, chunk->offset, SEEK_SET);
+            for (uint32_t m = 0; m < chunk->size / sizeof(DMSMeshBounds); m++) {
+                DMSMeshBounds bounds;
+                fread(&bounds, sizeof(DMSMeshBounds), 1, file);
+                MergeDMSBounds(model, bounds.center, bounds.radius);
+            }
+            break;
+        case DMS_CHUNK_MESH:
+            if (mesh >= model->meshCount) break;
+            fseek(file, chunk->offset, SEEK_SET);
+            ReadDMSMesh(&model->meshes[mesh++], boneCount > 0, version, file);
+            break;
+        default:
+            break;
+        }
+    }
+    free(chunks);
+}
+
+// Clip cache. Lazily loaded clips of every model share one RAM budget and
+// are dropped least recently used first; clips an instance plays stay.
+static size_t dmsClipBudget = 0;            // 0 = no limit
+static size_t dmsClipUsage = 0;
+static uint32_t dmsClipClock = 0;
+static DMSSkeleton** dmsClipOwners = NULL;  // Skeletons with lazy clips
+static int dmsClipOwnerCount = 0;
+
+static void AddDMSClipOwner(DMSSkeleton* skeleton) {
+    dmsClipOwners = (DMSSkeleton**)realloc(dmsClipOwners, (dmsClipOwnerCount + 1) * sizeof(DMSSkeleton*));
+    dmsClipOwners[dmsClipOwnerCount++] = skeleton;
+}
+
+static void RemoveDMSClipOwner(DMSSkeleton* skeleton) {
+    for (int i = 0; i < dmsClipOwnerCount; i++) {
+        if (dmsClipOwners[i] == skeleton) {
+            dmsClipOwners[i] = dmsClipOwners[--dmsClipOwnerCount];
+            return;
+        }
+    }
+}
+
+// Heap bytes behind a clip's tracks
+static uint32_t GetDMSClipBytes(const DMSAnimation* anim) {
+    int trackCount = anim->boneCount * DMS_TRACKS_PER_BONE;
+    uint32_t bytes = trackCount * sizeof(DMSTrack);
+    for (int t = 0; t < trackCount; t++) {
+        int keyCount = anim->tracks[t].keyCount;
+        if (anim->keyWords) {
+            bytes += sizeof(uint16_t) * (1 + keyCount * 4);
+        } else {
+            int components = (t % DMS_TRACKS_PER_BONE == DMS_TRACK_ROTATION) ? 4 : 3;
+            bytes += sizeof(float) * keyCount * (1 + components);
+        }
+    }
+    return bytes;
+}
+
+// Frees a clip's keys; lazy clips keep their header and load again on use
+static void ReleaseDMSClip(DMSAnimation* anim) {
+    if (anim->tracks) free(anim->tracks);
+    if (anim->keyData) free(anim->keyData);
+    if (anim->keyWords) free(anim->keyWords);
+    anim->tracks = NULL;
+    anim->keyData = NULL;
+    anim->keyWords = NULL;
+    dmsClipUsage -= anim->residentBytes;
+    anim->residentBytes = 0;
+}
+
+// Drops least recently used clips until the cache fits its budget. Clips in
+// use and `keep` stay, so usage can remain over a budget that is too small.
+static void TrimDMSClipCache(const DMSAnimation* keep) {
+    while (dmsClipBudget > 0 && dmsClipUsage > dmsClipBudget) {
+        DMSAnimation* oldest = NULL;
+        for (int s = 0; s < dmsClipOwnerCount; s++) {
+            DMSSkeleton* skeleton = dmsClipOwners[s];
+            for (int i = 0; i < skeleton->animCount; i++) {
+                DMSAnimation* anim = &skeleton->animations[i];
+                if (anim == keep || anim->users > 0 || anim->residentBytes == 0) continue;
+                if (!oldest || anim->lastUse < oldest->lastUse) oldest = anim;
+            }
+        }
+        if (!oldest) return;
+        ReleaseDMSClip(oldest);
+    }
+}
+
+// Marks a clip used without reading it. The frame loop goes through here, so
+// it never blocks on a read; clips are read when they start playing.
+static DMSAnimation* TouchDMSClip(DMSSkeleton* skeleton, int index) {
+    DMSAnimation* anim = &skeleton->animations[index];
+    anim->lastUse = ++dmsClipClock;
+    return anim;
+}
+
+// Makes a clip resident, reading its keys from the model's file if needed,
+// and marks it used. A clip that failed to load is not tried again.
+static DMSAnimation* AcquireDMSClip(DMSSkeleton* skeleton, int index) {
+    DMSAnimation* anim = TouchDMSClip(skeleton, index);
+    if (anim->tracks || anim->loadFailed || !skeleton->clipSource) return anim;
+
+    FILE* file = fopen(skeleton->clipSource, "rb");
+    if (!file) {
+        printf("Failed to open %s for clip %s\n", skeleton->clipSource, anim->name);
+        anim->loadFailed = 1;
+        return anim;
+    }
+    fseek(file, anim->fileOffset, SEEK_SET);
+    ReadDMSAnimation(anim, skeleton->clipVersion, file);
+    fclose(file);
+    if (!anim->tracks) {
+        printf("Failed to read clip %s from %s\n", anim->name, skeleton->clipSource);
+        anim->loadFailed = 1;
+        return anim;
+    }
+
+    anim->residentBytes = GetDMSClipBytes(anim);
+    dmsClipUsage += anim->residentBytes;
+    TrimDMSClipCache(anim);
+    return anim;
+}
+
+void SetDMSClipCacheBudget(size_t bytes) {
+    dmsClipBudget = bytes;
+    TrimDMSClipCache(NULL);
+}
+
+size_t GetDMSClipCacheUsage(void) {
+    return dmsClipUsage;
+}
+
+// Animation cache. Instances in the same step of the same clip share one
+// result; results stay allocated for reuse and ones without users are
+// recycled least recently used first.
+static float dmsResultStep = 0.0f;          // 0 = off
+static uint32_t dmsResultClock = 0;
+static DMSAnimationResult** dmsResults = NULL;
+static DMSAnimationCacheStats dmsResultStats;
+
+// Bytes of a result block: the result, its bone palette, the per-mesh
+// pointer table and the skinning buffers of meshes that are not rigid
+static size_t LayoutDMSAnimationResult(const DMSModel* model, size_t* tableOffset, size_t* vertexOffset) {
+    size_t size = (sizeof(DMSAnimationResult) + 31) & ~(size_t)31;
+    size += model->skeleton->boneCount * sizeof(Matrix);
+    *tableOffset = size;
+    size += (model->meshCount * sizeof(DMSVertex*) + 31) & ~(size_t)31;
+    *vertexOffset = size;
+    for (int m = 0; m < model->meshCount; m++) {
+        if (model->meshes[m].rigidBone < 0) size += model->meshes[m].vertexCount * sizeof(DMSVertex);
+    }
+    return size;
+}
+
+static DMSAnimationResult* CreateDMSAnimationResult(const DMSModel* model) {
+    size_t tableOffset, vertexOffset;
+    size_t size = LayoutDMSAnimationResult(model, &tableOffset, &vertexOffset);
+    uint8_t* block = (uint8_t*)memalign(32, size);
+    memset(block, 0, sizeof(DMSAnimationResult));
+
+    DMSAnimationResult* result = (DMSAnimationResult*)block;
+    result->model = model;
+    result->worldPose = (Matrix*)(block + ((sizeof(DMSAnimationResult) + 31) & ~(size_t)31));
+    result->skinnedVertices = (DMSVertex**)(block + tableOffset);
+    DMSVertex* vertices = (DMSVertex*)(block + vertexOffset);
+    for (int m = 0; m < model->meshCount; m++) {
+        // Rigid meshes are drawn from their bind pose
+        if (model->meshes[m].rigidBone >= 0) {
+            result->skinnedVertices[m] = NULL;
+            continue;
+        }
+        // Skinning only writes weighted positions; the rest is copied here once
+        result->skinnedVertices[m] = vertices;
+        memcpy(vertices, model->meshes[m].vertices, model->meshes[m].vertexCount * sizeof(DMSVertex));
+        vertices += model->meshes[m].vertexCount;
+    }
+
+    dmsResults = (DMSAnimationResult**)realloc(dmsResults, (dmsResultStats.resultCount + 1) * sizeof(DMSAnimationResult*));
+    dmsResults[dmsResultStats.resultCount++] = result;
+    dmsResultStats.resultBytes += size;
+    return result;
+}
+
+// Frees the results of a model; its instances are gone by now
+static void FreeDMSAnimationResults(const DMSModel* model) {
+    for (int i = 0; i < dmsResultStats.resultCount; ) {
+        DMSAnimationResult* result = dmsResults[i];
+        if (result->model != model) {
+            i++;
+            continue;
+        }
+        size_t tableOffset, vertexOffset;
+        dmsResultStats.resultBytes -= LayoutDMSAnimationResult(model, &tableOffset, &vertexOffset);
+        dmsResults[i] = dmsResults[--dmsResultStats.resultCount];
+        free(result);
+    }
+}
+
+// Animation LOD levels, from the largest on screen down
+static DMSAnimationLOD dmsLODs[DMS_MAX_ANIMATION_LODS] = {
+    { 0.25f, 1, -1 },
+    { 0.10f, 2, -1 },
+    { 0.04f, 4, 4 },
+    { 0.0f, 8, 2 },
+    { 0.0f, 8, 2 },
+    { 0.0f, 8, 2 },
+    { 0.0f, 8, 2 },
+    { 0.0f, 8, 2 },
+};
+static int dmsLODCount = 4;
+
+// Bones deeper than this hold their bind pose; -1 for none
+static int GetDMSInstanceBoneDepth(const DMSInstance* instance) {
+    return instance->lod.level >= 0 ? dmsLODs[instance->lod.level].maxBoneDepth : -1;
+}
+
+static void ReleaseDMSAnimationResult(DMSInstance* instance) {
+    if (!instance->result) return;
+    instance->result->users--;
+    instance->result = NULL;
+}
+
+// Points an instance at the result of its clip step. Returns 1 when the
+// result is already evaluated; otherwise the instance gets a fresh or
+// recycled result to evaluate into and 0 is returned.
+static int ShareDMSAnimationResult(DMSInstance* instance, int step) {
+    DMSAnimationResult* result = instance->result;
+    int maxBoneDepth = GetDMSInstanceBoneDepth(instance);
+    if (!result || result->anim != instance->layers[0].anim || result->step != step ||
+        result->maxBoneDepth != maxBoneDepth) {
+        ReleaseDMSAnimationResult(instance);
+
+        DMSAnimationResult* unused = NULL;
+        result = NULL;
+        for (int i = 0; i < dmsResultStats.resultCount; i++) {
+            DMSAnimationResult* candidate = dmsResults[i];
+            if (candidate->model != instance->model) continue;
+            if (candidate->anim == instance->layers[0].anim && candidate->step == step &&
+                candidate->maxBoneDepth == maxBoneDepth) {
+                result = candidate;
+                break;
+            }
+            if (candidate->users == 0 && (!unused || candidate->lastUse < unused->lastUse)) unused = candidate;
+        }
+
+        int evaluated = result != NULL;
+        if (!result) {
+            result = unused ? unused : CreateDMSAnimationResult(instance->model);
+            result->anim = instance->layers[0].anim;
+            result->step = step;
+            result->maxBoneDepth = maxBoneDepth;
+            result->skinned = 0;
+        }
+        result->users++;
+        instance->result = result;
+
+        if (!evaluated) {
+            result->lastUse = ++dmsResultClock;
+            dmsResultStats.poseMisses++;
+            return 0;
+        }
+    }
+
+    result->lastUse = ++dmsResultClock;
+    dmsResultStats.poseHits++;
+    return 1;
+}
+
+void SetDMSAnimationCacheStep(float seconds) {
+    dmsResultStep = seconds > 0.0f ? seconds : 0.0f;
+
+    // Steps of the old length no longer match any instance
+    for (int i = 0; i < dmsResultStats.resultCount; i++) {
+        dmsResults[i]->anim = -1;
+    }
+}
+
+DMSAnimationCacheStats GetDMSAnimationCacheStats(void) {
+    return dmsResultStats;
+}
+
+void ResetDMSAnimationCacheStats(void) {
+    dmsResultStats.poseHits = 0;
+    dmsResultStats.poseMisses = 0;
+    dmsResultStats.skinningHits = 0;
+    dmsResultStats.skinningMisses = 0;
+}
+
+// Bump allocation within a single-allocation block (image models,
+// instances). Every array starts on a 32-byte boundary; with a base of 0 it
+// only measures.
+static void* TakeDMSBlockSpace(uintptr_t* cursor, size_t size) {
+    uintptr_t p = (*cursor + 31) & ~(uintptr_t)31;
+    *cursor = p + size;
+    return (void*)p;
+}
+
+// Runtime structs of an image model, carved from one block
+typedef struct {
+    DMSModel* model;
+    DMSMesh* meshes;
+    DMSSkeleton* skeleton;
+    DMSBone* bones;
+    DMSAnimation* animations;
+    DMSTrack* tracks;
+    DMSVertex* vertices;    // Unpacked vertices
+} DMSImageParts;
+
+static size_t LayoutDMSImageModel(const DMSImageHeader* header, uintptr_t base, DMSImageParts* parts) {
+    uintptr_t cursor = base;
+    parts->model = (DMSModel*)TakeDMSBlockSpace(&cursor, sizeof(DMSModel));
+    parts->meshes = (DMSMesh*)TakeDMSBlockSpace(&cursor, header->meshCount * sizeof(DMSMesh));
+    parts->skeleton = (DMSSkeleton*)TakeDMSBlockSpace(&cursor, sizeof(DMSSkeleton));
+    parts->bones = (DMSBone*)TakeDMSBlockSpace(&cursor, header->boneCount * sizeof(DMSBone));
+    parts->animations = (DMSAnimation*)TakeDMSBlockSpace(&cursor, header->animCount * sizeof(DMSAnimation));
+    parts->tracks = (DMSTrack*)TakeDMSBlockSpace(&cursor, header->trackCount * sizeof(DMSTrack));
+    parts->vertices = (DMSVertex*)TakeDMSBlockSpace(&cursor, header->packedVertexCount * sizeof(DMSVertex));
+    return ((cursor + 31) & ~(uintptr_t)31) - base;
+}
+
+// Points the clip's tracks into its data in the image
+static void LinkDMSImageTracks(DMSAnimation* anim, const DMSImageClip* clip, const uint8_t* image) {
+    uint32_t used = 0;
+    if (clip->encoding == DMS_ANIM_ENCODING_QUANTIZED) {
+        uint16_t* words = (uint16_t*)(image + clip->data);
+        anim->keyWords = words;     // Marks the clip quantized; never freed
+        for (int t = 0; t < anim->boneCount * DMS_TRACKS_PER_BONE && used < clip->dataCount; t++) {
+            uint32_t keyCount = words[used++];
+            if (keyCount > (clip->dataCount - used) / 4) break;   // Damaged image
+            anim->tracks[t].keyCount = keyCount;
+            anim->tracks[t].ticks = words + used;
+            used += keyCount * 4;
+        }
+        return;
+    }
+
+    uint32_t* words = (uint32_t*)(image + clip->data);
+    for (int t = 0; t < anim->boneCount * DMS_TRACKS_PER_BONE && used < clip->dataCount; t++) {
+        uint32_t keyCount = words[used++];
+        int components = (t % DMS_TRACKS_PER_BONE == DMS_TRACK_ROTATION) ? 4 : 3;
+        if (keyCount > (clip->dataCount - used) / (1 + components)) break;   // Damaged image
+        anim->tracks[t].keyCount = keyCount;
+        anim->tracks[t].times = (float*)(words + used);
+        anim->tracks[t].values = anim->tracks[t].times + keyCount;
+        used += keyCount * (1 + components);
+    }
+}
+
+// True when `count` items of `itemSize` bytes at `offset` lie inside an image
+// of `size` bytes
+static int DMSImageSpanFits(uint32_t size, uint32_t offset, uint32_t count, uint32_t itemSize) {
+    return offset <= size && (uint64_t)count * itemSize <= size - offset;
+}
+
+// Checks the header against the `available` bytes before anything is
+// allocated for it: the tables have to fit the image, and the image has to
+// account for the tracks and vertices LayoutDMSImageModel() makes room for
+static int CheckDMSImageHeader(const DMSImageHeader* header, size_t available) {
+    if (header->size < sizeof(DMSImageHeader) || header->size > available) return 0;
+    uint64_t tables = sizeof(DMSImageHeader) + (uint64_t)header->meshCount * sizeof(DMSImageMesh) +
+                      (uint64_t)header->boneCount * sizeof(DMSImageBone) +
+                      (uint64_t)header->animCount * sizeof(DMSImageClip);
+    return tables <= header->size &&
+           (uint64_t)header->trackCount * sizeof(uint16_t) <= header->size &&
+           (uint64_t)header->packedVertexCount * sizeof(DMSPackedVertex) <= header->size;
+}
+
+// Checks every offset and length in the tables against the image, so
+// BuildDMSImageModel() only touches bytes inside it
+static int CheckDMSImageRecords(const uint8_t* image) {
+    const DMSImageHeader* header = (const DMSImageHeader*)image;
+    const DMSImageMesh* meshRecords = (const DMSImageMesh*)(header + 1);
+    const DMSImageBone* boneRecords = (const DMSImageBone*)(meshRecords + header->meshCount);
+    const DMSImageClip* clipRecords = (const DMSImageClip*)(boneRecords + header->boneCount);
+
+    uint64_t packedVertexCount = 0;
+    for (uint32_t m = 0; m < header->meshCount; m++) {
+        const DMSImageMesh* record = &meshRecords[m];
+        int packed = (record->vertexFormat & ~(DMS_VERTEX_BONE_SPACE | DMS_VERTEX_RIGID)) == DMS_VERTEX_FORMAT_PACKED;
+        uint32_t vertexSize = packed ? sizeof(DMSPackedVertex) : sizeof(DMSVertex);
+        if ((record->indexSize != 2 && record->indexSize != 4) ||
+            record->vertices % 4 || record->stripLengths % 4 || record->indices % record->indexSize ||
+            !DMSImageSpanFits(header->size, record->vertices, record->vertexCount, vertexSize) ||
+            !DMSImageSpanFits(header->size, record->stripLengths, record->stripCount, sizeof(uint32_t)) ||
+            !DMSImageSpanFits(header->size, record->indices, record->indexCount, record->indexSize)) {
+            return 0;
+        }
+        if (packed) packedVertexCount += record->vertexCount;
+    }
+    if (packedVertexCount > header->packedVertexCount) return 0;
+
+    for (uint32_t i = 0; i < header->boneCount; i++) {
+        if (boneRecords[i].parent < -1 || boneRecords[i].parent >= (int32_t)header->boneCount) return 0;
+    }
+
+    uint64_t trackCount = 0;
+    for (uint32_t i = 0; i < header->animCount; i++) {
+        const DMSImageClip* clip = &clipRecords[i];
+        uint32_t wordSize = clip->encoding == DMS_ANIM_ENCODING_QUANTIZED ? sizeof(uint16_t) : sizeof(uint32_t);
+        if (clip->boneCount < 0 || (uint32_t)clip->boneCount > header->boneCount || clip->data % wordSize ||
+            !DMSImageSpanFits(header->size, clip->data, clip->dataCount, wordSize)) {
+            return 0;
+        }
+        trackCount += (uint64_t)clip->boneCount * DMS_TRACKS_PER_BONE;
+    }
+    return trackCount <= header->trackCount;
+}
+
+// Builds the model's structs in `block` (LayoutDMSImageModel() bytes) around
+// an image. Everything but unpacked vertices stays in the image and is used
+// in place.
+static DMSModel* BuildDMSImageModel(uint8_t* block, const uint8_t* image) {
+    const DMSImageHeader* header = (const DMSImageHeader*)image;
+    const DMSImageMesh* meshRecords = (const DMSImageMesh*)(header + 1);
+    const DMSImageBone* boneRecords = (const DMSImageBone*)(meshRecords + header->meshCount);
+    const DMSImageClip* clipRecords = (const DMSImageClip*)(boneRecords + header->boneCount);
+
+    DMSImageParts parts;
+    size_t runtimeSize = LayoutDMSImageModel(header, (uintptr_t)block, &parts);
+    memset(block, 0, runtimeSize);
+
+    DMSModel* model = parts.model;
+    model->image = image;
+    model->meshes = parts.meshes;
+    model->meshCount = header->meshCount;
+
+    DMSVertex* vertexPool = parts.vertices;
+    int maxTextureId = -1;
+    for (uint32_t m = 0; m < header->meshCount; m++) {
+        const DMSImageMesh* record = &meshRecords[m];
+        DMSMesh* mesh = &model->meshes[m];
+        mesh->vertexCount = record->vertexCount;
+        mesh->indexCount = record->indexCount;
+        mesh->textureId = record->textureId;
+        mesh->stripCount = record->stripCount;
+        mesh->stripIndexCount = record->stripIndexCount;
+        mesh->indexSize = record->indexSize;
+        mesh->triangleCount = record->triangleCount;
+        mesh->stripLengths = (uint32_t*)(image + record->stripLengths);
+        mesh->indices = (void*)(image + record->indices);
+        mesh->boneSpace = (record->vertexFormat & DMS_VERTEX_BONE_SPACE) != 0;
+
+        if ((record->vertexFormat & ~(DMS_VERTEX_BONE_SPACE | DMS_VERTEX_RIGID)) == DMS_VERTEX_FORMAT_PACKED) {
+            mesh->vertices = vertexPool;
+            vertexPool += mesh->vertexCount;
+            UnpackDMSVertices((const DMSPackedVertex*)(image + record->vertices), mesh->vertexCount,
+                              record->positionOffset, record->positionScale, record->uvOffset,
+                              record->uvScale, mesh->vertices);
+        } else {
+            mesh->vertices = (DMSVertex*)(image + record->vertices);
+        }
+        mesh->rigidBone = ((record->vertexFormat & DMS_VERTEX_RIGID) && mesh->vertexCount > 0)
+                        ? mesh->vertices[0].boneId : -1;
+        if (mesh->textureId > maxTextureId) maxTextureId = mesh->textureId;
+        MergeDMSBounds(model, record->center, record->radius);
+    }
+
+    if (header->boneCount > 0) {
+        DMSSkeleton* skeleton = parts.skeleton;
+        model->skeleton = skeleton;
+        skeleton->bones = parts.bones;
+        skeleton->boneCount = header->boneCount;
+        for (uint32_t i = 0; i < header->boneCount; i++) {
+            memcpy(skeleton->bones[i].name, boneRecords[i].name, sizeof(skeleton->bones[i].name));
+            skeleton->bones[i].parent = boneRecords[i].parent;
+            skeleton->bones[i].bindPose = boneRecords[i].bindPose;
+            skeleton->bones[i].inverseBindMatrix = boneRecords[i].inverseBindMatrix;
+        }
+        SetDMSBoneDepths(skeleton);
+
+        skeleton->animations = header->animCount > 0 ? parts.animations : NULL;
+        skeleton->animCount = header->animCount;
+        DMSTrack* trackPool = parts.tracks;
+        for (uint32_t i = 0; i < header->animCount; i++) {
+            const DMSImageClip* clip = &clipRecords[i];
+            DMSAnimation* anim = &skeleton->animations[i];
+            memcpy(anim->name, clip->name, sizeof(anim->name));
+            anim->boneCount = clip->boneCount;
+            anim->frameCount = clip->frameCount;
+            anim->duration = clip->duration;
+            anim->timeStep = clip->timeStep;
+            anim->translationMin = clip->translationMin;
+            anim->translationStep = clip->translationStep;
+            anim->scaleMin = clip->scaleMin;
+            anim->scaleStep = clip->scaleStep;
+            anim->tracks = trackPool;
+            trackPool += clip->boneCount * DMS_TRACKS_PER_BONE;
+            LinkDMSImageTracks(anim, clip, image);
+        }
+    }
+
+    // The texture table is filled by LoadDMSTextures(), so it stays separate
+    model->textureCount = (int)header->textureCount > maxTextureId ? (int)header->textureCount : maxTextureId + 1;
+    if (model->textureCount > 0) {
+        model->textures = (Texture2D*)calloc(model->textureCount, sizeof(Texture2D));
+        if (!model->textures) {
+            printf("Out of memory for %d DMS textures\n", model->textureCount);
+            free(block);
+            return NULL;
+        }
+    }
+    return model;
+}
+
+// Reads a whole image with one fread into the block that also holds the
+// model's structs
+static DMSModel* ReadDMSImage(FILE* file) {
+    DMSImageHeader header;
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.version != DMS_IMAGE_VERSION) {
+        printf("Unsupported DMS image\n");
+        return NULL;
+    }
+    if (fileSize < 0 || !CheckDMSImageHeader(&header, (size_t)fileSize)) {
+        printf("Damaged DMS image\n");
+        return NULL;
+    }
+
+    DMSImageParts parts;
+    size_t runtimeSize = LayoutDMSImageModel(&header, 0, &parts);
+    uint8_t* block = (uint8_t*)memalign(32, runtimeSize + header.size);
+    if (!block) {
+        printf("Out of memory for a %lu byte DMS image\n", (unsigned long)(runtimeSize + header.size));
+        return NULL;
+    }
+    uint8_t* image = block + runtimeSize;
+
+    fseek(file, 0, SEEK_SET);
+    if (fread(image, 1, header.size, file) != header.size) {
+        printf("Truncated DMS image\n");
+        free(block);
+        return NULL;
+    }
+    if (!CheckDMSImageRecords(image)) {
+        printf("Damaged DMS image\n");
+        free(block);
+        return NULL;
+    }
+    return BuildDMSImageModel(block, image);
+}
+
+DMSModel* LoadDMSModelImage(const void* image) {
+    const DMSImageHeader* header = (const DMSImageHeader*)image;
+    if (header->magic != DMS_IMAGE_MAGIC || header->version != DMS_IMAGE_VERSION) {
+        printf("Unsupported DMS image\n");
+        return NULL;
+    }
+    // The caller vouches for header->size bytes; the tables are checked within them
+    if (!CheckDMSImageHeader(header, header->size) || !CheckDMSImageRecords((const uint8_t*)image)) {
+        printf("Damaged DMS image\n");
+        return NULL;
+    }
+
+    DMSImageParts parts;
+    uint8_t* block = (uint8_t*)memalign(32, LayoutDMSImageModel(header, 0, &parts));
+    if (!block) {
+        printf("Out of memory for a DMS image\n");
+        return NULL;
+    }
+    return BuildDMSImageModel(block, (const uint8_t*)image);
+}
+
 // Load DMS model from file
 DMSModel* LoadDMSModel(const char* filename) {
+    return LoadDMSModelSections(filename, DMS_LOAD_ALL);
+}
+
+DMSModel* LoadDMSModelSections(const char* filename, uint32_t sections) {
     FILE* file = fopen(filename, "rb");
     if (!file) {
         printf("Failed to open %s\n", filename);
@@ -20,6 +1018,13 @@ DMSModel* LoadDMSModel(const char* filename) {
     fread(&meshCount, sizeof(uint32_t), 1, file);
     fread(&boneCount, sizeof(uint32_t), 1, file);
 
+    // In-place images load whole, in one read
+    if (magic == DMS_IMAGE_MAGIC) {
+        DMSModel* model = ReadDMSImage(file);
+        fclose(file);
+        return model;
+    }
+
     if (magic != DMS_MAGIC_NUMBER) {
         printf("Invalid file format: magic mismatch 0x%08lX vs 0x%08X\n", 
                (unsigned long)magic, DMS_MAGIC_NUMBER);
@@ -27,142 +1032,63 @@ DMSModel* LoadDMSModel(const char* filename) {
         return NULL;
     }
 
+    // Only chunked files can leave sections out; older ones load whole
+    if (version < 6) sections = DMS_LOAD_ALL;
+
     DMSModel* model = (DMSModel*)calloc(1, sizeof(DMSModel));
-    model->meshCount = meshCount;
+    model->meshCount = (sections & DMS_LOAD_MESHES) ? meshCount : 0;
     model->meshes = (DMSMesh*)calloc(meshCount, sizeof(DMSMesh));
 
     printf("Loading DMS model with %lu meshes and %lu bones\n", 
            (unsigned long)meshCount, (unsigned long)boneCount);
 
-    // Load skeleton if present
-    if (boneCount > 0) {
+    if (boneCount > 0 && (sections & DMS_LOAD_SKELETON)) {
         model->skeleton = (DMSSkeleton*)calloc(1, sizeof(DMSSkeleton));
         model->skeleton->boneCount = boneCount;
         model->skeleton->bones = (DMSBone*)calloc(boneCount, sizeof(DMSBone));
+    }
 
-        // Read bones
-        for (uint32_t i = 0; i < boneCount; i++) {
-            DMSBone* bone = &model->skeleton->bones[i];
-            fread(bone->name, sizeof(char), 64, file);
-            fread(&bone->parent, sizeof(int), 1, file);
-            fread(&bone->bindPose, sizeof(DMSTransform), 1, file);
-            fread(&bone->inverseBindMatrix, sizeof(Matrix), 1, file);
-        }
+    if (version >= 6) {
+        ReadDMSChunks(model, version, boneCount, sections, file);
 
-        // Read animations
-        uint32_t animCount;
-        fread(&animCount, sizeof(uint32_t), 1, file);
-        
-        if (animCount > 0) {
-            model->skeleton->animCount = animCount;
-            model->skeleton->animations = (DMSAnimation*)calloc(animCount, sizeof(DMSAnimation));
-
-            for (uint32_t i = 0; i < animCount; i++) {
-                DMSAnimation* anim = &model->skeleton->animations[i];
-                
-                fread(anim->name, sizeof(char), 32, file);
-                fread(&anim->boneCount, sizeof(int), 1, file);
-                fread(&anim->frameCount, sizeof(int), 1, file);
-                fread(&anim->duration, sizeof(float), 1, file);
-
-                size_t totalPoses = anim->frameCount * anim->boneCount;
-                DMSTransform* poses = (DMSTransform*)calloc(totalPoses, sizeof(DMSTransform));
-                fread(poses, sizeof(DMSTransform), totalPoses, file);
-                anim->framePoses = (DMSTransform**)poses;
-                
-                printf("  Animation %lu: %s, %d frames, duration %.2fs\n", 
-                       (unsigned long)i, anim->name, anim->frameCount, anim->duration);
-            }
-            
-            // Initialize animation playback
-            model->skeleton->currentAnim = 0;
-            model->skeleton->currentTime = 0.0f;
+        // Clips left on disk are read through the clip cache
+        if (model->skeleton && model->skeleton->animCount > 0 && !(sections & DMS_LOAD_ALL_CLIPS)) {
+            model->skeleton->clipSource = strdup(filename);
+            model->skeleton->clipVersion = version;
+            AddDMSClipOwner(model->skeleton);
         }
     } else {
-        model->skeleton = NULL;
-        
-        uint32_t animCount;
-        fread(&animCount, sizeof(uint32_t), 1, file);
+        ReadDMSSections(model, version, file);
     }
+    fclose(file);
 
-    // Find the highest texture ID to determine texture count
-    int maxTextureId = -1;
+    if (model->skeleton) {
+        for (int i = 0; i < model->skeleton->animCount; i++) {
+            const DMSAnimation* anim = &model->skeleton->animations[i];
+            printf("  Animation %d: %s, %d frames, duration %.2fs\n", 
+                   i, anim->name, anim->frameCount, anim->duration);
+        }
+    }
 
-    // Load mesh data
-    for (uint32_t m = 0; m < meshCount; m++) {
+    // Without a material table, the highest texture ID gives the texture count
+    int maxTextureId = -1;
+    for (int m = 0; m < model->meshCount; m++) {
         DMSMesh* mesh = &model->meshes[m];
-        
-        fread(&mesh->vertexCount, sizeof(uint32_t), 1, file);
-        fread(&mesh->indexCount, sizeof(uint32_t), 1, file);
-        fread(&mesh->textureId, sizeof(int), 1, file);
-        
         if (mesh->textureId > maxTextureId) {
             maxTextureId = mesh->textureId;
         }
-
-        printf("  Mesh %lu: %d vertices, %d indices, texture ID %d\n", 
-               (unsigned long)m, mesh->vertexCount, mesh->indexCount, mesh->textureId);
-
-        // Allocate and load vertices
-        if (mesh->vertexCount > 0) {
-            mesh->vertices = (DMSVertex*)memalign(32, mesh->vertexCount * sizeof(DMSVertex));
-            memset(mesh->vertices, 0, mesh->vertexCount * sizeof(DMSVertex));
-            
-            if (model->skeleton) {
-                // Animated model - read full vertex data
-                mesh->animatedVertices = (DMSVertex*)calloc(mesh->vertexCount, sizeof(DMSVertex));
-                fread(mesh->vertices, sizeof(DMSVertex), mesh->vertexCount, file);
-                
-                // Initialize animated vertices with bind pose
-                for (int i = 0; i < mesh->vertexCount; i++) {
-                    mesh->animatedVertices[i] = mesh->vertices[i];
-                }
-            } else {
-                // Static model - read simplified vertex data
-                typedef struct {
-                    float x, y, z;        // Position
-                    float nx, ny, nz;     // Normal
-                    float u, v;           // Texture coordinates
-                } StaticVertex;
-
-                StaticVertex* tempVerts = (StaticVertex*)malloc(mesh->vertexCount * sizeof(StaticVertex));
-                fread(tempVerts, sizeof(StaticVertex), mesh->vertexCount, file);
-                
-                // Convert to DMSVertex format
-                for (int i = 0; i < mesh->vertexCount; i++) {
-                    mesh->vertices[i].x = tempVerts[i].x;
-                    mesh->vertices[i].y = tempVerts[i].y;
-                    mesh->vertices[i].z = tempVerts[i].z;
-                    mesh->vertices[i].nx = tempVerts[i].nx * 127.0f;  
-                    mesh->vertices[i].ny = tempVerts[i].ny * 127.0f;
-                    mesh->vertices[i].nz = tempVerts[i].nz * 127.0f;
-                    mesh->vertices[i].u = tempVerts[i].u;
-                    mesh->vertices[i].v = tempVerts[i].v;
-                    mesh->vertices[i].boneId = 0;
-                    mesh->vertices[i].boneWeight = 0.0f;
-                }
-                
-                free(tempVerts);
-                mesh->animatedVertices = NULL;
-            }
-        }
-
-        // Allocate and load indices
-        if (mesh->indexCount > 0) {
-            mesh->indices = (unsigned int*)calloc(mesh->indexCount, sizeof(unsigned int));
-            fread(mesh->indices, sizeof(unsigned int), mesh->indexCount, file);
-        }
-        
-        mesh->triangleCount = 0; 
+        printf("  Mesh %d: %d vertices, %d indices, texture ID %d\n", 
+               m, mesh->vertexCount, mesh->indexCount, mesh->textureId);
+    }
+    if (model->textureCount <= maxTextureId) {
+        model->textureCount = maxTextureId + 1;
     }
 
     // Set up texture array
-    model->textureCount = (maxTextureId >= 0) ? (maxTextureId + 1) : 0;
     if (model->textureCount > 0) {
         model->textures = (Texture2D*)calloc(model->textureCount, sizeof(Texture2D));
     }
 
-    fclose(file);
     return model;
 }
 
@@ -198,93 +1124,509 @@ int LoadDMSTextures(DMSModel* model, const char* basePath, const char* defaultTe
     return successCount;
 }
 
-// Update animation for a DMS model
-void UpdateDMSModelAnimation(DMSModel* model, float deltaTime) {
-    if (!model || !model->skeleton || model->skeleton->animCount == 0) return;
+// Finds the key at or before `time`, continuing from the bone's last key so
+// forward playback is O(1); seeks from the start when time moved backward
+static int SeekDMSTrack(const DMSTrack* track, float time, int* cursor, float* alpha) {
+    int k = *cursor;
+    if (k < 0 || k >= track->keyCount || track->times[k] > time) k = 0;
+    while (k + 1 < track->keyCount && track->times[k + 1] <= time) k++;
+    *cursor = k;
 
-    DMSSkeleton* skeleton = model->skeleton;
-    DMSAnimation* anim = &skeleton->animations[skeleton->currentAnim];
-    
-    // Update animation time
-    skeleton->currentTime += deltaTime;
-    
-    // Loop animation
-    while (skeleton->currentTime >= anim->duration) {
-        skeleton->currentTime -= anim->duration;
+    *alpha = 0.0f;
+    if (k + 1 < track->keyCount && time > track->times[k]) {
+        *alpha = (time - track->times[k]) / (track->times[k + 1] - track->times[k]);
+    }
+    return k;
+}
+
+static Vector3 SampleDMSVector3(const DMSTrack* track, float time, int* cursor, Vector3 fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const float* v = track->values + SeekDMSTrack(track, time, cursor, &alpha) * 3;
+    Vector3 a = { v[0], v[1], v[2] };
+    if (alpha == 0.0f) return a;
+    Vector3 b = { v[3], v[4], v[5] };
+    return Vector3Lerp(a, b, alpha);
+}
+
+// Keys closer than this (cosine of half the angle) are nlerped; the
+// converter fits tracks with QuaternionSlerp(), which switches at the same
+// point, so the fit tolerance holds either way
+#define DMS_NLERP_MIN_DOT 0.95f
+
+static inline Quaternion InterpolateDMSQuaternion(Quaternion a, Quaternion b, float alpha) {
+    float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    if (dot < 0.0f) {
+        b.x = -b.x; b.y = -b.y; b.z = -b.z; b.w = -b.w;
+        dot = -dot;
+    }
+    if (dot <= DMS_NLERP_MIN_DOT) return QuaternionSlerp(a, b, alpha);
+
+    Quaternion q = { a.x + (b.x - a.x) * alpha, a.y + (b.y - a.y) * alpha,
+                     a.z + (b.z - a.z) * alpha, a.w + (b.w - a.w) * alpha };
+    float invLength = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    q.x *= invLength;
+    q.y *= invLength;
+    q.z *= invLength;
+    q.w *= invLength;
+    return q;
+}
+
+static Quaternion SampleDMSQuaternion(const DMSTrack* track, float time, int* cursor, Quaternion fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const float* q = track->values + SeekDMSTrack(track, time, cursor, &alpha) * 4;
+    Quaternion a = { q[0], q[1], q[2], q[3] };
+    if (alpha == 0.0f) return a;
+    Quaternion b = { q[4], q[5], q[6], q[7] };
+    return InterpolateDMSQuaternion(a, b, alpha);
+}
+
+// SeekDMSTrack over the tick times of a quantized track
+static int SeekDMSTicks(const DMSTrack* track, float tick, int* cursor, float* alpha) {
+    const uint16_t* ticks = track->ticks;
+    int k = *cursor;
+    if (k < 0 || k >= track->keyCount || ticks[k] > tick) k = 0;
+    while (k + 1 < track->keyCount && ticks[k + 1] <= tick) k++;
+    *cursor = k;
+
+    *alpha = 0.0f;
+    if (k + 1 < track->keyCount && tick > ticks[k]) {
+        *alpha = (tick - ticks[k]) / (float)(ticks[k + 1] - ticks[k]);
+    }
+    return k;
+}
+
+static Vector3 DecodeDMSFixed(const uint16_t* q, Vector3 min, Vector3 step) {
+    Vector3 v = { min.x + q[0] * step.x, min.y + q[1] * step.y, min.z + q[2] * step.z };
+    return v;
+}
+
+// Smallest three: bit 15 of the first two words indexes the dropped
+// (largest, positive) component, the low 15 bits hold the other three
+static Quaternion DecodeDMSQuaternion(const uint16_t* q) {
+    const float limit = 0.70710678f;
+    float c[4];
+    int largest = (q[0] >> 15) | ((q[1] >> 15) << 1);
+    float sum = 0.0f;
+    for (int i = 0, w = 0; i < 4; i++) {
+        if (i == largest) continue;
+        c[i] = (q[w++] & 0x7FFF) * (2.0f * limit / 32767.0f) - limit;
+        sum += c[i] * c[i];
     }
+    c[largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+    Quaternion r = { c[0], c[1], c[2], c[3] };
+    return r;
+}
+
+static Vector3 SampleDMSFixedVector3(const DMSTrack* track, float tick, int* cursor,
+                                     Vector3 min, Vector3 step, Vector3 fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const uint16_t* q = track->ticks + track->keyCount + SeekDMSTicks(track, tick, cursor, &alpha) * 3;
+    Vector3 a = DecodeDMSFixed(q, min, step);
+    if (alpha == 0.0f) return a;
+    return Vector3Lerp(a, DecodeDMSFixed(q + 3, min, step), alpha);
+}
+
+static Quaternion SampleDMSQuantizedQuaternion(const DMSTrack* track, float tick, int* cursor, Quaternion fallback) {
+    if (track->keyCount == 0) return fallback;
+
+    float alpha;
+    const uint16_t* q = track->ticks + track->keyCount + SeekDMSTicks(track, tick, cursor, &alpha) * 3;
+    Quaternion a = DecodeDMSQuaternion(q);
+    if (alpha == 0.0f) return a;
+    return InterpolateDMSQuaternion(a, DecodeDMSQuaternion(q + 3), alpha);
+}
 
-    if (anim->frameCount < 2) return;
+// MatrixMultiply(local, parent) for affine matrices: the bottom rows are
+// (0, 0, 0, 1), so only the upper 3x4 is computed
+static inline void MultiplyDMSAffine(const Matrix* local, const Matrix* parent, Matrix* out) {
+    float x, y, z;
+    x = local->m0; y = local->m1; z = local->m2;
+    out->m0 = x * parent->m0 + y * parent->m4 + z * parent->m8;
+    out->m1 = x * parent->m1 + y * parent->m5 + z * parent->m9;
+    out->m2 = x * parent->m2 + y * parent->m6 + z * parent->m10;
+    x = local->m4; y = local->m5; z = local->m6;
+    out->m4 = x * parent->m0 + y * parent->m4 + z * parent->m8;
+    out->m5 = x * parent->m1 + y * parent->m5 + z * parent->m9;
+    out->m6 = x * parent->m2 + y * parent->m6 + z * parent->m10;
+    x = local->m8; y = local->m9; z = local->m10;
+    out->m8 = x * parent->m0 + y * parent->m4 + z * parent->m8;
+    out->m9 = x * parent->m1 + y * parent->m5 + z * parent->m9;
+    out->m10 = x * parent->m2 + y * parent->m6 + z * parent->m10;
+    x = local->m12; y = local->m13; z = local->m14;
+    out->m12 = x * parent->m0 + y * parent->m4 + z * parent->m8 + parent->m12;
+    out->m13 = x * parent->m1 + y * parent->m5 + z * parent->m9 + parent->m13;
+    out->m14 = x * parent->m2 + y * parent->m6 + z * parent->m10 + parent->m14;
+    out->m3 = 0.0f;
+    out->m7 = 0.0f;
+    out->m11 = 0.0f;
+    out->m15 = 1.0f;
+}
+
+// Inverse of an affine matrix: inverted 3x3 part, translation brought back
+// through it
+static void InvertDMSAffine(const Matrix* m, Matrix* out) {
+    float c00 = m->m5 * m->m10 - m->m9 * m->m6;
+    float c01 = m->m8 * m->m6 - m->m4 * m->m10;
+    float c02 = m->m4 * m->m9 - m->m8 * m->m5;
+    float c10 = m->m9 * m->m2 - m->m1 * m->m10;
+    float c11 = m->m0 * m->m10 - m->m8 * m->m2;
+    float c12 = m->m8 * m->m1 - m->m0 * m->m9;
+    float c20 = m->m1 * m->m6 - m->m5 * m->m2;
+    float c21 = m->m4 * m->m2 - m->m0 * m->m6;
+    float c22 = m->m0 * m->m5 - m->m4 * m->m1;
+    float det = m->m0 * c00 + m->m4 * c10 + m->m8 * c20;
+    float invDet = (det != 0.0f) ? 1.0f / det : 0.0f;
 
-    // Get current and next frame
-    float timePerFrame = anim->duration / (float)anim->frameCount;
-    int frame = (int)(skeleton->currentTime / timePerFrame);
-    int nextFrame = (frame + 1) % anim->frameCount;
-    float alpha = fmodf(skeleton->currentTime, timePerFrame) / timePerFrame;
+    out->m0 = c00 * invDet; out->m4 = c01 * invDet; out->m8 = c02 * invDet;
+    out->m1 = c10 * invDet; out->m5 = c11 * invDet; out->m9 = c12 * invDet;
+    out->m2 = c20 * invDet; out->m6 = c21 * invDet; out->m10 = c22 * invDet;
+    out->m12 = -(out->m0 * m->m12 + out->m4 * m->m13 + out->m8 * m->m14);
+    out->m13 = -(out->m1 * m->m12 + out->m5 * m->m13 + out->m9 * m->m14);
+    out->m14 = -(out->m2 * m->m12 + out->m6 * m->m13 + out->m10 * m->m14);
+    out->m3 = 0.0f;
+    out->m7 = 0.0f;
+    out->m11 = 0.0f;
+    out->m15 = 1.0f;
+}
 
-    // Update bone transforms
+// Builds every bone's world pose from its local pose. Parents come before
+// their children in the bone table. With `moved`, only bones flagged there
+// and their descendants are rebuilt; the others keep the world pose
+// already in worldPose. Returns the number of bones rebuilt.
+static int ComposeDMSWorldPoses(const DMSSkeleton* skeleton, const DMSPose* pose, uint8_t* moved,
+                                Matrix* worldPose) {
+    int rebuilt = 0;
     for (int i = 0; i < skeleton->boneCount; i++) {
-        DMSBone* bone = &skeleton->bones[i];
-        
-        // Get current and next pose for interpolation
-        DMSTransform* curr = &((DMSTransform*)anim->framePoses)[frame * skeleton->boneCount + i];
-        DMSTransform* next = &((DMSTransform*)anim->framePoses)[nextFrame * skeleton->boneCount + i];
-
-        // Interpolate between frames
-        bone->localPose.translation = Vector3Lerp(curr->translation, next->translation, alpha);
-        bone->localPose.rotation = QuaternionSlerp(curr->rotation, next->rotation, alpha);
-        bone->localPose.scale = Vector3Lerp(curr->scale, next->scale, alpha);
-
-        // Build local transformation matrix
-        Matrix S = MatrixScale(bone->localPose.scale.x, bone->localPose.scale.y, bone->localPose.scale.z);
-        Matrix R = QuaternionToMatrix(bone->localPose.rotation);
-        Matrix T = MatrixTranslate(bone->localPose.translation.x, bone->localPose.translation.y, bone->localPose.translation.z);
-        
-        // Combine transformations
-        Matrix localTransform = MatrixMultiply(MatrixMultiply(S, R), T);
+        int parent = skeleton->bones[i].parent;
+        if (moved) {
+            if (parent >= 0 && moved[parent]) moved[i] = 1;
+            if (!moved[i]) continue;
+        }
+
+        // Local transform: scale, then rotate (unit quaternion), then translate
+        Quaternion q = pose->rotation[i];
+        Vector3 s = pose->scale[i];
+        float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+        Matrix local;
+        local.m0 = (1.0f - 2.0f * (yy + zz)) * s.x;
+        local.m1 = 2.0f * (xy + wz) * s.x;
+        local.m2 = 2.0f * (xz - wy) * s.x;
+        local.m4 = 2.0f * (xy - wz) * s.y;
+        local.m5 = (1.0f - 2.0f * (xx + zz)) * s.y;
+        local.m6 = 2.0f * (yz + wx) * s.y;
+        local.m8 = 2.0f * (xz + wy) * s.z;
+        local.m9 = 2.0f * (yz - wx) * s.z;
+        local.m10 = (1.0f - 2.0f * (xx + yy)) * s.z;
+        local.m12 = pose->translation[i].x;
+        local.m13 = pose->translation[i].y;
+        local.m14 = pose->translation[i].z;
 
-        // Apply parent transform if any
-        if (bone->parent >= 0) {
-            bone->worldPose = MatrixMultiply(localTransform, skeleton->bones[bone->parent].worldPose);
+        if (parent >= 0) {
+            MultiplyDMSAffine(&local, &worldPose[parent], &worldPose[i]);
         } else {
-            bone->worldPose = localTransform;
+            local.m3 = 0.0f;
+            local.m7 = 0.0f;
+            local.m11 = 0.0f;
+            local.m15 = 1.0f;
+            worldPose[i] = local;
         }
+        rebuilt++;
     }
+    return rebuilt;
 }
 
-// Update vertex positions for an animated mesh
-void UpdateDMSMeshAnimation(DMSMesh* mesh, const DMSSkeleton* skeleton) {
-    if (!mesh || !skeleton || !mesh->animatedVertices) return;
+// Samples every bone of a clip at `time` into a pose. Bones deeper than
+// maxBoneDepth (unless -1) get their bind pose. With `moved`, the pose
+// holds an earlier sample of the same clip at the same depth: bones that
+// cannot have changed since (constant tracks, bind pose) are left alone,
+// and each bone is flagged there with whether it was sampled.
+static void SampleDMSClip(const DMSSkeleton* skeleton, const DMSAnimation* anim, float time, int* trackCursor,
+                          int maxBoneDepth, DMSPose* pose, uint8_t* moved) {
+    for (int i = 0; i < skeleton->boneCount; i++) {
+        const DMSBone* bone = &skeleton->bones[i];
+        const DMSTrack* tracks = &anim->tracks[i * DMS_TRACKS_PER_BONE];
+        int* cursor = &trackCursor[i * DMS_TRACKS_PER_BONE];
+        int bindPose = maxBoneDepth >= 0 && bone->depth > maxBoneDepth;
+        if (moved) {
+            moved[i] = !bindPose && (tracks[DMS_TRACK_TRANSLATION].keyCount > 1 ||
+                                     tracks[DMS_TRACK_ROTATION].keyCount > 1 ||
+                                     tracks[DMS_TRACK_SCALE].keyCount > 1);
+            if (!moved[i]) continue;
+        }
+        if (bindPose) {
+            pose->translation[i] = bone->bindPose.translation;
+            pose->rotation[i] = bone->bindPose.rotation;
+            pose->scale[i] = bone->bindPose.scale;
+            continue;
+        }
 
-    for (int i = 0; i < mesh->vertexCount; i++) {
-        // Start with bind pose
-        mesh->animatedVertices[i] = mesh->vertices[i];
+        // Sample each channel at its own keys
+        if (anim->keyWords) {
+            float tick = anim->timeStep > 0.0f ? time / anim->timeStep : 0.0f;
+            Vector3 one = { 1.0f, 1.0f, 1.0f };
+            pose->translation[i] = SampleDMSFixedVector3(&tracks[DMS_TRACK_TRANSLATION], tick,
+                &cursor[DMS_TRACK_TRANSLATION], anim->translationMin, anim->translationStep,
+                bone->bindPose.translation);
+            pose->rotation[i] = SampleDMSQuantizedQuaternion(&tracks[DMS_TRACK_ROTATION], tick,
+                &cursor[DMS_TRACK_ROTATION], bone->bindPose.rotation);
+            // Scale tracks without keys are constant 1
+            pose->scale[i] = SampleDMSFixedVector3(&tracks[DMS_TRACK_SCALE], tick,
+                &cursor[DMS_TRACK_SCALE], anim->scaleMin, anim->scaleStep, one);
+        } else {
+            pose->translation[i] = SampleDMSVector3(&tracks[DMS_TRACK_TRANSLATION], time,
+                &cursor[DMS_TRACK_TRANSLATION], bone->bindPose.translation);
+            pose->rotation[i] = SampleDMSQuaternion(&tracks[DMS_TRACK_ROTATION], time,
+                &cursor[DMS_TRACK_ROTATION], bone->bindPose.rotation);
+            pose->scale[i] = SampleDMSVector3(&tracks[DMS_TRACK_SCALE], time,
+                &cursor[DMS_TRACK_SCALE], bone->bindPose.scale);
+        }
+    }
+}
+
+// Adds a weighted pose to per-bone sums. Rotations are summed on the
+// hemisphere of the sum so far and normalized afterwards (nlerp).
+static void AccumulateDMSPose(DMSPose* sum, float* sumWeight, const DMSPose* pose, int boneCount, float weight,
+                              const float* boneMask) {
+    for (int i = 0; i < boneCount; i++) {
+        float w = boneMask ? weight * boneMask[i] : weight;
+        sumWeight[i] += w;
+        sum->translation[i].x += pose->translation[i].x * w;
+        sum->translation[i].y += pose->translation[i].y * w;
+        sum->translation[i].z += pose->translation[i].z * w;
+    }
+    for (int i = 0; i < boneCount; i++) {
+        float w = boneMask ? weight * boneMask[i] : weight;
+        Quaternion s = sum->rotation[i];
+        Quaternion q = pose->rotation[i];
+        if (s.x * q.x + s.y * q.y + s.z * q.z + s.w * q.w < 0.0f) w = -w;
+        sum->rotation[i].x += q.x * w;
+        sum->rotation[i].y += q.y * w;
+        sum->rotation[i].z += q.z * w;
+        sum->rotation[i].w += q.w * w;
+    }
+    for (int i = 0; i < boneCount; i++) {
+        float w = boneMask ? weight * boneMask[i] : weight;
+        sum->scale[i].x += pose->scale[i].x * w;
+        sum->scale[i].y += pose->scale[i].y * w;
+        sum->scale[i].z += pose->scale[i].z * w;
+    }
+}
+
+// Turns per-bone sums into a pose; bones no layer weighs keep the bind pose
+static void NormalizeDMSPose(DMSPose* pose, const float* sumWeight, const DMSSkeleton* skeleton) {
+    for (int i = 0; i < skeleton->boneCount; i++) {
+        Quaternion q = pose->rotation[i];
+        float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        if (sumWeight[i] <= 0.0f || length <= 0.0f) {
+            pose->translation[i] = skeleton->bones[i].bindPose.translation;
+            pose->rotation[i] = skeleton->bones[i].bindPose.rotation;
+            pose->scale[i] = skeleton->bones[i].bindPose.scale;
+            continue;
+        }
+        float invWeight = 1.0f / sumWeight[i];
+        float invLength = 1.0f / length;
+        pose->translation[i].x *= invWeight;
+        pose->translation[i].y *= invWeight;
+        pose->translation[i].z *= invWeight;
+        pose->rotation[i].x = q.x * invLength;
+        pose->rotation[i].y = q.y * invLength;
+        pose->rotation[i].z = q.z * invLength;
+        pose->rotation[i].w = q.w * invLength;
+        pose->scale[i].x *= invWeight;
+        pose->scale[i].y *= invWeight;
+        pose->scale[i].z *= invWeight;
+    }
+}
+
+// Drops a layer; its cursors move to the end for reuse
+static void RemoveDMSAnimationLayer(DMSInstance* instance, int layer) {
+    DMSAnimationLayer removed = instance->layers[layer];
+    instance->model->skeleton->animations[removed.anim].users--;
+    for (int l = layer; l < instance->layerCount - 1; l++) {
+        instance->layers[l] = instance->layers[l + 1];
+    }
+    instance->layerCount--;
+    instance->layers[instance->layerCount].trackCursor = removed.trackCursor;
+}
+
+// Advance an instance's clips and fades and update its bone poses
+void UpdateDMSInstanceAnimation(DMSInstance* instance, float deltaTime) {
+    if (!instance || !instance->model->skeleton || instance->layerCount == 0) return;
+
+    // Off-screen and throttled instances bank the time for their next update
+    DMSAnimationLODState* lod = &instance->lod;
+    uint32_t frame = lod->frame++;
+    if (lod->level < 0 || frame % dmsLODs[lod->level].updateInterval != 0) {
+        lod->pendingTime += deltaTime;
+        lod->updatesSkipped++;
+        return;
+    }
+    deltaTime += lod->pendingTime;
+    lod->pendingTime = 0.0f;
+    lod->updates++;
+
+    DMSSkeleton* skeleton = instance->model->skeleton;
+    for (int l = instance->layerCount - 1; l >= 0; l--) {
+        DMSAnimationLayer* layer = &instance->layers[l];
+        const DMSAnimation* anim = &skeleton->animations[layer->anim];
+
+        // Update animation time
+        layer->time += deltaTime;
         
-        // If vertex has bone influence
-        if (mesh->vertices[i].boneWeight > 0.0f) {
-            uint8_t boneId = mesh->vertices[i].boneId;
-            if (boneId < skeleton->boneCount) {
-                // Get bone transformation matrices
-                Matrix invBind = skeleton->bones[boneId].inverseBindMatrix;
-                Matrix world = skeleton->bones[boneId].worldPose;
-                
-                // Transform vertex position
-                Vector3 pos = {mesh->vertices[i].x, mesh->vertices[i].y, mesh->vertices[i].z};
-                Vector3 boneSpace = Vector3Transform(pos, invBind);
-                Vector3 transformed = Vector3Transform(boneSpace, world);
-                
-                // Update animated position
-                mesh->animatedVertices[i].x = transformed.x;
-                mesh->animatedVertices[i].y = transformed.y;
-                mesh->animatedVertices[i].z = transformed.z;
+        // Loop animation
+        if (anim->duration > 0.0f) {
+            while (layer->time >= anim->duration) {
+                layer->time -= anim->duration;
+            }
+        } else {
+            layer->time = 0.0f;
+        }
+
+        // Fades stop at full weight, or drop the layer at none
+        if (layer->fadeRate != 0.0f) {
+            layer->weight += layer->fadeRate * deltaTime;
+            if (layer->fadeRate > 0.0f && layer->weight >= 1.0f) {
+                layer->weight = 1.0f;
+                layer->fadeRate = 0.0f;
+            } else if (layer->fadeRate < 0.0f && layer->weight <= 0.0f) {
+                RemoveDMSAnimationLayer(instance, l);
             }
         }
     }
+    if (instance->layerCount == 0) return;
+
+    // A single clip is sampled straight into the pose
+    if (instance->layerCount == 1 && !instance->layers[0].boneMask) {
+        DMSAnimationLayer* layer = &instance->layers[0];
+        DMSAnimation* anim = TouchDMSClip(skeleton, layer->anim);
+        if (!anim->tracks) return;
+
+        // With the cache on, the pose is that of the step's start and is
+        // sampled by the first instance to reach the step
+        float time = layer->time;
+        if (dmsResultStep > 0.0f) {
+            int step = (int)(time / dmsResultStep);
+            lod->poseChanged = 1;
+            instance->composedAnim = -1;
+            if (ShareDMSAnimationResult(instance, step)) return;
+            SampleDMSClip(skeleton, anim, step * dmsResultStep, layer->trackCursor,
+                          GetDMSInstanceBoneDepth(instance), &instance->pose, NULL);
+            ComposeDMSWorldPoses(skeleton, &instance->pose, NULL, instance->result->worldPose);
+            return;
+        }
+        ReleaseDMSAnimationResult(instance);
+
+        // Constant bones of the clip composed last time keep their world
+        // pose, unless an ancestor moved
+        int maxBoneDepth = GetDMSInstanceBoneDepth(instance);
+        int sameClip = instance->composedAnim == layer->anim && instance->composedBoneDepth == maxBoneDepth;
+        uint8_t* moved = sameClip ? instance->boneMoved : NULL;
+        SampleDMSClip(skeleton, anim, time, layer->trackCursor, maxBoneDepth, &instance->pose, moved);
+        if (ComposeDMSWorldPoses(skeleton, &instance->pose, moved, instance->worldPose) > 0) {
+            lod->poseChanged = 1;
+        }
+        instance->composedAnim = layer->anim;
+        instance->composedBoneDepth = maxBoneDepth;
+        return;
+    }
+
+    // Blends are per instance
+    ReleaseDMSAnimationResult(instance);
+    instance->composedAnim = -1;
+
+    int boneCount = skeleton->boneCount;
+    memset(instance->pose.translation, 0, boneCount * sizeof(Vector3));
+    memset(instance->pose.rotation, 0, boneCount * sizeof(Quaternion));
+    memset(instance->pose.scale, 0, boneCount * sizeof(Vector3));
+    memset(instance->blendWeight, 0, boneCount * sizeof(float));
+
+    int sampled = 0;
+    for (int l = 0; l < instance->layerCount; l++) {
+        DMSAnimationLayer* layer = &instance->layers[l];
+        if (layer->weight <= 0.0f) continue;
+
+        DMSAnimation* anim = TouchDMSClip(skeleton, layer->anim);
+        if (!anim->tracks) continue;
+
+        SampleDMSClip(skeleton, anim, layer->time, layer->trackCursor, GetDMSInstanceBoneDepth(instance),
+                      &instance->layerPose, NULL);
+        AccumulateDMSPose(&instance->pose, instance->blendWeight, &instance->layerPose, boneCount,
+                          layer->weight, layer->boneMask);
+        sampled++;
+    }
+    if (!sampled) return;
+
+    NormalizeDMSPose(&instance->pose, instance->blendWeight, skeleton);
+    ComposeDMSWorldPoses(skeleton, &instance->pose, NULL, instance->worldPose);
+    lod->poseChanged = 1;
 }
 
+// Skins every mesh of a model with a bone palette. Only weighted positions
+// are written: the skinning buffers start as copies of the bind pose, and
+// nothing else in them changes. Bone-space meshes skip the inverse bind
+// matrices and take one transform per vertex; rigid meshes are not skinned.
+static void SkinDMSModel(const DMSModel* model, const Matrix* worldPose, DMSVertex* const* skinnedVertices) {
+    const DMSSkeleton* skeleton = model->skeleton;
+    for (int m = 0; m < model->meshCount; m++) {
+        const DMSMesh* mesh = &model->meshes[m];
+        DMSVertex* skinned = skinnedVertices[m];
+        if (mesh->rigidBone >= 0) continue;
 
-void RenderDMSModel(DMSModel* dmsModel, Vector3 position, float scale, Color tint) {
-    if (!dmsModel) return;
-    
+        for (int i = 0; i < mesh->vertexCount; i++) {
+            const DMSVertex* vertex = &mesh->vertices[i];
+            if (vertex->boneWeight <= 0.0f || vertex->boneId >= skeleton->boneCount) continue;
+
+            Vector3 pos = { vertex->x, vertex->y, vertex->z };
+            if (!mesh->boneSpace) pos = Vector3Transform(pos, skeleton->bones[vertex->boneId].inverseBindMatrix);
+            Vector3 transformed = Vector3Transform(pos, worldPose[vertex->boneId]);
+            skinned[i].x = transformed.x;
+            skinned[i].y = transformed.y;
+            skinned[i].z = transformed.z;
+        }
+    }
+}
+
+// Skin every mesh of an instance with its current bone poses
+void UpdateDMSInstanceSkinning(DMSInstance* instance) {
+    if (!instance || !instance->skinnedVertices) return;
+
+    // Skinned vertices stay valid until the pose moves
+    if (!instance->lod.poseChanged) {
+        instance->lod.skinningSkipped++;
+        return;
+    }
+    instance->lod.poseChanged = 0;
+    instance->lod.skinningPasses++;
+
+    // Shared results are skinned once per step
+    DMSAnimationResult* result = instance->result;
+    if (result) {
+        if (result->skinned) {
+            dmsResultStats.skinningHits++;
+            return;
+        }
+        SkinDMSModel(instance->model, result->worldPose, result->skinnedVertices);
+        result->skinned = 1;
+        dmsResultStats.skinningMisses++;
+        return;
+    }
+
+    SkinDMSModel(instance->model, instance->worldPose, instance->skinnedVertices);
+}
+
+// Draws a model's meshes from skinnedVertices[m], or from the bind pose
+// when skinnedVertices is NULL. Rigid meshes are drawn from the bind pose
+// through their bone's worldPose, or its bind pose when worldPose is NULL.
+static void DrawDMSModel(const DMSModel* dmsModel, DMSVertex* const* skinnedVertices, const Matrix* worldPose,
+                         Vector3 position, float scale, Color tint) {
     // Disable lighting since  not using normals
     glDisable(GL_LIGHTING);
     
@@ -301,7 +1643,7 @@ void RenderDMSModel(DMSModel* dmsModel, Vector3 position, float scale, Color tin
     
     // For each mesh
     for (int m = 0; m < dmsModel->meshCount; m++) {
-        DMSMesh* mesh = &dmsModel->meshes[m];
+        const DMSMesh* mesh = &dmsModel->meshes[m];
         
         if (!mesh->vertices || mesh->indexCount == 0) continue;
         
@@ -318,105 +1660,47 @@ void RenderDMSModel(DMSModel* dmsModel, Vector3 position, float scale, Color tin
         glColor4ub(tint.r, tint.g, tint.b, tint.a);
         
         // Select vertex buffer based on animation
-        DMSVertex* vertexBuffer = dmsModel->skeleton ? mesh->animatedVertices : mesh->vertices;
+        int rigid = mesh->rigidBone >= 0 && dmsModel->skeleton;
+        const DMSVertex* vertexBuffer = (skinnedVertices && !rigid) ? skinnedVertices[m] : mesh->vertices;
+
+        // A rigid mesh takes its bone's matrix instead of skinning
+        if (rigid) {
+            Matrix bindPose;
+            const Matrix* bone = &bindPose;
+            if (worldPose) {
+                bone = &worldPose[mesh->rigidBone];
+            } else {
+                InvertDMSAffine(&dmsModel->skeleton->bones[mesh->rigidBone].inverseBindMatrix, &bindPose);
+            }
+            float columns[16] = {
+                bone->m0, bone->m1, bone->m2, bone->m3, bone->m4, bone->m5, bone->m6, bone->m7,
+                bone->m8, bone->m9, bone->m10, bone->m11, bone->m12, bone->m13, bone->m14, bone->m15
+            };
+            glPushMatrix();
+            glMultMatrixf(columns);
+        }
         
         // Point to our vertex data
         glVertexPointer(3, GL_FLOAT, sizeof(DMSVertex), &vertexBuffer[0].x);
         glTexCoordPointer(2, GL_FLOAT, sizeof(DMSVertex), &vertexBuffer[0].u);
         // glNormalPointer(GL_BYTE, sizeof(DMSVertex), &vertexBuffer[0].nx); 
         
-        // Process all triangle strips first
-        int i = 0;
-        while (i < mesh->indexCount) {
-            uint32_t rawIndex = mesh->indices[i];
-            
-            if ((rawIndex & 0x80000000) == 0) {
-                // Skip individual triangles for now
-                i++;
-                continue;
-            }
-            
-            uint32_t stripId = (rawIndex >> 24) & 0x7F;
-            int stripStart = i;
-            int stripLength = 0;
-            
-            // Count strip length
-            while (i < mesh->indexCount) {
-                rawIndex = mesh->indices[i];
-                if (!(rawIndex & 0x80000000) || ((rawIndex >> 24) & 0x7F) != stripId)
-                    break;
-                stripLength++;
-                i++;
-            }
-            
+        // Walk the strip table, then draw the triangle list in one call
+        GLenum indexType = (mesh->indexSize == sizeof(uint16_t)) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        const uint8_t* stripIndices = (const uint8_t*)mesh->indices;
+        for (int s = 0; s < mesh->stripCount; s++) {
+            int stripLength = mesh->stripLengths[s];
             if (stripLength >= 3) {
-                // Create a temporary index buffer for this strip
-                unsigned int* stripIndices = (unsigned int*)alloca(stripLength * sizeof(unsigned int));
-                
-                for (int j = 0; j < stripLength; j++) {
-                    stripIndices[j] = mesh->indices[stripStart + j] & 0x00FFFFFF;
-                }
-                
-                // Draw the strip with one call
-                glDrawElements(GL_TRIANGLE_STRIP, stripLength, GL_UNSIGNED_INT, stripIndices);
-            }
-        }
-        
-        // Now collect all individual triangles into one batch
-        int triangleCount = 0;
-        i = 0;
-        
-        // First count triangles
-        while (i < mesh->indexCount) {
-            if ((mesh->indices[i] & 0x80000000) == 0) {
-                if (i + 2 < mesh->indexCount) {
-                    triangleCount++;
-                    i += 3;
-                } else {
-                    i++;
-                }
-            } else {
-                // Skip strips
-                uint32_t stripId = (mesh->indices[i] >> 24) & 0x7F;
-                while (i < mesh->indexCount && 
-                       (mesh->indices[i] & 0x80000000) && 
-                       ((mesh->indices[i] >> 24) & 0x7F) == stripId) {
-                    i++;
-                }
+                glDrawElements(GL_TRIANGLE_STRIP, stripLength, indexType, stripIndices);
             }
+            stripIndices += stripLength * mesh->indexSize;
         }
-        
-        if (triangleCount > 0) {
-            // Allocate temporary buffer for triangle indices
-            unsigned int* triIndices = (unsigned int*)alloca(triangleCount * 3 * sizeof(unsigned int));
-            int indexPos = 0;
-            
-            // Collect all triangle indices
-            i = 0;
-            while (i < mesh->indexCount) {
-                if ((mesh->indices[i] & 0x80000000) == 0) {
-                    if (i + 2 < mesh->indexCount) {
-                        for (int j = 0; j < 3; j++) {
-                            triIndices[indexPos++] = mesh->indices[i + j] & 0x00FFFFFF;
-                        }
-                        i += 3;
-                    } else {
-                        i++;
-                    }
-                } else {
-                    // Skip strips
-                    uint32_t stripId = (mesh->indices[i] >> 24) & 0x7F;
-                    while (i < mesh->indexCount && 
-                           (mesh->indices[i] & 0x80000000) && 
-                           ((mesh->indices[i] >> 24) & 0x7F) == stripId) {
-                        i++;
-                    }
-                }
-            }
-            
-            // Draw all triangles at once
-            glDrawElements(GL_TRIANGLES, triangleCount * 3, GL_UNSIGNED_INT, triIndices);
+
+        int listIndexCount = (mesh->indexCount - mesh->stripIndexCount) / 3 * 3;
+        if (listIndexCount > 0) {
+            glDrawElements(GL_TRIANGLES, listIndexCount, indexType, stripIndices);
         }
+        if (rigid) glPopMatrix();
     }
     
     // Disable client states at the end
@@ -430,15 +1714,35 @@ void RenderDMSModel(DMSModel* dmsModel, Vector3 position, float scale, Color tin
     glPopMatrix();
 }
 
+void RenderDMSModel(DMSModel* dmsModel, Vector3 position, float scale, Color tint) {
+    if (!dmsModel) return;
+    DrawDMSModel(dmsModel, NULL, NULL, position, scale, tint);
+}
+
+void RenderDMSInstance(const DMSInstance* instance, Vector3 position, float scale, Color tint) {
+    if (!instance) return;
+    const DMSAnimationResult* result = instance->result;
+    DrawDMSModel(instance->model, result ? result->skinnedVertices : instance->skinnedVertices,
+                 result ? result->worldPose : instance->worldPose, position, scale, tint);
+}
+
 // Free DMS model resources
 void UnloadDMSModel(DMSModel* model) {
     if (!model) return;
+    if (model->skeleton) FreeDMSAnimationResults(model);
+
+    // An image model is a single block; only the texture table lives outside it
+    if (model->image) {
+        if (model->textures) free(model->textures);
+        free(model);
+        return;
+    }
     
     // Free meshes
     for (int i = 0; i < model->meshCount; i++) {
         if (model->meshes[i].vertices) free(model->meshes[i].vertices);
-        if (model->meshes[i].animatedVertices) free(model->meshes[i].animatedVertices);
         if (model->meshes[i].indices) free(model->meshes[i].indices);
+        if (model->meshes[i].stripLengths) free(model->meshes[i].stripLengths);
     }
     if (model->meshes) free(model->meshes);
     
@@ -447,10 +1751,13 @@ void UnloadDMSModel(DMSModel* model) {
         if (model->skeleton->bones) free(model->skeleton->bones);
         
         // Free animations
+        if (model->skeleton->clipSource) {
+            RemoveDMSClipOwner(model->skeleton);
+            free(model->skeleton->clipSource);
+        }
         if (model->skeleton->animations) {
             for (int i = 0; i < model->skeleton->animCount; i++) {
-                if (model->skeleton->animations[i].framePoses) 
-                    free(model->skeleton->animations[i].framePoses);
+                ReleaseDMSClip(&model->skeleton->animations[i]);
             }
             free(model->skeleton->animations);
         }
@@ -463,19 +1770,226 @@ void UnloadDMSModel(DMSModel* model) {
     free(model);
 }
 
-// Set current animation for a DMS model
-int SetDMSModelAnimation(DMSModel* model, int animIndex) {
-    if (!model || !model->skeleton) return 0;
+// Points an instance's arrays into a block at `base`: poses and palette, the
+// layers' track cursors, the per-mesh pointer table and, at *vertices, the
+// skinning buffers of every mesh that is not rigid. With a base of 0 it only
+// measures.
+static size_t LayoutDMSInstance(DMSInstance* instance, const DMSModel* model, uintptr_t base, DMSVertex** vertices) {
+    int boneCount = model->skeleton ? model->skeleton->boneCount : 0;
+    int meshCount = model->skeleton ? model->meshCount : 0;
+    int vertexCount = 0;
+    for (int m = 0; m < meshCount; m++) {
+        if (model->meshes[m].rigidBone < 0) vertexCount += model->meshes[m].vertexCount;
+    }
+
+    uintptr_t cursor = base;
+    TakeDMSBlockSpace(&cursor, sizeof(DMSInstance));
+    if (boneCount > 0) {
+        instance->pose.translation = (Vector3*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(Vector3));
+        instance->pose.rotation = (Quaternion*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(Quaternion));
+        instance->pose.scale = (Vector3*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(Vector3));
+        instance->layerPose.translation = (Vector3*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(Vector3));
+        instance->layerPose.rotation = (Quaternion*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(Quaternion));
+        instance->layerPose.scale = (Vector3*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(Vector3));
+        instance->blendWeight = (float*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(float));
+        instance->boneMoved = (uint8_t*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(uint8_t));
+        instance->worldPose = (Matrix*)TakeDMSBlockSpace(&cursor, boneCount * sizeof(Matrix));
+        for (int l = 0; l < DMS_MAX_ANIMATION_LAYERS; l++) {
+            instance->layers[l].trackCursor = (int*)TakeDMSBlockSpace(&cursor,
+                boneCount * DMS_TRACKS_PER_BONE * sizeof(int));
+        }
+    }
+    if (meshCount > 0) {
+        instance->skinnedVertices = (DMSVertex**)TakeDMSBlockSpace(&cursor, meshCount * sizeof(DMSVertex*));
+        *vertices = (DMSVertex*)TakeDMSBlockSpace(&cursor, vertexCount * sizeof(DMSVertex));
+    }
+    return ((cursor + 31) & ~(uintptr_t)31) - base;
+}
+
+// Create an instance in one 32-byte aligned block
+DMSInstance* CreateDMSInstance(DMSModel* model) {
+    if (!model) return NULL;
+
+    DMSInstance measure = { 0 };
+    DMSVertex* vertices = NULL;
+    uint8_t* block = (uint8_t*)memalign(32, LayoutDMSInstance(&measure, model, 0, &vertices));
+    if (!block) {
+        printf("Out of memory for a DMS instance\n");
+        return NULL;
+    }
+    DMSInstance* instance = (DMSInstance*)block;
+    memset(instance, 0, sizeof(DMSInstance));
+    instance->model = model;
+
+    // Consecutive instances take throttled updates on different frames
+    static uint32_t serial = 0;
+    instance->lod.frame = serial++;
+    LayoutDMSInstance(instance, model, (uintptr_t)block, &vertices);
+
+    // Skinning results start out as the bind pose; rigid meshes have none
+    if (instance->skinnedVertices) {
+        for (int m = 0; m < model->meshCount; m++) {
+            const DMSMesh* mesh = &model->meshes[m];
+            if (mesh->rigidBone >= 0) {
+                instance->skinnedVertices[m] = NULL;
+                continue;
+            }
+            instance->skinnedVertices[m] = vertices;
+            memcpy(vertices, mesh->vertices, mesh->vertexCount * sizeof(DMSVertex));
+            vertices += mesh->vertexCount;
+        }
+    }
+
+    // Bones start in the bind pose
+    int boneCount = model->skeleton ? model->skeleton->boneCount : 0;
+    for (int l = 0; l < DMS_MAX_ANIMATION_LAYERS && boneCount > 0; l++) {
+        memset(instance->layers[l].trackCursor, 0, boneCount * DMS_TRACKS_PER_BONE * sizeof(int));
+    }
+    for (int i = 0; i < boneCount; i++) {
+        instance->pose.translation[i] = model->skeleton->bones[i].bindPose.translation;
+        instance->pose.rotation[i] = model->skeleton->bones[i].bindPose.rotation;
+        instance->pose.scale[i] = model->skeleton->bones[i].bindPose.scale;
+    }
+    if (boneCount > 0) ComposeDMSWorldPoses(model->skeleton, &instance->pose, NULL, instance->worldPose);
+    instance->composedAnim = -1;
+
+    // Bone-space positions go back through the inverted inverse bind
+    // matrices, so a new instance shows the mesh as it was bound, like a
+    // model-space mesh does, until its first skinning pass
+    int boneSpace = 0;
+    for (int m = 0; m < model->meshCount && instance->skinnedVertices; m++) {
+        boneSpace |= model->meshes[m].boneSpace && model->meshes[m].rigidBone < 0;
+    }
+    if (boneSpace) {
+        Matrix* bindPalette = (Matrix*)malloc(boneCount * sizeof(Matrix));
+        if (!bindPalette) {
+            printf("Out of memory for a DMS instance\n");
+            free(block);
+            return NULL;
+        }
+        for (int i = 0; i < boneCount; i++) {
+            InvertDMSAffine(&model->skeleton->bones[i].inverseBindMatrix, &bindPalette[i]);
+        }
+        SkinDMSModel(model, bindPalette, instance->skinnedVertices);
+        free(bindPalette);
+    }
+
+    SetDMSInstanceAnimation(instance, 0);
+    return instance;
+}
+
+void DestroyDMSInstance(DMSInstance* instance) {
+    if (!instance) return;
+    while (instance->layerCount > 0) {
+        RemoveDMSAnimationLayer(instance, instance->layerCount - 1);
+    }
+    ReleaseDMSAnimationResult(instance);
+    free(instance);
+}
+
+// Points a layer at a clip, from its start. Users keep a lazy clip in the
+// clip cache.
+static void StartDMSAnimationLayer(DMSSkeleton* skeleton, DMSAnimationLayer* layer, int animIndex, float weight,
+                                   const float* boneMask) {
+    skeleton->animations[animIndex].users++;
+    layer->anim = animIndex;
+    layer->time = 0.0f;
+    layer->weight = weight;
+    layer->fadeRate = 0.0f;
+    layer->boneMask = boneMask;
+    AcquireDMSClip(skeleton, animIndex);
+}
+
+// Set the animation an instance plays
+int SetDMSInstanceAnimation(DMSInstance* instance, int animIndex) {
+    if (!instance || !instance->model->skeleton) return 0;
     
-    if (animIndex >= 0 && animIndex < model->skeleton->animCount) {
-        model->skeleton->currentAnim = animIndex;
-        model->skeleton->currentTime = 0.0f;
+    DMSSkeleton* skeleton = instance->model->skeleton;
+    if (animIndex >= 0 && animIndex < skeleton->animCount) {
+        while (instance->layerCount > 0) {
+            RemoveDMSAnimationLayer(instance, instance->layerCount - 1);
+        }
+        StartDMSAnimationLayer(skeleton, &instance->layers[0], animIndex, 1.0f, NULL);
+        instance->layerCount = 1;
         return 1;
     }
     
     return 0;
 }
 
+// Fade a new animation in over the ones playing
+int CrossFadeDMSInstanceAnimation(DMSInstance* instance, int animIndex, float duration) {
+    if (!instance || !instance->model->skeleton) return 0;
+    if (animIndex < 0 || animIndex >= instance->model->skeleton->animCount) return 0;
+    if (duration <= 0.0f || instance->layerCount == 0) return SetDMSInstanceAnimation(instance, animIndex);
+
+    // Everything playing fades out over the same time; layers without
+    // weight have nothing to fade
+    for (int l = instance->layerCount - 1; l >= 0; l--) {
+        if (instance->layers[l].weight <= 0.0f) {
+            RemoveDMSAnimationLayer(instance, l);
+        } else {
+            instance->layers[l].fadeRate = -instance->layers[l].weight / duration;
+        }
+    }
+    if (instance->layerCount == DMS_MAX_ANIMATION_LAYERS) {
+        RemoveDMSAnimationLayer(instance, instance->layerCount - 1);
+    }
+    if (instance->layerCount == 0) return SetDMSInstanceAnimation(instance, animIndex);
+
+    // The new clip goes first, with the free slot's cursors
+    int* trackCursor = instance->layers[instance->layerCount].trackCursor;
+    memmove(&instance->layers[1], &instance->layers[0], instance->layerCount * sizeof(DMSAnimationLayer));
+    instance->layers[0].trackCursor = trackCursor;
+    instance->layerCount++;
+    StartDMSAnimationLayer(instance->model->skeleton, &instance->layers[0], animIndex, 0.0f, NULL);
+    instance->layers[0].fadeRate = 1.0f / duration;
+    return 1;
+}
+
+// Set or remove one layer of an instance's blend
+int SetDMSInstanceLayer(DMSInstance* instance, int layer, int animIndex, float weight, const float* boneMask) {
+    if (!instance || !instance->model->skeleton) return 0;
+    if (layer < 0 || layer > instance->layerCount || layer >= DMS_MAX_ANIMATION_LAYERS) return 0;
+
+    DMSSkeleton* skeleton = instance->model->skeleton;
+    if (animIndex < 0) {
+        if (layer == instance->layerCount) return 0;
+        RemoveDMSAnimationLayer(instance, layer);
+        return 1;
+    }
+    if (animIndex >= skeleton->animCount) return 0;
+
+    DMSAnimationLayer* slot = &instance->layers[layer];
+    if (layer == instance->layerCount) {
+        instance->layerCount++;
+    } else if (slot->anim == animIndex) {
+        // Same clip: keep its time
+        slot->weight = weight;
+        slot->fadeRate = 0.0f;
+        slot->boneMask = boneMask;
+        return 1;
+    } else {
+        skeleton->animations[slot->anim].users--;
+    }
+    StartDMSAnimationLayer(skeleton, slot, animIndex, weight, boneMask);
+    return 1;
+}
+
+// Set the blend weight of a layer
+void SetDMSInstanceLayerWeight(DMSInstance* instance, int layer, float weight) {
+    if (!instance || layer < 0 || layer >= instance->layerCount) return;
+    instance->layers[layer].weight = weight;
+    instance->layers[layer].fadeRate = 0.0f;
+}
+
+// Load a clip ahead of its first use
+int PrefetchDMSModelAnimation(DMSModel* model, int animIndex) {
+    if (!model || !model->skeleton) return 0;
+    if (animIndex < 0 || animIndex >= model->skeleton->animCount) return 0;
+    return AcquireDMSClip(model->skeleton, animIndex)->tracks != NULL;
+}
+
 // Get the number of animations in a DMS model
 int GetDMSModelAnimationCount(DMSModel* model) {
     if (!model || !model->skeleton) return 0;
@@ -493,8 +2007,90 @@ const char* GetDMSModelAnimationName(DMSModel* model, int animIndex) {
     return NULL;
 }
 
-// Get the current animation playing on a DMS model
-int GetDMSModelCurrentAnimation(DMSModel* model) {
-    if (!model || !model->skeleton) return -1;
-    return model->skeleton->currentAnim;
+// Set the LOD levels every instance picks from
+void SetDMSAnimationLODs(const DMSAnimationLOD* levels, int count) {
+    if (!levels || count <= 0) return;
+    if (count > DMS_MAX_ANIMATION_LODS) count = DMS_MAX_ANIMATION_LODS;
+    // Spare slots repeat the last level, for instances picked under the old table
+    for (int i = 0; i < DMS_MAX_ANIMATION_LODS; i++) {
+        dmsLODs[i] = levels[i < count ? i : count - 1];
+        if (dmsLODs[i].updateInterval < 1) dmsLODs[i].updateInterval = 1;
+    }
+    dmsLODCount = count;
+}
+
+// Bind pose bounds grow by this much to cover animated poses
+#define DMS_LOD_BOUNDS_PADDING 1.5f
+
+// Pick an instance's LOD level from its size on screen; -1 when off screen
+int UpdateDMSInstanceLOD(DMSInstance* instance, Matrix transform, Matrix viewProjection) {
+    if (!instance) return -1;
+
+    const DMSModel* model = instance->model;
+    if (model->boundsRadius <= 0.0f) {
+        instance->lod.level = 0;
+        return 0;
+    }
+
+    // Bounding sphere in world space; scaled by the transform's largest axis
+    Vector3 center = Vector3Transform(model->boundsCenter, transform);
+    float scaleX = transform.m0 * transform.m0 + transform.m1 * transform.m1 + transform.m2 * transform.m2;
+    float scaleY = transform.m4 * transform.m4 + transform.m5 * transform.m5 + transform.m6 * transform.m6;
+    float scaleZ = transform.m8 * transform.m8 + transform.m9 * transform.m9 + transform.m10 * transform.m10;
+    float scaleSq = scaleX > scaleY ? scaleX : scaleY;
+    if (scaleZ > scaleSq) scaleSq = scaleZ;
+    float radius = model->boundsRadius * sqrtf(scaleSq) * DMS_LOD_BOUNDS_PADDING;
+
+    // Clip space rows, then the frustum planes w+x, w-x, w+y, w-y, w+z, w-z
+    const Matrix* m = &viewProjection;
+    float rows[4][4] = {
+        { m->m0, m->m4, m->m8, m->m12 },
+        { m->m1, m->m5, m->m9, m->m13 },
+        { m->m2, m->m6, m->m10, m->m14 },
+        { m->m3, m->m7, m->m11, m->m15 },
+    };
+    for (int p = 0; p < 6; p++) {
+        const float* row = rows[p / 2];
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        float a = rows[3][0] + sign * row[0];
+        float b = rows[3][1] + sign * row[1];
+        float c = rows[3][2] + sign * row[2];
+        float d = rows[3][3] + sign * row[3];
+        float distance = a * center.x + b * center.y + c * center.z + d;
+        if (distance < -radius * sqrtf(a * a + b * b + c * c)) {
+            instance->lod.level = -1;
+            return -1;
+        }
+    }
+
+    // Sphere height as a fraction of the viewport; spheres around the eye
+    // fill it
+    float w = rows[3][0] * center.x + rows[3][1] * center.y + rows[3][2] * center.z + rows[3][3];
+    float projectionY = sqrtf(rows[1][0] * rows[1][0] + rows[1][1] * rows[1][1] + rows[1][2] * rows[1][2]);
+    float screenHeight = w > radius ? radius * projectionY / w : 1.0f;
+
+    int level = dmsLODCount - 1;
+    for (int i = 0; i < dmsLODCount; i++) {
+        if (screenHeight >= dmsLODs[i].minScreenHeight) {
+            level = i;
+            break;
+        }
+    }
+    instance->lod.level = level;
+    return level;
+}
+
+// Zero an instance's LOD counters
+void ResetDMSInstanceLODStats(DMSInstance* instance) {
+    if (!instance) return;
+    instance->lod.updates = 0;
+    instance->lod.updatesSkipped = 0;
+    instance->lod.skinningPasses = 0;
+    instance->lod.skinningSkipped = 0;
+}
+
+// Get the animation an instance plays
+int GetDMSInstanceAnimation(const DMSInstance* instance) {
+    if (!instance || instance->layerCount == 0) return -1;
+    return instance->layers[0].anim;
 }
\ No newline at end of file
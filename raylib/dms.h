@@ -5,10 +5,43 @@
 #include <raymath.h>
 #include <GL/gl.h>
 #include <stdint.h>
+#include <stddef.h>
 
 // DMS File Format Magic Number ("DMST" in hex)
 #define DMS_MAGIC_NUMBER 0x54534D44
 
+// Chunk types of DMS v6. The header (magic, version, meshCount, boneCount,
+// chunkCount) is followed by chunkCount DMSChunk entries; every chunk starts
+// on a multiple of its alignment and unknown types are skipped.
+#define DMS_CHUNK_SKELETON  0x4C454B53  // "SKEL": boneCount bones
+#define DMS_CHUNK_ANIMATION 0x4D494E41  // "ANIM": one clip
+#define DMS_CHUNK_MATERIALS 0x4C54414D  // "MATL": texture count, then 64-byte names
+#define DMS_CHUNK_BOUNDS    0x53444E42  // "BNDS": per mesh min, max, sphere center, radius
+#define DMS_CHUNK_MESH      0x4853454D  // "MESH": one mesh
+
+typedef struct {
+    uint32_t type;
+    uint32_t offset;        // From the start of the file
+    uint32_t size;
+    uint32_t alignment;
+} DMSChunk;
+
+// BNDS chunk record, one per mesh, in bind pose
+typedef struct {
+    Vector3 min, max;
+    Vector3 center;         // Bounding sphere
+    float radius;
+} DMSMeshBounds;
+
+// Sections LoadDMSModelSections() reads from a v6 file
+enum {
+    DMS_LOAD_SKELETON   = 1 << 0,
+    DMS_LOAD_ANIMATIONS = 1 << 1,   // Only together with the skeleton
+    DMS_LOAD_MESHES     = 1 << 2,
+    DMS_LOAD_ALL        = DMS_LOAD_SKELETON | DMS_LOAD_ANIMATIONS | DMS_LOAD_MESHES,
+    DMS_LOAD_ALL_CLIPS  = 1 << 3    // Read every clip now instead of on first use
+};
+
 // DMS Transform structure
 typedef struct {
     Vector3 translation;
@@ -16,23 +49,59 @@ typedef struct {
     Vector3 scale;
 } DMSTransform;
 
+// Animation encodings of DMS v3
+enum {
+    DMS_ANIM_ENCODING_FLOAT,
+    DMS_ANIM_ENCODING_QUANTIZED
+};
+
+// Track order within a bone
+enum {
+    DMS_TRACK_TRANSLATION,
+    DMS_TRACK_ROTATION,
+    DMS_TRACK_SCALE,
+    DMS_TRACKS_PER_BONE
+};
+
 // DMS Bone structure
 typedef struct {
     char name[64];
     int parent;
     DMSTransform bindPose;
-    DMSTransform localPose;
-    Matrix worldPose;
     Matrix inverseBindMatrix;
+    int depth;              // Ancestors above the bone
 } DMSBone;
 
+// DMS Animation track: keyCount keys at times[] (seconds), values packed as
+// 3 floats (translation, scale) or 4 floats (rotation quaternion) per key.
+// Quantized clips keep ticks[] of the clip's timeStep and three 16-bit
+// words per key instead.
+typedef struct {
+    int keyCount;
+    float* times;           // Float clips
+    float* values;
+    uint16_t* ticks;        // Quantized clips: keyCount ticks, then 3 words per key
+} DMSTrack;
+
 // DMS Animation structure
 typedef struct {
     char name[32];
     int boneCount;
-    int frameCount;
+    int frameCount;         // Frames sampled from the source clip
     float duration;
-    DMSTransform** framePoses;
+    DMSTrack* tracks;       // DMS_TRACKS_PER_BONE per bone
+    float* keyData;         // Float clips: storage behind every track's times/values
+    uint16_t* keyWords;     // Quantized clips: storage behind every track
+    float timeStep;         // Quantized clips: seconds per tick
+    Vector3 translationMin; // Quantized clips: value = min + word * step
+    Vector3 translationStep;
+    Vector3 scaleMin;
+    Vector3 scaleStep;
+    uint32_t fileOffset;    // Lazy clips: ANIM chunk to load the keys from
+    uint32_t lastUse;       // Lazy clips: clip cache clock at the last use
+    uint32_t residentBytes; // Lazy clips: bytes held while the keys are loaded
+    int users;              // Instances playing the clip, which keep it loaded
+    int loadFailed;         // Lazy clips: the keys could not be read; not retried
 } DMSAnimation;
 
 // DMS Skeleton structure
@@ -41,8 +110,8 @@ typedef struct {
     int boneCount;
     DMSAnimation* animations;
     int animCount;
-    int currentAnim;
-    float currentTime;
+    char* clipSource;       // File lazy clips load from; NULL when every clip is resident
+    uint32_t clipVersion;   // DMS version of clipSource
 } DMSSkeleton;
 
 // DMS Vertex structure (32 bytes total)
@@ -56,17 +125,95 @@ typedef struct {
     float boneWeight;       // Bone weight (4 bytes)
 } DMSVertex;
 
+// Vertex layouts of DMS v4 meshes
+enum {
+    DMS_VERTEX_FORMAT_FLOAT,
+    DMS_VERTEX_FORMAT_PACKED
+};
+
+// Flag over the layout (strippy --bone-space): weighted positions are stored
+// in their bone's space, so skinning applies only the bone's world pose
+#define DMS_VERTEX_BONE_SPACE 0x100
+
+// Flag over the layout (strippy --rigid-parts): every vertex follows the bone
+// of the first one, so the mesh is drawn through that bone's world pose and
+// never skinned. Comes with DMS_VERTEX_BONE_SPACE.
+#define DMS_VERTEX_RIGID 0x200
+
+// Packed vertex of DMS v4 (16 bytes). Positions are 16-bit fixed point
+// around the center of the mesh's bounds, UVs cover the mesh's UV range.
+typedef struct {
+    int16_t x, y, z;        // positionOffset + xyz * positionScale
+    int8_t nx, ny, nz;      // Normal * 127
+    uint8_t boneId;
+    uint16_t u, v;          // uvOffset + uv * uvScale
+    uint16_t boneWeight;    // Weight * 65535
+} DMSPackedVertex;
+
 // DMS Mesh structure
 typedef struct {
-    DMSVertex* vertices;       // Bind-pose data
-    DMSVertex* animatedVertices; // CPU-skinned results
-    unsigned int* indices;
+    DMSVertex* vertices;       // Bind-pose data; weighted positions in bone space when boneSpace is set
+    void* indices;             // Strip indices in strip table order, then a triangle list
+    uint32_t* stripLengths;    // Strip table: indices per strip
+    int stripCount;
+    int stripIndexCount;       // Indices covered by the strip table
+    int indexSize;             // Bytes per index: 2, or 4 for meshes over 65536 vertices
     int vertexCount;
     int indexCount;
     unsigned int triangleCount;
     int textureId;
+    int boneSpace;             // Vertex format had DMS_VERTEX_BONE_SPACE
+    int rigidBone;             // Bone of a DMS_VERTEX_RIGID mesh, else -1
 } DMSMesh;
 
+// In-place image (strippy --image). Read whole into one block, or used where
+// it lies; tables hold offsets from the start of the image, and vertex
+// arrays start on 32-byte boundaries.
+#define DMS_IMAGE_MAGIC   0x49534D44  // "DMSI"
+#define DMS_IMAGE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // Image bytes
+    uint32_t meshCount, boneCount, animCount, textureCount;
+    uint32_t trackCount;            // Tracks of all clips together
+    uint32_t skinnedVertexCount;    // Vertices of skinned meshes that are not rigid
+    uint32_t packedVertexCount;     // Vertices of packed meshes
+} DMSImageHeader;
+
+typedef struct {
+    uint32_t vertexCount, indexCount;
+    int32_t textureId;
+    uint32_t vertexFormat;
+    uint32_t stripCount, indexSize, stripIndexCount, triangleCount;
+    uint32_t vertices;              // Offset of DMSVertex or DMSPackedVertex[vertexCount]
+    uint32_t stripLengths;          // Offset of uint32_t[stripCount]
+    uint32_t indices;               // Offset of indexCount indices of indexSize bytes
+    Vector3 positionOffset, positionScale;  // Packed meshes
+    float uvOffset[2], uvScale[2];
+    Vector3 center;                 // Bounding sphere
+    float radius;
+} DMSImageMesh;
+
+typedef struct {
+    char name[64];
+    int32_t parent;
+    DMSTransform bindPose;
+    Matrix inverseBindMatrix;
+} DMSImageBone;
+
+typedef struct {
+    char name[32];
+    int32_t boneCount, frameCount;
+    float duration;
+    uint32_t encoding;
+    float timeStep;                 // Quantized clips
+    Vector3 translationMin, translationStep, scaleMin, scaleStep;
+    uint32_t dataCount;             // 32-bit words of float clips, 16-bit words of quantized ones
+    uint32_t data;                  // Offset: per track keyCount, times, values, or quantized words
+} DMSImageClip;
+
 // DMS Model structure
 typedef struct {
     DMSMesh* meshes;
@@ -74,8 +221,97 @@ typedef struct {
     DMSSkeleton* skeleton;
     Texture2D* textures;
     int textureCount;
+    const uint8_t* image;   // In-place image the model points into; NULL for .dms streams
+    Vector3 boundsCenter;   // Bounding sphere of every mesh in bind pose
+    float boundsRadius;
 } DMSModel;
 
+// Most clips an instance blends at once
+#define DMS_MAX_ANIMATION_LAYERS 4
+
+// Local bone transforms, one array per channel with an entry per bone
+typedef struct {
+    Vector3* translation;
+    Quaternion* rotation;
+    Vector3* scale;
+} DMSPose;
+
+// A clip feeding an instance's pose. Each bone gets the weighted average of
+// the layers, weighted by weight * boneMask[bone].
+typedef struct {
+    int anim;
+    float time;
+    float weight;
+    float fadeRate;         // Weight change per second; layers that fade out to 0 are dropped
+    const float* boneMask;  // Per-bone weight factors, owned by the caller; NULL for all 1
+    int* trackCursor;       // Last key sampled per track, DMS_TRACKS_PER_BONE per bone
+} DMSAnimationLayer;
+
+// Bone palette and skinned vertices of one step of a clip, shared by every
+// instance in that step while the animation cache is on
+typedef struct {
+    const DMSModel* model;
+    int anim;
+    int step;                       // Clip time / cache step
+    int maxBoneDepth;               // LOD the pose was sampled at
+    int users;                      // Instances showing these results
+    int skinned;                    // skinnedVertices match worldPose
+    uint32_t lastUse;
+    Matrix* worldPose;              // One per bone
+    DMSVertex** skinnedVertices;    // Per mesh, NULL for rigid ones
+} DMSAnimationResult;
+
+// Animation cache counters since the last reset
+typedef struct {
+    uint32_t poseHits;              // Instance updates that reused a pose
+    uint32_t poseMisses;            // Instance updates that sampled and composed one
+    uint32_t skinningHits;          // Skinning calls served by shared vertices
+    uint32_t skinningMisses;        // Skinning passes run
+    int resultCount;                // Results allocated
+    size_t resultBytes;
+} DMSAnimationCacheStats;
+
+// Animation LOD level. An instance uses the first level whose
+// minScreenHeight its projected height reaches.
+typedef struct {
+    float minScreenHeight;  // Fraction of the viewport height
+    int updateInterval;     // Frames per animation update; 1 updates every frame
+    int maxBoneDepth;       // Deeper bones hold their bind pose; -1 samples every bone
+} DMSAnimationLOD;
+
+#define DMS_MAX_ANIMATION_LODS 8
+
+// Animation LOD state of an instance, and the work it saved
+typedef struct {
+    int level;              // From UpdateDMSInstanceLOD(); -1 while off-screen
+    uint32_t frame;         // Update calls, offset per instance to stagger throttled updates
+    float pendingTime;      // Time skipped updates still owe the clips
+    int poseChanged;        // The pose moved since the last skinning pass
+    uint32_t updates;       // Animation updates run
+    uint32_t updatesSkipped;
+    uint32_t skinningPasses;
+    uint32_t skinningSkipped;
+} DMSAnimationLODState;
+
+// One animated copy of a model. Meshes, bones and clips stay in the shared
+// DMSModel; an instance owns only its pose and skinning results, in a
+// single allocation.
+typedef struct {
+    DMSModel* model;
+    DMSPose pose;                   // Blended local pose
+    Matrix* worldPose;              // One per bone
+    DMSVertex** skinnedVertices;    // Per mesh, NULL for rigid ones; NULL for models without a skeleton
+    DMSAnimationResult* result;     // Shared results drawn instead, when the cache is on
+    DMSAnimationLayer layers[DMS_MAX_ANIMATION_LAYERS];    // Current clip first
+    int layerCount;
+    DMSPose layerPose;              // Blend scratch: one layer's samples
+    float* blendWeight;             // Blend scratch: weight summed per bone
+    uint8_t* boneMoved;             // Compose scratch: bones resampled this update
+    int composedAnim;               // Clip pose and worldPose hold on its own, or -1
+    int composedBoneDepth;          // LOD bone depth it was sampled at
+    DMSAnimationLODState lod;
+} DMSInstance;
+
 // Function prototypes
 
 /**
@@ -85,6 +321,24 @@ typedef struct {
  */
 DMSModel* LoadDMSModel(const char* filename);
 
+/**
+ * Load only some sections of a DMS model, e.g. a skeleton and its clips
+ * without meshes. Files before v6 have no chunk table and always load whole.
+ * @param filename Path to the DMS file
+ * @param sections DMS_LOAD_* flags
+ * @return Pointer to loaded DMS model or NULL if loading failed
+ */
+DMSModel* LoadDMSModelSections(const char* filename, uint32_t sections);
+
+/**
+ * Build a model around an in-place image already in memory, e.g. a romdisk
+ * file mapped with fs_mmap(). Only the model's own structs are allocated;
+ * the image is used where it lies and has to outlive the model.
+ * @param image Start of the image
+ * @return Pointer to the DMS model or NULL if the image is not supported or damaged
+ */
+DMSModel* LoadDMSModelImage(const void* image);
+
 /**
  * Load textures for a DMS model
  * @param model Pointer to the DMS model
@@ -95,21 +349,35 @@ DMSModel* LoadDMSModel(const char* filename);
 int LoadDMSTextures(DMSModel* model, const char* basePath, const char* defaultTexture);
 
 /**
- * Update animation for a DMS model
- * @param model Pointer to the DMS model
+ * Create an animated copy of a model, playing its first clip. Any number of
+ * instances share the model's geometry and clips.
+ * @param model Pointer to the DMS model, which has to outlive the instance
+ * @return Pointer to the instance or NULL if model is NULL or memory runs out
+ */
+DMSInstance* CreateDMSInstance(DMSModel* model);
+
+/**
+ * Free an instance; the model is left alone
+ * @param instance Pointer to the instance
+ */
+void DestroyDMSInstance(DMSInstance* instance);
+
+/**
+ * Advance an instance's animation and update its bone poses
+ * @param instance Pointer to the instance
  * @param deltaTime Time elapsed since last update (in seconds)
  */
-void UpdateDMSModelAnimation(DMSModel* model, float deltaTime);
+void UpdateDMSInstanceAnimation(DMSInstance* instance, float deltaTime);
 
 /**
- * Update vertex positions for an animated mesh
- * @param mesh Pointer to the DMS mesh
- * @param skeleton Pointer to the DMS skeleton
+ * Skin every mesh of an instance with its current bone poses
+ * @param instance Pointer to the instance
  */
-void UpdateDMSMeshAnimation(DMSMesh* mesh, const DMSSkeleton* skeleton);
+void UpdateDMSInstanceSkinning(DMSInstance* instance);
 
 /**
- * Render a DMS model
+ * Render a DMS model in its bind pose. Skinned meshes written with
+ * strippy --bone-space only have a bind pose through an instance.
  * @param dmsModel Pointer to the DMS model
  * @param position Position of the model
  * @param scale Scale of the model
@@ -117,6 +385,15 @@ void UpdateDMSMeshAnimation(DMSMesh* mesh, const DMSSkeleton* skeleton);
  */
 void RenderDMSModel(DMSModel* dmsModel, Vector3 position, float scale, Color tint);
 
+/**
+ * Render an instance with its skinning results
+ * @param instance Pointer to the instance
+ * @param position Position of the instance
+ * @param scale Scale of the instance
+ * @param tint Color tint to apply
+ */
+void RenderDMSInstance(const DMSInstance* instance, Vector3 position, float scale, Color tint);
+
 /**
  * Free resources used by a DMS model
  * @param model Pointer to the DMS model to unload
@@ -124,12 +401,43 @@ void RenderDMSModel(DMSModel* dmsModel, Vector3 position, float scale, Color tin
 void UnloadDMSModel(DMSModel* model);
 
 /**
- * Set current animation for a DMS model
- * @param model Pointer to the DMS model
+ * Set the animation an instance plays, from its start, dropping any blend
+ * @param instance Pointer to the instance
  * @param animIndex Index of the animation to play
  * @return 1 if animation was set successfully, 0 otherwise
  */
-int SetDMSModelAnimation(DMSModel* model, int animIndex);
+int SetDMSInstanceAnimation(DMSInstance* instance, int animIndex);
+
+/**
+ * Start an animation from its start and fade it in over `duration` while
+ * the clips playing so far keep running and fade out. When the layers are
+ * full the last one is dropped.
+ * @param instance Pointer to the instance
+ * @param animIndex Index of the animation to play
+ * @param duration Fade time in seconds; 0 switches at once
+ * @return 1 if animation was set successfully, 0 otherwise
+ */
+int CrossFadeDMSInstanceAnimation(DMSInstance* instance, int animIndex, float duration);
+
+/**
+ * Set one layer of an instance's blend, e.g. an upper-body clip masked
+ * over a walk. The layer restarts its clip when the clip changes.
+ * @param instance Pointer to the instance
+ * @param layer Layer index, up to the current layer count
+ * @param animIndex Index of the animation, or -1 to remove the layer
+ * @param weight Blend weight
+ * @param boneMask Per-bone weight factors, which have to outlive the layer; NULL for all 1
+ * @return 1 if the layer was set successfully, 0 otherwise
+ */
+int SetDMSInstanceLayer(DMSInstance* instance, int layer, int animIndex, float weight, const float* boneMask);
+
+/**
+ * Set the blend weight of a layer and stop any fade on it
+ * @param instance Pointer to the instance
+ * @param layer Layer index
+ * @param weight Blend weight
+ */
+void SetDMSInstanceLayerWeight(DMSInstance* instance, int layer, float weight);
 
 /**
  * Get the number of animations in a DMS model
@@ -147,10 +455,85 @@ int GetDMSModelAnimationCount(DMSModel* model);
 const char* GetDMSModelAnimationName(DMSModel* model, int animIndex);
 
 /**
- * Get the current animation playing on a DMS model
+ * Load a clip into the clip cache ahead of SetDMSInstanceAnimation(), e.g.
+ * while the previous clip is still playing. Clips of v6 files are read on
+ * first use unless loaded with DMS_LOAD_ALL_CLIPS; other clips are always
+ * resident. Reading a clip opens and reads the model file synchronously, so
+ * prefetch outside the frame loop: SetDMSInstanceAnimation(),
+ * CrossFadeDMSInstanceAnimation() and SetDMSInstanceLayer() read clips that
+ * are not resident, and UpdateDMSInstanceAnimation() never does. A clip that
+ * fails to load is not tried again.
  * @param model Pointer to the DMS model
- * @return Index of the current animation, or -1 if no animation playing
+ * @param animIndex Index of the animation
+ * @return 1 if the clip is resident, 0 otherwise
+ */
+int PrefetchDMSModelAnimation(DMSModel* model, int animIndex);
+
+/**
+ * Set the RAM budget shared by the lazily loaded clips of every model.
+ * Least recently used clips are dropped once a load goes over it; clips
+ * that are playing stay. Dropped clips are read again on their next use.
+ * @param bytes Budget in bytes, 0 for no limit (the default)
+ */
+void SetDMSClipCacheBudget(size_t bytes);
+
+/**
+ * Get the bytes held by lazily loaded clips of every model
+ * @return Clip cache usage in bytes
+ */
+size_t GetDMSClipCacheUsage(void);
+
+/**
+ * Share pose and skinning results between instances that play the same clip
+ * of the same model within the same `seconds`-long step of it. Instances
+ * then show the pose at the start of their step, and each step is sampled
+ * and skinned once however many instances are in it.
+ * @param seconds Step length, 0 to turn sharing off (the default)
+ */
+void SetDMSAnimationCacheStep(float seconds);
+
+/**
+ * Get the animation cache counters
+ * @return Hits, misses and memory of the animation cache
+ */
+DMSAnimationCacheStats GetDMSAnimationCacheStats(void);
+
+/**
+ * Zero the animation cache hit and miss counters
+ */
+void ResetDMSAnimationCacheStats(void);
+
+/**
+ * Replace the animation LOD levels, ordered from the largest
+ * minScreenHeight down; the last should have 0 to catch everything else.
+ * Instances start at level 0 before their first UpdateDMSInstanceLOD().
+ * @param levels LOD levels, copied
+ * @param count Number of levels, up to DMS_MAX_ANIMATION_LODS
+ */
+void SetDMSAnimationLODs(const DMSAnimationLOD* levels, int count);
+
+/**
+ * Pick an instance's animation LOD from its bounds on screen. Off-screen
+ * instances keep their last pose and catch up on the time when they are
+ * visible again; smaller ones update less often and with fewer bones.
+ * @param instance Pointer to the instance
+ * @param transform Model-to-world transform the instance is drawn with
+ * @param viewProjection World-to-clip matrix of the camera
+ * @return LOD level, or -1 if the instance is off-screen
+ */
+int UpdateDMSInstanceLOD(DMSInstance* instance, Matrix transform, Matrix viewProjection);
+
+/**
+ * Zero an instance's LOD counters
+ * @param instance Pointer to the instance
+ */
+void ResetDMSInstanceLODStats(DMSInstance* instance);
+
+/**
+ * Get the animation an instance plays, or fades in
+ * @param instance Pointer to the instance
+ * @return Index of the first layer's animation, or -1 if no animation playing
  */
-int GetDMSModelCurrentAnimation(DMSModel* model);
+int GetDMSInstanceAnimation(const DMSInstance* instance);
 
 #endif // DMS_H
\ No newline at end of file
@@ -16,14 +16,14 @@ Vector3 modelPosition = { 0.0f, 0.0f, 0.0f };
 int currentAnimIndex = 0;
 float animationTimer = 0.0f;
 
-void updateController(DMSModel* model) {
+void updateController(DMSInstance* instance) {
     // Exit game if START button is pressed
     if (IsGamepadButtonPressed(0, GAMEPAD_BUTTON_MIDDLE_RIGHT)) running = false;
     
     // Cycle animations with A button
     if (IsGamepadButtonPressed(0, GAMEPAD_BUTTON_RIGHT_FACE_DOWN)) {
-        currentAnimIndex = (currentAnimIndex + 1) % GetDMSModelAnimationCount(model);
-        SetDMSModelAnimation(model, currentAnimIndex);
+        currentAnimIndex = (currentAnimIndex + 1) % GetDMSModelAnimationCount(instance->model);
+        SetDMSInstanceAnimation(instance, currentAnimIndex);
     }
 }
 
@@ -54,20 +54,19 @@ int main(int argc, char **argv) {
     Color backgroundColor = BLUE;
     
     // Initialize animation
+    DMSInstance* dragon = CreateDMSInstance(dragonModel);
     if (GetDMSModelAnimationCount(dragonModel) > 0) {
-        SetDMSModelAnimation(dragonModel, currentAnimIndex);
+        SetDMSInstanceAnimation(dragon, currentAnimIndex);
     }
     
     // Main game loop
     while (running) {
-        updateController(dragonModel);
+        updateController(dragon);
         float deltaTime = GetFrameTime();
         
         // Update animation
-        UpdateDMSModelAnimation(dragonModel, deltaTime);
-        for (int i = 0; i < dragonModel->meshCount; i++) {
-            UpdateDMSMeshAnimation(&dragonModel->meshes[i], dragonModel->skeleton);
-        }
+        UpdateDMSInstanceAnimation(dragon, deltaTime);
+        UpdateDMSInstanceSkinning(dragon);
         
         float rotationSpeed = 30.0f;  
         modelPosition.y += rotationSpeed * deltaTime;
@@ -82,7 +81,7 @@ int main(int argc, char **argv) {
         glTranslatef(0.0f, 0.0f, 0.0f);
         glRotatef(modelPosition.y, 0.0f, 1.0f, 0.0f);
        // glScalef(1.0f, 1.0f, 1.0f);
-        RenderDMSModel(dragonModel, (Vector3){0.0f, 0.0f, 0.0f}, 1.0f, WHITE);
+        RenderDMSInstance(dragon, (Vector3){0.0f, 0.0f, 0.0f}, 1.0f, WHITE);
         glPopMatrix();
         
         EndMode3D();
@@ -113,6 +112,7 @@ int main(int argc, char **argv) {
         if (dragonModel->textures[i].id != 0) UnloadTexture(dragonModel->textures[i]);
     }
     
+    DestroyDMSInstance(dragon);
     UnloadDMSModel(dragonModel);
     CloseWindow();
     